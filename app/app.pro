@@ -0,0 +1,31 @@
+QT       += core gui sql
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11
+
+TARGET = jsonlines-editor
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+include(../version.pri)
+include(../core/core.pri)
+
+SOURCES += \
+    appcache.cpp \
+    jsonlineseditor.cpp \
+    main.cpp
+
+HEADERS += \
+    appcache.h \
+    jsonlineseditor.h
+
+FORMS += \
+    jsonlineseditor.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
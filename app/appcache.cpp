@@ -1,10 +1,13 @@
 #include "appcache.h"
+#include "core/tracer.h"
 
 #include <QtSql/QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFileInfo>
+#include <QCryptographicHash>
 #include <QMessageBox>
 
 AppCache::AppCache()
@@ -22,6 +25,8 @@ AppCache::~AppCache()
 
 bool AppCache::init()
 {
+    TraceSpan span("cache open");
+
     QString appCacheDir = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
 
 
@@ -45,6 +50,10 @@ bool AppCache::init()
     }
 
     QSqlQuery query;
+    // Writes append to the WAL file, a commit is one sequential write and
+    // survives a crash of the app (not of the system) without a sync
+    query.exec("PRAGMA journal_mode=WAL");
+    query.exec("PRAGMA synchronous=NORMAL");
     query.exec("CREATE TABLE IF NOT EXISTS _config (_key VARCHAR (50) PRIMARY KEY, value TEXT NOT NULL)");
 
     // query.exec("CREATE TABLE IF NOT EXISTS _cache (_key VARCHAR (32) PRIMARY KEY, value CLOB NOT NULL, filename VARCHAR (150), tm DATETIME DEFAULT current_timestamp)");
@@ -62,8 +71,17 @@ QString AppCache::getCacheDir()
     return this->appCacheDir;
 }
 
+// Parse index of a file, see JsonLinesIndex
+QString AppCache::getIndexFilePath(const QString &filePath)
+{
+    QByteArray key = QCryptographicHash::hash(QFileInfo(filePath).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+    return this->appCacheDir + "/index/" + QString::fromLatin1(key.toHex()) + ".idx";
+}
+
 void AppCache::setLastPath(const QString &path)
 {
+    TraceSpan span("cache query");
+
     QSqlQuery query(this->dbCache);
     query.prepare("INSERT INTO _config(_key, value) VALUES('last_path', :path) ON CONFLICT(_key) DO UPDATE SET value = :path WHERE _key = 'last_path'");
     query.bindValue(":path", path);
@@ -77,6 +95,8 @@ void AppCache::setLastPath(const QString &path)
 
 QString AppCache::getLastPath()
 {
+    TraceSpan span("cache query");
+
     QSqlQuery query(this->dbCache);
     if (query.exec("SELECT value FROM _config WHERE _key = 'last_path' LIMIT 1")) {
         query.first();
@@ -85,6 +105,35 @@ QString AppCache::getLastPath()
     return "";
 }
 
+void AppCache::setConfigValue(const QString &key, const QString &value)
+{
+    TraceSpan span("cache query");
+
+    QSqlQuery query(this->dbCache);
+    query.prepare("INSERT INTO _config(_key, value) VALUES(:key, :value) ON CONFLICT(_key) DO UPDATE SET value = :value WHERE _key = :key");
+    query.bindValue(":key", key);
+    query.bindValue(":value", value);
+    if (!query.exec()) {
+        QMessageBox::critical(nullptr,
+                              "Cannot save value",
+                              QString("Cannot save %1:\n%2").arg(key, query.lastError().databaseText()),
+                              QMessageBox::Ok);
+    }
+}
+
+QString AppCache::getConfigValue(const QString &key, const QString &defaultValue)
+{
+    TraceSpan span("cache query");
+
+    QSqlQuery query(this->dbCache);
+    query.prepare("SELECT value FROM _config WHERE _key = :key LIMIT 1");
+    query.bindValue(":key", key);
+    if (query.exec() && query.first()) {
+        return query.value(0).toString();
+    }
+    return defaultValue;
+}
+
 /*void AppCache::updateCacheRow(const QString &key, const QString &value, const QString &filename)
 {
     QSqlQuery query(this->dbCache);
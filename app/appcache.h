@@ -20,9 +20,12 @@ public:
     bool init();
     QString getCacheFilepath();
     QString getCacheDir();
+    QString getIndexFilePath(const QString &filePath);
 
     void setLastPath(const QString &path);
     QString getLastPath();
+    void setConfigValue(const QString &key, const QString &value);
+    QString getConfigValue(const QString &key, const QString &defaultValue = "");
     // void updateCacheRow(const QString &key, const QString &value, const QString &filename);
     void cleanCache();
 };
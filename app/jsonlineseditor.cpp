@@ -0,0 +1,2266 @@
+#include "jsonlineseditor.h"
+#include "ui_jsonlineseditor.h"
+#include "core/tracer.h"
+
+#include <QMessageBox>
+#include <QFileDialog>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QCryptographicHash>
+#include <QDesktopServices>
+#include <QPushButton>
+#include <QWidget>
+#include <QLayout>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QFutureWatcher>
+#include <QInputDialog>
+#include <QSignalBlocker>
+#include <QSpinBox>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+JsonLinesEditor::JsonLinesEditor(QWidget *parent)
+    : QMainWindow(parent)
+    , ui(new Ui::JsonLinesEditor)
+{
+    QCoreApplication::setApplicationName("JsonLinesEditor");
+    QCoreApplication::setApplicationVersion(APP_VERSION);
+    QCoreApplication::setOrganizationName("CenSync");
+    QCoreApplication::setOrganizationDomain("censync.com");
+
+    ui->setupUi(this);
+
+    // Widget keeps no more lines than the journal ring
+    ui->plainTextJournal->setMaximumBlockCount(Journal::capacity);
+    this->journalTimer.setSingleShot(true);
+    this->journalTimer.setInterval(250);
+    QObject::connect(&this->journalTimer, &QTimer::timeout, this, &JsonLinesEditor::flushJournal);
+
+    this->journalMessage(QString("Starting app: v%1").arg(APP_VERSION));
+
+    this->setWindowTitle(QString("%1 v%2").arg(
+                             QCoreApplication::applicationName(),
+                             QCoreApplication::applicationVersion()));
+
+    ui->centralwidget->setLayout(ui->verticalMainLayout);
+    ui->tabsMainWidget->setParent(ui->centralwidget);
+
+    ui->tabEditor->setLayout(ui->verticaEditorlLayout);
+    ui->tabDuplicates->setLayout(ui->verticalLayoutDuplicates);
+    ui->tabIssues->setLayout(ui->verticalLayoutIssues);
+    ui->tabJournal->setLayout(ui->verticalLayoutJournal);
+    ui->tabsMainWidget->setCurrentIndex(0);
+
+    ui->tableViewFile->setModel(this->model);
+    ui->tableViewFile->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+
+    QObject::connect(ui->tableViewFile->selectionModel(), &QItemSelectionModel::selectionChanged,
+                     this, &JsonLinesEditor::tableSelectionChanged);
+
+    this->loadingProgressBar = new QProgressBar(this);
+    this->loadingProgressBar->setRange(0, 1000);
+    this->loadingProgressBar->setVisible(false);
+    this->loadingCancelButton = new QPushButton("Cancel", this);
+    this->loadingCancelButton->setVisible(false);
+
+    ui->statusbar->addPermanentWidget(this->loadingProgressBar);
+    ui->statusbar->addPermanentWidget(this->loadingCancelButton);
+
+    QObject::connect(this->loadingCancelButton, &QPushButton::clicked, this->model, &JsonLinesModel::cancelLoading);
+    QObject::connect(this->model, &JsonLinesModel::loadingProgress, this, &JsonLinesEditor::loadingProgress);
+    QObject::connect(this->model, &JsonLinesModel::loadingFinished, this, &JsonLinesEditor::loadingFinished);
+
+    // connect(this, &JsonLinesEditor::newJournalMessage, this, &JsonLinesEditor::journalMessage);
+
+
+    QObject::connect(this, &JsonLinesEditor::isFileChangedUpdated, [this](bool isFileChanged) {
+
+        QAction* actionSave = findChild<QAction*>("actionSave");
+        actionSave->setEnabled(isFileChanged);
+
+        QAction* actionSaveAs = findChild<QAction*>("actionSaveAs");
+        actionSaveAs->setEnabled(isFileChanged);
+
+    });
+
+    QObject::connect(this, &JsonLinesEditor::isItemChangedUpdated, [this](bool isItemChanged) {
+        ui->toolButtonSaveItem->setEnabled(isItemChanged);
+    });
+
+    QObject::connect(this, &JsonLinesEditor::openedFileUpdated, [this](QString openedFile) {
+
+        QAction* actionCloseFile = findChild<QAction*>("actionCloseFile");
+        actionCloseFile->setEnabled(!openedFile.isEmpty());
+        ui->toolButton_AddRow->setEnabled(!openedFile.isEmpty());
+
+
+        this->openedFileChanged(openedFile);
+    });
+
+
+
+    if (!appCache->init())
+    {
+        QApplication::exit();
+    }
+
+    if (!this->initDataDirs()) {
+        QApplication::exit();
+    }
+
+    QString journalError;
+    if (!this->journal->startFileSink(this->appCache->getCacheDir() + "/logs/", &journalError)) {
+        QMessageBox::critical(this,
+                              "Cannot save log file",
+                              QString("Cannot save log file: %1").arg(journalError),
+                              QMessageBox::Ok);
+    }
+
+    ui->statusbar->showMessage(QString("Cache loaded: %1").arg(this->appCache->getCacheFilepath()));
+
+    this->backupManager = new BackupManager(this->appCache->getCacheDir() + "/backups/");
+    this->backupManager->setPolicy(this->loadBackupPolicy());
+
+    this->editHistory.setMemoryLimit(this->appCache->getConfigValue("undo_memory_limit", QString::number(EditHistory::defaultMemoryLimit)).toLongLong());
+
+    this->searchIndex = new SearchIndex(this->appCache->getCacheFilepath(), this);
+    QObject::connect(this->searchIndex, &SearchIndex::buildFinished, this, &JsonLinesEditor::searchIndexBuilt);
+
+    QString editLogError;
+    if (!this->editLog.open(&editLogError)) {
+        this->journalMessage(QString("Cannot open edit log: %1").arg(editLogError));
+    }
+
+    // Autosave writes the logged edits in one transaction, the file itself
+    // is only written by a save
+    this->autosaveTimer.setSingleShot(true);
+    this->autosaveTimer.setInterval(1000);
+    QObject::connect(&this->autosaveTimer, &QTimer::timeout, this, &JsonLinesEditor::flushEditLog);
+
+    this->searchTimer.setSingleShot(true);
+    this->searchTimer.setInterval(200);
+    QObject::connect(&this->searchTimer, &QTimer::timeout, this, &JsonLinesEditor::runSearch);
+
+    this->issuesTimer.setSingleShot(true);
+    this->issuesTimer.setInterval(300);
+    QObject::connect(&this->issuesTimer, &QTimer::timeout, this, &JsonLinesEditor::refreshIssues);
+
+    // Writers append in bursts, read them once they pause
+    this->followTimer.setSingleShot(true);
+    this->followTimer.setInterval(300);
+    QObject::connect(&this->followTimer, &QTimer::timeout, this, &JsonLinesEditor::followFile);
+    QObject::connect(&this->fileWatcher, &QFileSystemWatcher::fileChanged, this, [this]() {
+        this->followTimer.start();
+    });
+
+    for (int fields = DuplicateFinder::TermPair; fields <= DuplicateFinder::AllFields; fields++) {
+        ui->comboBoxDuplicateFields->addItem(DuplicateFinder::fieldsName(DuplicateFinder::Fields(fields)), fields);
+    }
+    QObject::connect(this->duplicateFinder, &DuplicateFinder::finished, this, &JsonLinesEditor::duplicatesFound);
+    QObject::connect(this->rowValidator, &RowValidator::finished, this, &JsonLinesEditor::validationFinished);
+    QObject::connect(this->filterModel, &JsonLinesFilterModel::filterFinished, this, &JsonLinesEditor::filterFinished);
+    QObject::connect(this->filterModel, &JsonLinesFilterModel::sortFinished, this, &JsonLinesEditor::sortFinished);
+    // Click sorts by a column, Shift+click adds a column to the sort
+    QObject::connect(ui->tableViewFile->horizontalHeader(), &QHeaderView::sectionClicked, this, &JsonLinesEditor::sortByColumn);
+    ui->actionSaveSorted->setChecked(this->appCache->getConfigValue("save_sorted", "0").toInt() != 0);
+    ui->actionTolerantLoading->setChecked(this->appCache->getConfigValue("tolerant_loading", "0").toInt() != 0);
+    QObject::connect(ui->tabsMainWidget, &QTabWidget::currentChanged, this, [this]() {
+        if (this->isDuplicatesDirty && ui->tabsMainWidget->currentWidget() == ui->tabDuplicates) {
+            this->refreshDuplicates();
+        }
+        if (this->isIssuesDirty && ui->tabsMainWidget->currentWidget() == ui->tabIssues) {
+            this->refreshIssues();
+        }
+    });
+
+    this->lastPath = this->appCache->getLastPath();
+
+    // Once the window is shown
+    QTimer::singleShot(0, this, &JsonLinesEditor::checkForRecovery);
+
+}
+
+JsonLinesEditor::~JsonLinesEditor()
+{
+    delete this->searchIndex;
+    delete this->backupManager;
+    delete this->appCache;
+    delete this->journal;
+    delete ui;
+}
+
+
+void JsonLinesEditor::selectFileAndOpen() {
+   QString fileName;
+
+   if (this->lastPath.isEmpty()) {
+       this->lastPath = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
+   }
+
+   fileName = QFileDialog::getOpenFileName(this, "Open file" , this->lastPath, "All files (*.*);;JSON Lines (*.jsonl);;Compressed JSON Lines (*.jsonl.gz *.jsonl.zst);;JSON (*.json);;Text files (*.txt)");
+
+   if (fileName.isEmpty()) {
+       return;
+   }
+
+   QFileInfo fileInfo(fileName);
+   this->lastPath = fileInfo.absoluteDir().path();
+   this->appCache->setLastPath(this->lastPath);
+
+   this->journalMessage(QString("Try to open file: %1").arg(fileName));
+
+   this->loadEditableFile(fileName);
+   return;
+}
+
+bool JsonLinesEditor::loadEditableFile(const QString &filePath)
+{
+    this->rowsInserted = 0;
+    this->rowsUpdated = 0;
+    this->traceStart = Tracer::now();
+
+    this->editHistory.clear();
+    this->updateUndoActions();
+
+    // Columns of the new file are known once loaded, the filter is parsed again then
+    this->filterModel->setFilter(RowFilter());
+    this->filterModel->setSortColumns(QVector<RowSorter::SortColumn>());
+
+    if (!this->model->startLoading(filePath, this->appCache->getIndexFilePath(filePath))) {
+        this->model->clear();
+
+        QMessageBox::critical(this,
+                              "Cannot open file",
+                              QString("Cannot open file for edit. Error: %1").
+                              arg(this->model->errorString()),
+                              QMessageBox::Ok);
+        return false;
+    }
+
+    this->loadingFilePath = filePath;
+    this->loadingTimer.start();
+    this->setLoadingState(true);
+
+    return true;
+}
+
+void JsonLinesEditor::loadingProgress(qint64 bytesLoaded, qint64 bytesTotal, int rowsLoaded)
+{
+    double seconds = qMax(this->loadingTimer.elapsed(), qint64(1)) / 1000.0;
+
+    this->loadingProgressBar->setValue(bytesTotal > 0 ? int(bytesLoaded * 1000 / bytesTotal) : 1000);
+    this->loadingProgressBar->setFormat(QString("%p% - %1 rows/s, %2 MB/s").
+                                        arg(qRound64(rowsLoaded / seconds)).
+                                        arg(bytesLoaded / seconds / (1024 * 1024), 0, 'f', 1));
+}
+
+void JsonLinesEditor::loadingFinished(int status)
+{
+    QString filePath = this->loadingFilePath;
+    this->loadingFilePath = "";
+
+    if (status == JsonLinesLoader::Loaded) {
+        this->journalMessage(QString("Loaded %1 rows in %2 s: %3").
+                             arg(this->model->rowCount()).
+                             arg(this->loadingTimer.elapsed() / 1000.0, 0, 'f', 2).
+                             arg(filePath));
+
+        if (this->model->cachedRowCount() > 0) {
+            this->journalMessage(QString("Rows from saved index: %1, parsed: %2").
+                                 arg(this->model->cachedRowCount()).
+                                 arg(this->model->rowCount() - this->model->cachedRowCount()));
+        }
+
+        this->journalMessage(QString("Load timings: %1").arg(Tracer::summaryText(this->traceStart)));
+
+        if (this->openedFile() == filePath) {
+            this->openedFileChanged(filePath);
+        } else {
+            this->setOpenedFile(filePath);
+        }
+
+        this->setLoadingState(false);
+        this->tableSelectionChanged();
+        this->rebuildSearchIndex(filePath);
+        this->duplicateFinder->clear();
+        this->refreshDuplicates();
+        this->rowValidator->clear();
+        this->refreshIssues();
+        if (filePath == this->recoveringFilePath) {
+            this->recoveringFilePath = "";
+            this->recoverEdits(filePath);
+        } else {
+            this->startEditLog(filePath);
+        }
+        if (!ui->lineEditFilter->text().trimmed().isEmpty()) {
+            this->applyFilter();
+        }
+
+        // Raw rows are listed with their parse errors in the issues panel
+        QVector<JsonLinesParser::Error> badLines = this->model->badLines();
+        if (!badLines.isEmpty()) {
+            QString message = QString("Kept %1 lines that cannot be parsed as raw rows, first on line %2. Error:%3. File: %4").
+                              arg(badLines.size()).
+                              arg(badLines.first().lineNumber).
+                              arg(badLines.first().message, filePath);
+            this->journalMessage(message);
+            ui->statusbar->showMessage(message);
+
+            this->rowValidator->start(this->model->snapshot());
+            ui->tabsMainWidget->setCurrentWidget(ui->tabIssues);
+            this->refreshIssues();
+        }
+        return;
+    }
+
+    // Edit log is kept for the next start
+    bool isRecovering = filePath == this->recoveringFilePath;
+    if (isRecovering) {
+        this->recoveringFilePath = "";
+    }
+
+    this->searchIndex->cancel();
+    this->duplicateFinder->clear();
+    this->rowValidator->clear();
+    this->model->clear();
+    this->setOpenedFile("");
+    this->setLoadingState(false);
+
+    if (status == JsonLinesLoader::Canceled) {
+        QString message = QString("Loading canceled: %1").arg(filePath);
+        this->journalMessage(message);
+        ui->statusbar->showMessage(message);
+        return;
+    }
+
+    QString error = QString("Cannot parse file: on line %1. Error:%2. File: %3").arg(this->model->errorLine()).arg(this->model->errorString(), filePath);
+    this->journalMessage(error);
+    ui->statusbar->showMessage(error);
+
+    // Nothing to keep from a file that cannot be read
+    if (this->model->isTolerantLoading() || this->model->errorLine() == 0) {
+        QMessageBox::critical(this,
+                              "Cannot parse file",
+                              error + "\n\n" + this->model->errorLineText(),
+                              QMessageBox::Abort);
+        return;
+    }
+
+    QMessageBox::StandardButton answer = QMessageBox::question(this,
+                                        "Cannot parse file",
+                                        error + "\n\n" + this->model->errorLineText() +
+                                        "\n\nLoad the file again and keep the lines that cannot be parsed as raw rows?",
+                                        QMessageBox::Yes|QMessageBox::Abort);
+    if (answer != QMessageBox::Yes) {
+        return;
+    }
+
+    ui->actionTolerantLoading->setChecked(true);
+    if (isRecovering) {
+        this->recoveringFilePath = filePath;
+    }
+    if (!this->loadEditableFile(filePath)) {
+        this->recoveringFilePath = "";
+    }
+}
+
+void JsonLinesEditor::openedFileChanged(const QString &filePath)
+{
+    if (filePath.isEmpty()) {
+        this->setWindowTitle(QString("%1 v%2 - file not selected").arg(
+                                 QCoreApplication::applicationName(),
+                                 QCoreApplication::applicationVersion()));
+
+        this->model->clear();
+
+        ui->tableViewFile->resizeColumnToContents(0);
+        ui->tableViewFile->resizeColumnToContents(1);
+        ui->tableViewFile->horizontalHeader()->setStretchLastSection(true);
+
+
+        this->disableEditor();
+        ui->tableViewFile->setEnabled(false);
+
+        this->searchIndex->cancel();
+        this->searchRows.clear();
+        ui->lineEditSearch->clear();
+        ui->lineEditSearch->setEnabled(false);
+        ui->labelSearch->clear();
+
+        this->filterModel->setFilter(RowFilter());
+        this->filterModel->setSortColumns(QVector<RowSorter::SortColumn>());
+        ui->lineEditFilter->clear();
+        ui->lineEditFilter->setEnabled(false);
+        ui->labelFilter->clear();
+
+        this->duplicateFinder->clear();
+        this->refreshDuplicates();
+        ui->pushButtonFindDuplicates->setEnabled(false);
+
+        this->rowValidator->clear();
+        this->refreshIssues();
+        ui->pushButtonValidate->setEnabled(false);
+
+        this->editHistory.clear();
+        this->updateUndoActions();
+        this->editLog.stop();
+        this->updateFileWatcher();
+    } else {
+        this->rowsInserted = 0;
+        this->rowsUpdated = 0;
+
+        this->setWindowTitle(QString("%1 v%2 - %3").arg(
+                                 QCoreApplication::applicationName(),
+                                 QCoreApplication::applicationVersion(),
+                                 filePath));
+
+        this->journalMessage(QString("Opened %1").arg(filePath));
+
+        ui->tableViewFile->resizeColumnToContents(0);
+        ui->tableViewFile->resizeColumnToContents(1);
+        ui->tableViewFile->horizontalHeader()->setStretchLastSection(true);
+
+
+        ui->tableViewFile->setEnabled(true);
+        ui->lineEditSearch->setEnabled(true);
+        ui->lineEditFilter->setEnabled(true);
+        ui->pushButtonFindDuplicates->setEnabled(!this->model->isLoading());
+        ui->pushButtonValidate->setEnabled(!this->model->isLoading());
+        this->setIsFileChanged(false);
+        this->updateFileWatcher();
+    }
+}
+
+bool JsonLinesEditor::checkForExit()
+{
+    if (this->isFileChanged() || this->isItemChanged()) {
+        QMessageBox::StandardButton confirmExit  = QMessageBox::question(this,
+                                            "Exit confirmation",
+                                            "File contains unsaved changes. Do you want really save file whithout saving?",
+                                            QMessageBox::No|QMessageBox::Yes);
+        if (confirmExit == QMessageBox::No)
+        {
+            this->journalMessage(QString("Program exit without saving: %1").arg(this->openedFile()));
+            return true;
+        }
+
+        this->journalMessage("Cancel exiting program without saving data");
+        return false;
+    }
+    return true;
+}
+
+void JsonLinesEditor::checkForCloseFile()
+{
+    if (this->isFileChanged() || this->isItemChanged()) {
+        QMessageBox::StandardButton confirmCloseFile  = QMessageBox::question(this,
+                                            "Close file confirmation",
+                                            "There are unsaved changes",
+                                            QMessageBox::Save|QMessageBox::Cancel|QMessageBox::Close);
+        if (confirmCloseFile == QMessageBox::Save)
+        {
+            this->saveFile();
+        } else if (confirmCloseFile == QMessageBox::Cancel)  {
+            this->journalMessage(QString("Cancel closing file: %1").arg(this->openedFile()));
+            return;
+        } else if (confirmCloseFile == QMessageBox::Close){
+            this->journalMessage(QString("Close file without saving: %1").arg(this->openedFile()));
+            this->setOpenedFile("");
+           // close
+        }
+    } else {
+        this->journalMessage(QString("Close file unchanged: %1").arg(this->openedFile()));
+        this->setOpenedFile("");
+    }
+
+    // this->model->clear();
+
+    // ui->tableViewFile->setEnabled(false);
+    // this->disableEditor();
+    this->setIsFileChanged(false);
+
+
+    return;
+}
+
+void JsonLinesEditor::on_actionExit_triggered()
+{
+    QApplication::quit();
+}
+
+
+void JsonLinesEditor::on_actionAbout_triggered()
+{
+    QMessageBox::about(this, "About",
+                       QString("%1 by %2: v%3").arg(
+                           QCoreApplication::applicationName(),
+                           QCoreApplication::organizationName(),
+                           QCoreApplication::applicationVersion()));
+}
+
+
+void JsonLinesEditor::on_actionClearCache_triggered()
+{
+    this->searchIndex->cancel();
+    this->appCache->cleanCache();
+    QApplication::quit();
+}
+
+
+void JsonLinesEditor::on_actionSaveTrace_triggered()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, "Save trace", this->lastPath + "/trace.json", "Chrome trace (*.json)");
+
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    if (!Tracer::writeChromeTrace(filePath, &error)) {
+        QMessageBox::critical(this,
+                              "Cannot save trace",
+                              QString("Cannot write file:\n%1\n%2").arg(filePath, error),
+                              QMessageBox::Ok);
+        return;
+    }
+
+    this->journalMessage(QString("Trace saved: %1 (%2 spans)").arg(filePath).arg(Tracer::events().size()));
+}
+
+
+void JsonLinesEditor::on_actionOpen_triggered()
+{
+    this->selectFileAndOpen();
+}
+
+
+void JsonLinesEditor::tableSelectionChanged()
+{
+    int row = this->selectedRow();
+    ui->actionFixLine->setEnabled(false);
+
+    if (row >= 0 && this->model->isRawRow(row)) {
+        // Raw rows are fixed as a whole line, see on_actionFixLine_triggered()
+        this->disableEditor();
+        ui->toolButton_RemoveRow->setEnabled(!this->model->isLoading());
+        ui->actionFixLine->setEnabled(!this->model->isLoading());
+
+        JsonLinesParser::Error badLine = this->model->badLine(row);
+        ui->statusbar->showMessage(QString("Line %1 cannot be parsed: %2").arg(badLine.lineNumber).arg(badLine.message));
+    } else if (row >= 0) {
+        QStringList values = this->model->rowValues(row);
+
+        // Rows can be browsed while loading, but not edited
+        if (this->model->isLoading()) {
+            this->disableEditor();
+        }
+
+        ui->lineEditTerm->setText(values.at(JsonLinesModel::ColumnTerm));
+        ui->lineEditTermOrig->setText(values.at(JsonLinesModel::ColumnTermOrig));
+        ui->plainTextDefinition->setPlainText(values.at(JsonLinesModel::ColumnDefinition));
+        ui->plainTextEditDefinitionOrig->setPlainText(values.at(JsonLinesModel::ColumnDefinitionOrig));
+        ui->lineEditSource->setText(values.at(JsonLinesModel::ColumnSource));
+
+        if (!this->model->isLoading()) {
+            ui->toolButton_RemoveRow->setEnabled(true);
+            this->enableEditor();
+        }
+    } else {
+        ui->toolButton_RemoveRow->setEnabled(false);
+        this->disableEditor();
+    }
+
+    this->resetItemBaseline();
+}
+
+
+void JsonLinesEditor::on_toolButton_TermSearchGoogle_clicked()
+{
+    if (!ui->lineEditTerm->text().trimmed().isEmpty()) {
+        QDesktopServices::openUrl(QUrl(QString("https://google.com/search?q=\"%1\"&lr=lang_ru").arg(ui->lineEditTerm->text())));
+    }
+}
+
+void JsonLinesEditor::on_toolButton_TermOrigSearchGooglech_clicked()
+{
+    if (!ui->lineEditTermOrig->text().trimmed().isEmpty()) {
+        QDesktopServices::openUrl(QUrl(QString("https://google.com/search?q=\"%1\"&lr=lang_en").arg(ui->lineEditTerm->text())));
+
+    }
+}
+
+int JsonLinesEditor::selectedRow() const
+{
+    QModelIndexList rows = ui->tableViewFile->selectionModel()->selectedRows();
+    if (rows.isEmpty()) {
+        return -1;
+    }
+    // Rows of the filter model are mapped to the model's
+    if (ui->tableViewFile->model() == this->filterModel) {
+        return this->filterModel->mapToSource(rows.first()).row();
+    }
+    return rows.first().row();
+}
+
+// Invalid when the row is hidden by the filter
+QModelIndex JsonLinesEditor::viewIndex(int row) const
+{
+    if (ui->tableViewFile->model() == this->filterModel) {
+        return this->filterModel->mapFromSource(this->model->index(row, 0));
+    }
+    return this->model->index(row, 0);
+}
+
+void JsonLinesEditor::selectRow(int row)
+{
+    QModelIndex index = this->viewIndex(row);
+
+    if (!index.isValid()) {
+        ui->statusbar->showMessage(QString("Row %1 is hidden by the filter").arg(row + 1));
+        return;
+    }
+
+    ui->tableViewFile->selectRow(index.row());
+    ui->tableViewFile->scrollTo(index);
+}
+
+// The filter model is shown only while a filter is set
+void JsonLinesEditor::setViewModel(QAbstractItemModel *viewModel)
+{
+    if (ui->tableViewFile->model() == viewModel) {
+        return;
+    }
+
+    int row = this->selectedRow();
+    QItemSelectionModel *oldSelectionModel = ui->tableViewFile->selectionModel();
+
+    ui->tableViewFile->setModel(viewModel);
+    delete oldSelectionModel;
+
+    QObject::connect(ui->tableViewFile->selectionModel(), &QItemSelectionModel::selectionChanged,
+                     this, &JsonLinesEditor::tableSelectionChanged);
+
+    // Still shown: selected again without refilling the editor panel
+    QModelIndex index = row >= 0 ? this->viewIndex(row) : QModelIndex();
+    if (index.isValid()) {
+        QSignalBlocker blocker(ui->tableViewFile->selectionModel());
+        ui->tableViewFile->selectRow(index.row());
+        ui->tableViewFile->scrollTo(index);
+    } else if (row >= 0) {
+        this->tableSelectionChanged();
+    }
+}
+
+// Fields as filled now are unchanged
+void JsonLinesEditor::resetItemBaseline()
+{
+    QLineEdit *lineEdits[] = {ui->lineEditTerm, ui->lineEditTermOrig, ui->lineEditSource};
+    int lineColumns[] = {JsonLinesModel::ColumnTerm, JsonLinesModel::ColumnTermOrig, JsonLinesModel::ColumnSource};
+    for (int i = 0; i < 3; i++) {
+        lineEdits[i]->setModified(false);
+        this->fieldBaselines[lineColumns[i]].length = lineEdits[i]->text().size();
+        this->fieldBaselines[lineColumns[i]].hash = qHash(lineEdits[i]->text());
+    }
+
+    QPlainTextEdit *textEdits[] = {ui->plainTextDefinition, ui->plainTextEditDefinitionOrig};
+    int textColumns[] = {JsonLinesModel::ColumnDefinition, JsonLinesModel::ColumnDefinitionOrig};
+    for (int i = 0; i < 2; i++) {
+        textEdits[i]->document()->setModified(false);
+        this->fieldBaselines[textColumns[i]].length = textEdits[i]->document()->characterCount();
+        this->fieldBaselines[textColumns[i]].hash = qHash(textEdits[i]->toPlainText());
+    }
+
+    this->changedFields = 0;
+    this->setIsItemChanged(false);
+}
+
+// Only the edited field is checked. A field not modified since the baseline
+// is unchanged, a different length is changed, the text is hashed only when
+// the length is the same.
+void JsonLinesEditor::checkFieldChanged(int column)
+{
+    const FieldBaseline &baseline = this->fieldBaselines[column];
+    bool isChanged = false;
+
+    if (column == JsonLinesModel::ColumnDefinition || column == JsonLinesModel::ColumnDefinitionOrig) {
+        QPlainTextEdit *edit = column == JsonLinesModel::ColumnDefinition ? ui->plainTextDefinition : ui->plainTextEditDefinitionOrig;
+        QTextDocument *document = edit->document();
+
+        isChanged = document->isModified() &&
+                    (document->characterCount() != baseline.length || qHash(edit->toPlainText()) != baseline.hash);
+    } else {
+        QLineEdit *edit = column == JsonLinesModel::ColumnTerm ? ui->lineEditTerm :
+                          column == JsonLinesModel::ColumnTermOrig ? ui->lineEditTermOrig : ui->lineEditSource;
+
+        isChanged = edit->isModified() &&
+                    (edit->text().size() != baseline.length || qHash(edit->text()) != baseline.hash);
+    }
+
+    if (isChanged) {
+        this->changedFields |= 1u << column;
+    } else {
+        this->changedFields &= ~(1u << column);
+    }
+
+    this->setIsItemChanged(this->changedFields != 0);
+}
+
+
+
+void JsonLinesEditor::on_lineEditTerm_textChanged()
+{
+    this->checkFieldChanged(JsonLinesModel::ColumnTerm);
+}
+
+
+void JsonLinesEditor::on_lineEditTermOrig_textChanged()
+{
+    this->checkFieldChanged(JsonLinesModel::ColumnTermOrig);
+}
+
+
+void JsonLinesEditor::on_plainTextDefinition_textChanged()
+{
+    this->checkFieldChanged(JsonLinesModel::ColumnDefinition);
+}
+
+
+void JsonLinesEditor::on_plainTextEditDefinitionOrig_textChanged()
+{
+    this->checkFieldChanged(JsonLinesModel::ColumnDefinitionOrig);
+}
+
+
+void JsonLinesEditor::on_lineEditSource_textChanged()
+{
+    this->checkFieldChanged(JsonLinesModel::ColumnSource);
+}
+
+void JsonLinesEditor::enableEditor() {
+    ui->lineEditTerm->setEnabled(true);
+    ui->lineEditTermOrig->setEnabled(true);
+    ui->plainTextDefinition->setEnabled(true);
+    ui->plainTextEditDefinitionOrig->setEnabled(true);
+    ui->lineEditSource->setEnabled(true);
+
+    ui->toolButton_TermSearchGoogle->setEnabled(true);
+    ui->toolButton_TermOrigSearchGooglech->setEnabled(true);
+}
+
+void JsonLinesEditor::disableEditor() {
+    ui->lineEditTerm->clear();
+    ui->lineEditTermOrig->clear();
+    ui->plainTextDefinition->clear();
+    ui->plainTextEditDefinitionOrig->clear();
+    ui->lineEditSource->clear();
+
+    ui->lineEditTerm->setEnabled(false);
+    ui->lineEditTermOrig->setEnabled(false);
+    ui->plainTextDefinition->setEnabled(false);
+    ui->plainTextEditDefinitionOrig->setEnabled(false);
+    ui->lineEditSource->setEnabled(false);
+
+    ui->toolButton_TermSearchGoogle->setEnabled(false);
+    ui->toolButton_TermOrigSearchGooglech->setEnabled(false);
+
+    this->resetItemBaseline();
+}
+
+
+void JsonLinesEditor::setLoadingState(bool isLoading)
+{
+    bool hasFile = !this->openedFile().isEmpty();
+
+    ui->actionOpen->setEnabled(!isLoading);
+    ui->actionCreate->setEnabled(!isLoading);
+    ui->actionCloseFile->setEnabled(!isLoading && hasFile);
+    ui->actionSave->setEnabled(!isLoading && this->isFileChanged());
+    ui->actionSaveAs->setEnabled(!isLoading && this->isFileChanged());
+    ui->toolButton_AddRow->setEnabled(!isLoading && hasFile);
+    ui->tableViewFile->setEnabled(isLoading || hasFile);
+    ui->pushButtonFindDuplicates->setEnabled(!isLoading && hasFile);
+    ui->pushButtonValidate->setEnabled(!isLoading && hasFile);
+
+    if (isLoading) {
+        ui->toolButton_RemoveRow->setEnabled(false);
+        ui->actionFixLine->setEnabled(false);
+        this->disableEditor();
+
+        this->loadingProgressBar->setValue(0);
+        this->loadingProgressBar->setFormat("Loading...");
+    }
+
+    this->loadingProgressBar->setVisible(isLoading);
+    this->loadingCancelButton->setVisible(isLoading);
+
+    this->updateUndoActions();
+}
+
+
+void JsonLinesEditor::on_toolButtonSaveItem_clicked()
+{
+    QString strTerm = ui->lineEditTerm->text().trimmed();
+    QString strTermOrig = ui->lineEditTermOrig->text().trimmed();
+    QString strDefinition = ui->plainTextDefinition->toPlainText().trimmed();
+    QString strDefinitionOrig = ui->plainTextEditDefinitionOrig->toPlainText().trimmed();
+    QString strSource = ui->lineEditSource->text().trimmed();
+
+    QStringList values = {strTerm, strTermOrig, strDefinition, strDefinitionOrig, strSource};
+
+    // Every field is required, all empty ones in one message
+    QStringList emptyFields;
+    for (int column = 0; column < JsonLinesModel::ColumnCount; column++) {
+        if (values.at(column).isEmpty()) {
+            emptyFields.append(this->model->headerData(column, Qt::Horizontal).toString());
+        }
+    }
+
+    if (!emptyFields.isEmpty()) {
+        QMessageBox::warning(this,
+                              "Cannot save item",
+                              QString("Empty fields: %1").arg(emptyFields.join(", ")),
+                              QMessageBox::Ok);
+        return;
+    }
+
+    int row = this->selectedRow();
+    if (row >= 0) {
+        qint64 oldKey = this->model->rowKey(row);
+        QStringList oldValues = this->model->rowValues(row);
+
+        this->editHistory.beginStep("update row");
+        this->editHistory.recordFields(row, oldValues.mid(0, JsonLinesModel::ColumnCount), values);
+        this->endEditStep();
+
+        this->model->setRowValues(row, values);
+        this->searchIndex->updateRow(oldKey, this->model->rowKey(row), values);
+        this->duplicateFinder->updateRow(oldKey, oldValues, this->model->rowKey(row), values);
+        this->duplicatesChanged();
+        this->rowValidator->updateRow(oldKey, this->model->rowKey(row), values);
+        this->issuesChanged();
+
+        this->rowsUpdated++;
+        this->journalMessage(QString("Updated row: \"%1\" / \"%2\"").arg(strTerm, strTermOrig));
+        ui->tableViewFile->scrollTo(this->viewIndex(row));
+    } else {
+        // Insert
+        row = this->model->appendRow(values);
+
+        EditHistory::Edit edit;
+        edit.type = EditHistory::Edit::InsertRow;
+        edit.row = row;
+        edit.content.values = values;
+        this->editHistory.beginStep("insert row");
+        this->editHistory.record(edit);
+        this->endEditStep();
+
+        this->searchIndex->updateRow(this->model->rowKey(row), this->model->rowKey(row), values);
+        this->duplicateFinder->updateRow(this->model->rowKey(row), QStringList(), this->model->rowKey(row), values);
+        this->duplicatesChanged();
+        this->rowValidator->updateRow(this->model->rowKey(row), this->model->rowKey(row), values);
+        this->issuesChanged();
+
+        this->rowsInserted++;
+        this->journalMessage(QString("Insert row: \"%1\" / \"%2\"").arg(strTerm, strTermOrig));
+
+        ui->tableViewFile->scrollTo(this->viewIndex(row));
+    }
+
+    ui->tableViewFile->resizeColumnToContents(0);
+    ui->tableViewFile->resizeColumnToContents(1);
+    ui->tableViewFile->horizontalHeader()->setStretchLastSection(true);
+
+    this->setIsFileChanged(true);
+
+    // Saved values are the new baseline
+    this->resetItemBaseline();
+
+
+    ui->toolButtonSaveItem->setEnabled(false);
+}
+
+bool JsonLinesEditor::saveFile(bool saveAs)
+{
+    if (this->model->rowCount() == 0) {
+        QMessageBox::critical(this,
+                              "Cannot save file",
+                              "Nothing to save: data is empty",
+                              QMessageBox::Ok);
+        return false;
+    }
+
+    // Known only once validated, kept up to date by edits after
+    if (this->rowValidator->hasResult()) {
+        QVector<int> counts = this->rowValidator->checkCounts();
+
+        if (counts.at(RowValidator::EmptyRow) > 0 || counts.at(RowValidator::EmptyField) > 0) {
+            QMessageBox::StandardButton confirm = QMessageBox::question(this,
+                                                                        "Save file",
+                                                                        QString("%1 empty rows will not be saved, %2 fields of other rows are empty. Save anyway?").
+                                                                        arg(counts.at(RowValidator::EmptyRow)).
+                                                                        arg(counts.at(RowValidator::EmptyField)),
+                                                                        QMessageBox::Yes | QMessageBox::Cancel);
+            if (confirm != QMessageBox::Yes) {
+                return false;
+            }
+        }
+    }
+
+    QString filePath = this->openedFile();
+    this->traceStart = Tracer::now();
+
+    if (saveAs || filePath.isEmpty() || filePath == defaultFileUnsaved) {
+        filePath = QFileDialog::getSaveFileName(this, "Open file" , this->lastPath, "All files (*.*);;JSON Lines (*.jsonl);;Compressed JSON Lines (*.jsonl.gz *.jsonl.zst);;JSON (*.json);;Text files (*.txt)");
+
+        if (filePath.isEmpty()) {
+            QMessageBox::critical(this,
+                                  "Cannot save file",
+                                  "File is not selected",
+                                  QMessageBox::Ok);
+            return false;
+        }
+    }
+    QFileInfo fileInfo(filePath);
+
+    if (fileInfo.exists()) {
+        if (!fileInfo.isWritable()) {
+            QMessageBox::critical(this,
+                                  "Cannot save file",
+                                  QString("File is not writable:\n%1").arg("%1", filePath),
+                                  QMessageBox::Ok);
+            return false;
+        }
+
+        if (!this->createFileBackup(filePath))
+        {
+            QMessageBox::warning(this,
+                                  "Cannot create backup for file",
+                                  QString("Cannot create backup for file"),
+                                  QMessageBox::Ok);
+        }
+    }
+
+    // Rows are written in the order shown, the model takes it only once the
+    // file is written
+    QVector<int> order;
+    if (ui->actionSaveSorted->isChecked() && this->filterModel->isSorted()) {
+        order = this->filterModel->sortedRows();
+    }
+
+    if (!this->model->save(filePath, order)) {
+        QMessageBox::critical(this,
+                              "Cannot save file",
+                              QString("Cannot write file:\n%1\n%2").arg(filePath, this->model->errorString()),
+                              QMessageBox::Ok);
+        return false;
+    }
+
+    // The file keeps the sorted order from now on, undo steps refer to the
+    // old row numbers
+    if (!order.isEmpty()) {
+        this->filterModel->setSortColumns(QVector<RowSorter::SortColumn>());
+        this->editHistory.clear();
+        this->updateUndoActions();
+        this->tableSelectionChanged();
+        this->journalMessage("Rows saved in sorted order");
+    }
+
+    JsonLinesModel::SaveStats stats = this->model->saveStats();
+
+    this->journalMessage(QString("Saved file: %1 inserts: %2 updates: %3 copied rows: %4 (%5 MB) encoded rows: %6 raw rows: %7").
+                         arg(filePath).
+                         arg(this->rowsInserted).
+                         arg(this->rowsUpdated).
+                         arg(stats.copiedRows).
+                         arg(stats.copiedBytes / (1024.0 * 1024.0), 0, 'f', 1).
+                         arg(stats.encodedRows).
+                         arg(stats.rawRows));
+    this->journalMessage(QString("Save timings: %1").arg(Tracer::summaryText(this->traceStart)));
+
+    this->rowsInserted = 0;
+    this->rowsUpdated = 0;
+
+    this->setIsFileChanged(false);
+    this->setOpenedFile(filePath);
+
+    // Saved edits are dropped from the log
+    this->startEditLog(filePath);
+
+    // Row keys change with the new file offsets, the search index follows
+    // them unless it is not built yet or too many rows moved
+    if (!this->searchIndex->remapKeys(SearchIndex::stamp(filePath), this->model->savedKeyChanges())) {
+        this->rebuildSearchIndex(filePath);
+    } else if (!order.isEmpty()) {
+        // Matches are kept as row numbers
+        this->runSearch();
+    }
+    if (this->duplicateFinder->hasResult() || this->duplicateFinder->isRunning()) {
+        this->duplicateFinder->start(this->model->snapshot(), this->duplicateFinder->fields());
+    }
+    if (this->rowValidator->hasResult() || this->rowValidator->isRunning()) {
+        this->rowValidator->start(this->model->snapshot());
+    }
+
+    return true;
+}
+
+bool JsonLinesEditor::createFileBackup(const QString &filePath)
+{
+    QFileInfo fileInfo(filePath);
+
+    if (!fileInfo.exists()) {
+        this->journalMessage(QString("Cannot create file backup. File not exist: %1").arg(filePath));
+        return false;
+    }
+
+    QString backupPath;
+    QString error;
+    BackupManager::Method method;
+
+    if (!this->backupManager->createBackup(filePath, &backupPath, &method, &error)) {
+        this->journalMessage(QString("Failed to create backup for: %1, backup path: %2. Error: %3").arg(filePath, backupPath, error));
+        return false;
+    }
+
+    this->journalMessage(QString("Backup saved (%1): %2").arg(BackupManager::methodName(method), backupPath));
+
+    this->pruneBackups(BackupManager::backupBaseName(filePath));
+
+    return true;
+}
+
+void JsonLinesEditor::pruneBackups(const QString &baseName)
+{
+    QString backupDir = this->appCache->getCacheDir() + "/backups/";
+    BackupManager::Policy policy = this->backupManager->policy();
+
+    QFutureWatcher<int> *watcher = new QFutureWatcher<int>(this);
+
+    QObject::connect(watcher, &QFutureWatcher<int>::finished, this, [this, watcher]() {
+        int removed = watcher->result();
+        if (removed > 0) {
+            this->journalMessage(QString("Old backups removed: %1").arg(removed));
+        }
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run([backupDir, baseName, policy]() {
+        return BackupManager::prune(backupDir, baseName, policy);
+    }));
+}
+
+BackupManager::Policy JsonLinesEditor::loadBackupPolicy()
+{
+    BackupManager::Policy policy;
+
+    policy.keepCount = this->appCache->getConfigValue("backup_keep_count", QString::number(policy.keepCount)).toInt();
+    policy.keepDays = this->appCache->getConfigValue("backup_keep_days", QString::number(policy.keepDays)).toInt();
+    policy.maxTotalSize = this->appCache->getConfigValue("backup_max_size", QString::number(policy.maxTotalSize)).toLongLong();
+
+    return policy;
+}
+
+void JsonLinesEditor::saveBackupPolicy(const BackupManager::Policy &policy)
+{
+    this->appCache->setConfigValue("backup_keep_count", QString::number(policy.keepCount));
+    this->appCache->setConfigValue("backup_keep_days", QString::number(policy.keepDays));
+    this->appCache->setConfigValue("backup_max_size", QString::number(policy.maxTotalSize));
+}
+
+void JsonLinesEditor::on_actionBackupSettings_triggered()
+{
+    BackupManager::Policy policy = this->backupManager->policy();
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Backup settings");
+
+    QSpinBox *keepCount = new QSpinBox(&dialog);
+    keepCount->setRange(0, 10000);
+    keepCount->setSpecialValueText("Unlimited");
+    keepCount->setValue(policy.keepCount);
+
+    QSpinBox *keepDays = new QSpinBox(&dialog);
+    keepDays->setRange(0, 3650);
+    keepDays->setSpecialValueText("Unlimited");
+    keepDays->setValue(policy.keepDays);
+
+    QSpinBox *maxSize = new QSpinBox(&dialog);
+    maxSize->setRange(0, 1024 * 1024);
+    maxSize->setSuffix(" MB");
+    maxSize->setSpecialValueText("Unlimited");
+    maxSize->setValue(int(policy.maxTotalSize / (1024 * 1024)));
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    QObject::connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    QFormLayout *layout = new QFormLayout(&dialog);
+    layout->addRow("Backups to keep per file:", keepCount);
+    layout->addRow("Keep backups for days:", keepDays);
+    layout->addRow("Total backups size:", maxSize);
+    layout->addRow(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    policy.keepCount = keepCount->value();
+    policy.keepDays = keepDays->value();
+    policy.maxTotalSize = qint64(maxSize->value()) * 1024 * 1024;
+
+    this->backupManager->setPolicy(policy);
+    this->saveBackupPolicy(policy);
+
+    this->journalMessage(QString("Backup policy: keep %1 per file, %2 days, %3 MB total").
+                         arg(policy.keepCount).
+                         arg(policy.keepDays).
+                         arg(policy.maxTotalSize / (1024 * 1024)));
+
+    this->pruneBackups("");
+}
+
+void JsonLinesEditor::on_actionSave_triggered()
+{
+    this->saveFile();
+}
+
+
+void JsonLinesEditor::on_actionCloseFile_triggered()
+{
+    this->checkForCloseFile();
+}
+
+void JsonLinesEditor::journalMessage(const QString &message)
+{
+    this->journal->append(message);
+
+    // Shown in batches, not on every message
+    if (!this->journalTimer.isActive()) {
+        this->journalTimer.start();
+    }
+}
+
+void JsonLinesEditor::flushJournal()
+{
+    QVector<Journal::Entry> entries = this->journal->entriesAfter(this->journalShownId);
+
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    QStringList lines;
+    lines.reserve(entries.size() + 1);
+
+    if (entries.first().id > this->journalShownId + 1) {
+        lines.append(QString("... %1 entries not shown").arg(entries.first().id - this->journalShownId - 1));
+    }
+    for (const Journal::Entry &entry : entries) {
+        lines.append(entry.text());
+    }
+
+    this->journalShownId = entries.last().id;
+
+    ui->plainTextJournal->appendPlainText(lines.join('\n'));
+
+    QTextCursor cursor = ui->plainTextJournal->textCursor();
+    cursor.movePosition(QTextCursor::End);
+    ui->plainTextJournal->setTextCursor(cursor);
+}
+
+bool JsonLinesEditor::initDataDirs()
+{
+    QString appCacheDir = this->appCache->getCacheDir();
+
+    if (!QDir(appCacheDir).exists()) {
+        if (!QDir().mkpath(appCacheDir)) {
+            QMessageBox::critical(this,
+                                  "Cannot create directory",
+                                  QString("Cannot create app cache directory:\n%1").arg("%1", appCacheDir),
+                                  QMessageBox::Abort);
+            return false;
+        }
+    }
+
+    if (!QDir(appCacheDir+"/logs/").exists()) {
+        if (!QDir().mkpath(appCacheDir+"/logs/")) {
+            QMessageBox::critical(this,
+                                  "Cannot create directory",
+                                  QString("Cannot create app logs directory:\n%1").arg("%1", appCacheDir+"/logs/"),
+                                  QMessageBox::Abort);
+            return false;
+        }
+    }
+
+    if (!QDir(appCacheDir+"/backups/").exists()) {
+        if (!QDir().mkpath(appCacheDir+"/backups/")) {
+            QMessageBox::critical(this,
+                                  "Cannot create directory",
+                                  QString("Cannot create app backups directory:\n%1").arg("%1", appCacheDir+"/backups/"),
+                                  QMessageBox::Abort);
+            return false;
+        }
+    }
+
+    if (!QDir(appCacheDir+"/index/").exists()) {
+        if (!QDir().mkpath(appCacheDir+"/index/")) {
+            QMessageBox::critical(this,
+                                  "Cannot create directory",
+                                  QString("Cannot create app index directory:\n%1").arg("%1", appCacheDir+"/index/"),
+                                  QMessageBox::Abort);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void JsonLinesEditor::on_actionSaveAs_triggered()
+{
+    this->saveFile(true);
+}
+
+
+void JsonLinesEditor::on_actionCreate_triggered()
+{
+    this->editHistory.clear();
+    this->updateUndoActions();
+    // Nothing to replay a new file against until it is saved
+    this->editLog.stop();
+
+    this->setOpenedFile(defaultFileUnsaved);
+    this->rebuildSearchIndex("");
+}
+
+
+void JsonLinesEditor::on_toolButton_AddRow_clicked()
+{
+    int row = this->model->appendRow();
+
+    EditHistory::Edit edit;
+    edit.type = EditHistory::Edit::InsertRow;
+    edit.row = row;
+    this->editHistory.beginStep("add row");
+    this->editHistory.record(edit);
+    this->endEditStep();
+
+    // Blank until saved from the editor panel
+    qint64 key = this->model->rowKey(row);
+    this->rowValidator->updateRow(key, key, this->model->rowValues(row));
+    this->issuesChanged();
+
+    this->journalMessage(QString("Added row"));
+    ui->tableViewFile->scrollTo(this->viewIndex(row));
+
+}
+
+
+
+void JsonLinesEditor::on_toolButton_RemoveRow_clicked()
+{
+    int row = this->selectedRow();
+    if (row >= 0) {
+        this->journalMessage(QString("Removed row: %1").arg(this->model->rowValues(row).value(JsonLinesModel::ColumnTerm)));
+
+        EditHistory::Edit edit;
+        edit.type = EditHistory::Edit::RemoveRow;
+        edit.row = row;
+        edit.content = this->model->rowContent(row);
+        this->editHistory.beginStep("remove row");
+        this->editHistory.record(edit);
+        this->endEditStep();
+
+        this->searchIndex->removeRow(this->model->rowKey(row));
+        this->duplicateFinder->removeKeys({this->model->rowKey(row)});
+        this->rowValidator->removeKeys({this->model->rowKey(row)});
+        this->model->removeRow(row);
+        this->duplicatesChanged();
+        this->issuesChanged();
+        this->setIsFileChanged(true);
+    }
+}
+
+void JsonLinesEditor::rebuildSearchIndex(const QString &filePath)
+{
+    this->searchRows.clear();
+    if (!ui->lineEditSearch->text().isEmpty()) {
+        ui->labelSearch->setText("Indexing...");
+    }
+
+    this->searchIndex->rebuild(SearchIndex::stamp(filePath), this->model->snapshot());
+}
+
+void JsonLinesEditor::searchIndexBuilt(bool isBuilt, int rowCount, qint64 elapsedMs)
+{
+    if (!isBuilt) {
+        this->journalMessage(QString("Cannot build search index: %1").arg(this->searchIndex->errorString()));
+        ui->labelSearch->setText("Search unavailable");
+        return;
+    }
+
+    if (elapsedMs > 0) {
+        this->journalMessage(QString("Search index built: %1 rows in %2 s").
+                             arg(rowCount).
+                             arg(elapsedMs / 1000.0, 0, 'f', 2));
+    }
+
+    this->runSearch();
+}
+
+void JsonLinesEditor::on_lineEditSearch_textChanged()
+{
+    this->searchTimer.start();
+}
+
+void JsonLinesEditor::on_lineEditSearch_returnPressed()
+{
+    this->searchTimer.stop();
+
+    if (this->searchRows.isEmpty()) {
+        this->runSearch();
+        return;
+    }
+
+    this->selectSearchMatch(true);
+}
+
+void JsonLinesEditor::runSearch()
+{
+    QString text = ui->lineEditSearch->text().trimmed();
+    this->searchRows.clear();
+
+    if (text.isEmpty()) {
+        ui->labelSearch->clear();
+        return;
+    }
+
+    if (this->searchIndex->isBuilding()) {
+        ui->labelSearch->setText("Indexing...");
+        return;
+    }
+
+    if (!this->searchIndex->isReady()) {
+        ui->labelSearch->setText("Search unavailable");
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    QVector<qint64> keys = this->searchIndex->search(text, &error);
+
+    if (!error.isEmpty()) {
+        ui->labelSearch->setText("Search error");
+        ui->statusbar->showMessage(QString("Search error: %1").arg(error));
+        return;
+    }
+
+    for (qint64 key : keys) {
+        int row = this->model->findRowKey(key);
+        if (row >= 0) {
+            this->searchRows.append(row);
+        }
+    }
+    std::sort(this->searchRows.begin(), this->searchRows.end());
+
+    ui->labelSearch->setText(QString("%1%2 matches, %3 ms").
+                             arg(this->searchRows.size()).
+                             arg(keys.size() >= SearchIndex::maxResults ? QString("+") : QString()).
+                             arg(timer.elapsed()));
+
+    this->selectSearchMatch(false);
+}
+
+// First match after the selected row, or at it unless isNext. Wraps around.
+void JsonLinesEditor::selectSearchMatch(bool isNext)
+{
+    if (this->searchRows.isEmpty()) {
+        return;
+    }
+
+    int current = this->selectedRow();
+    int from = current < 0 ? 0 : current + (isNext ? 1 : 0);
+
+    QVector<int>::const_iterator match = std::lower_bound(this->searchRows.constBegin(), this->searchRows.constEnd(), from);
+    int row = match == this->searchRows.constEnd() ? this->searchRows.first() : *match;
+
+    this->selectRow(row);
+}
+
+void JsonLinesEditor::on_lineEditFilter_returnPressed()
+{
+    this->applyFilter();
+}
+
+void JsonLinesEditor::on_lineEditFilter_textChanged()
+{
+    // Cleared, show every row again
+    if (ui->lineEditFilter->text().trimmed().isEmpty() && !this->filterModel->filter().isEmpty()) {
+        this->applyFilter();
+    }
+}
+
+void JsonLinesEditor::applyFilter()
+{
+    RowFilter filter;
+    QString error;
+
+    if (!filter.parse(ui->lineEditFilter->text(), this->model->keys(), &error)) {
+        ui->labelFilter->setText("Filter error");
+        ui->statusbar->showMessage(QString("Filter error: %1").arg(error));
+        return;
+    }
+
+    if (!filter.isEmpty()) {
+        ui->labelFilter->setText("Filtering...");
+    }
+
+    this->filterModel->setFilter(filter);
+}
+
+void JsonLinesEditor::filterFinished(int matchCount, qint64 elapsedMs)
+{
+    this->setViewModel(this->filterModel->isActive() ? static_cast<QAbstractItemModel *>(this->filterModel) : this->model);
+
+    if (this->filterModel->filter().isEmpty()) {
+        ui->labelFilter->clear();
+        return;
+    }
+
+    ui->labelFilter->setText(QString("%1 of %2 rows, %3 ms").
+                             arg(matchCount).
+                             arg(this->model->rowCount()).
+                             arg(elapsedMs));
+    this->journalMessage(QString("Filter \"%1\": %2 rows in %3 ms").arg(this->filterModel->filter().text()).arg(matchCount).arg(elapsedMs));
+}
+
+void JsonLinesEditor::sortByColumn(int column)
+{
+    if (this->openedFile().isEmpty() || this->model->isLoading()) {
+        return;
+    }
+
+    QVector<RowSorter::SortColumn> columns = this->filterModel->sortColumns();
+    int index = -1;
+    for (int i = 0; i < columns.size(); i++) {
+        if (columns.at(i).column == column) {
+            index = i;
+        }
+    }
+
+    if (QGuiApplication::keyboardModifiers() & Qt::ShiftModifier) {
+        // Added after the columns sorted already, or its order flipped
+        if (index < 0) {
+            RowSorter::SortColumn sortColumn;
+            sortColumn.column = column;
+            columns.append(sortColumn);
+        } else {
+            columns[index].order = columns.at(index).order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+        }
+    } else if (columns.size() == 1 && index == 0) {
+        columns[0].order = columns.at(0).order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+    } else {
+        RowSorter::SortColumn sortColumn;
+        sortColumn.column = column;
+        columns = {sortColumn};
+    }
+
+    ui->statusbar->showMessage("Sorting...");
+    this->filterModel->setSortColumns(columns);
+}
+
+void JsonLinesEditor::sortFinished(qint64 elapsedMs)
+{
+    QHeaderView *header = ui->tableViewFile->horizontalHeader();
+    QVector<RowSorter::SortColumn> columns = this->filterModel->sortColumns();
+
+    this->setViewModel(this->filterModel->isActive() ? static_cast<QAbstractItemModel *>(this->filterModel) : this->model);
+    ui->actionClearSort->setEnabled(!columns.isEmpty());
+
+    if (columns.isEmpty()) {
+        header->setSortIndicatorShown(false);
+        return;
+    }
+
+    header->setSortIndicatorShown(true);
+    header->setSortIndicator(columns.first().column, columns.first().order);
+
+    QStringList names;
+    for (const RowSorter::SortColumn &column : columns) {
+        names.append(QString("%1 %2").
+                     arg(this->model->headerData(column.column, Qt::Horizontal).toString()).
+                     arg(column.order == Qt::AscendingOrder ? "ascending" : "descending"));
+    }
+
+    QString message = QString("Sorted by %1 in %2 ms").arg(names.join(", ")).arg(elapsedMs);
+    this->journalMessage(message);
+    ui->statusbar->showMessage(message);
+}
+
+void JsonLinesEditor::on_actionClearSort_triggered()
+{
+    this->filterModel->setSortColumns(QVector<RowSorter::SortColumn>());
+}
+
+void JsonLinesEditor::on_actionSaveSorted_toggled(bool isChecked)
+{
+    this->appCache->setConfigValue("save_sorted", QString::number(isChecked ? 1 : 0));
+}
+
+// Applies to the next load, rows already loaded stay as they are
+void JsonLinesEditor::on_actionTolerantLoading_toggled(bool isChecked)
+{
+    this->appCache->setConfigValue("tolerant_loading", QString::number(isChecked ? 1 : 0));
+    this->model->setTolerantLoading(isChecked);
+}
+
+// The line is edited as text until it parses, then the raw row is replaced
+// by the parsed one in one undo step
+void JsonLinesEditor::on_actionFixLine_triggered()
+{
+    int row = this->selectedRow();
+    if (row < 0 || this->model->isLoading() || !this->model->isRawRow(row)) {
+        return;
+    }
+
+    JsonLinesParser::Error badLine = this->model->badLine(row);
+    QString text = badLine.lineText;
+    QString error = badLine.message;
+    JsonLinesModel::RowContent content;
+
+    for (;;) {
+        bool isAccepted = false;
+        text = QInputDialog::getMultiLineText(this,
+                                              "Fix line",
+                                              QString("Line %1 cannot be parsed: %2").arg(badLine.lineNumber).arg(error),
+                                              text,
+                                              &isAccepted);
+        if (!isAccepted) {
+            return;
+        }
+        if (JsonLinesModel::parseRowContent(text.toUtf8(), &content, &error)) {
+            break;
+        }
+    }
+
+    EditHistory::Step step;
+    step.name = "fix line";
+
+    EditHistory::Edit removal;
+    removal.type = EditHistory::Edit::RemoveRow;
+    removal.row = row;
+    removal.content = this->model->rowContent(row);
+    step.edits.append(removal);
+
+    EditHistory::Edit insertion;
+    insertion.type = EditHistory::Edit::InsertRow;
+    insertion.row = row;
+    insertion.content = content;
+    step.edits.append(insertion);
+
+    this->editHistory.beginStep(step.name);
+    for (const EditHistory::Edit &edit : step.edits) {
+        this->editHistory.record(edit);
+    }
+    this->endEditStep();
+
+    this->applyEditStep(step, false);
+    this->rowsUpdated++;
+
+    this->journalMessage(QString("Fixed line %1: \"%2\" / \"%3\"").
+                         arg(badLine.lineNumber).
+                         arg(content.values.value(JsonLinesModel::ColumnTerm), content.values.value(JsonLinesModel::ColumnTermOrig)));
+    this->selectRow(row);
+}
+
+void JsonLinesEditor::on_pushButtonFindDuplicates_clicked()
+{
+    DuplicateFinder::Fields fields = DuplicateFinder::Fields(ui->comboBoxDuplicateFields->currentData().toInt());
+
+    this->duplicateFinder->start(this->model->snapshot(), fields);
+
+    ui->treeWidgetDuplicates->clear();
+    ui->labelDuplicates->setText("Hashing rows...");
+    ui->pushButtonKeepSelected->setEnabled(false);
+    ui->pushButtonKeepFirst->setEnabled(false);
+}
+
+void JsonLinesEditor::duplicatesFound(qint64 elapsedMs)
+{
+    this->journalMessage(QString("Duplicates by %1: %2 rows in %3 s").
+                         arg(DuplicateFinder::fieldsName(this->duplicateFinder->fields())).
+                         arg(this->duplicateFinder->duplicateCount()).
+                         arg(elapsedMs / 1000.0, 0, 'f', 2));
+
+    this->refreshDuplicates();
+}
+
+// Panel is refreshed when it is shown, edits only mark it
+void JsonLinesEditor::duplicatesChanged()
+{
+    if (!this->duplicateFinder->hasResult()) {
+        return;
+    }
+
+    if (ui->tabsMainWidget->currentWidget() == ui->tabDuplicates) {
+        this->refreshDuplicates();
+    } else {
+        this->isDuplicatesDirty = true;
+    }
+}
+
+void JsonLinesEditor::refreshDuplicates()
+{
+    this->isDuplicatesDirty = false;
+    ui->treeWidgetDuplicates->clear();
+
+    if (!this->duplicateFinder->hasResult()) {
+        ui->labelDuplicates->setText(this->duplicateFinder->isRunning() ? "Hashing rows..." : "");
+        ui->pushButtonKeepSelected->setEnabled(false);
+        ui->pushButtonKeepFirst->setEnabled(false);
+        return;
+    }
+
+    QVector<DuplicateFinder::Group> groups = this->duplicateFinder->groups();
+    QList<QTreeWidgetItem *> items;
+
+    for (int i = 0; i < groups.size() && i < maxDuplicateGroups; i++) {
+        QVector<int> rows;
+        for (qint64 key : groups.at(i).keys) {
+            int row = this->model->findRowKey(key);
+            if (row >= 0) {
+                rows.append(row);
+            }
+        }
+        if (rows.size() < 2) {
+            continue;
+        }
+        std::sort(rows.begin(), rows.end());
+
+        QStringList first = this->model->rowValues(rows.first());
+        QTreeWidgetItem *groupItem = new QTreeWidgetItem({QString("%1 rows").arg(rows.size()),
+                                                          first.value(JsonLinesModel::ColumnTerm),
+                                                          first.value(JsonLinesModel::ColumnTermOrig),
+                                                          first.value(JsonLinesModel::ColumnDefinition)});
+
+        for (int row : rows) {
+            QStringList values = this->model->rowValues(row);
+            QTreeWidgetItem *rowItem = new QTreeWidgetItem(groupItem, {QString::number(row + 1),
+                                                                       values.value(JsonLinesModel::ColumnTerm),
+                                                                       values.value(JsonLinesModel::ColumnTermOrig),
+                                                                       values.value(JsonLinesModel::ColumnDefinition)});
+            rowItem->setData(0, Qt::UserRole, row);
+        }
+
+        items.append(groupItem);
+    }
+
+    ui->treeWidgetDuplicates->addTopLevelItems(items);
+
+    ui->labelDuplicates->setText(QString("%1 duplicate rows in %2 groups%3").
+                                 arg(this->duplicateFinder->duplicateCount()).
+                                 arg(groups.size()).
+                                 arg(groups.size() > maxDuplicateGroups ? QString(", first %1 shown").arg(maxDuplicateGroups) : QString()));
+
+    ui->pushButtonKeepSelected->setEnabled(!ui->treeWidgetDuplicates->selectedItems().isEmpty());
+    ui->pushButtonKeepFirst->setEnabled(!groups.isEmpty());
+}
+
+void JsonLinesEditor::on_treeWidgetDuplicates_itemSelectionChanged()
+{
+    ui->pushButtonKeepSelected->setEnabled(!ui->treeWidgetDuplicates->selectedItems().isEmpty());
+}
+
+void JsonLinesEditor::on_treeWidgetDuplicates_itemDoubleClicked(QTreeWidgetItem *item, int column)
+{
+    Q_UNUSED(column);
+
+    if (!item->parent()) {
+        return;
+    }
+
+    int row = item->data(0, Qt::UserRole).toInt();
+
+    ui->tabsMainWidget->setCurrentWidget(ui->tabEditor);
+    this->selectRow(row);
+}
+
+void JsonLinesEditor::on_pushButtonKeepSelected_clicked()
+{
+    QList<QTreeWidgetItem *> selected = ui->treeWidgetDuplicates->selectedItems();
+    if (selected.isEmpty()) {
+        return;
+    }
+
+    // Group selected: its first row is kept
+    QTreeWidgetItem *keepItem = selected.first();
+    QTreeWidgetItem *groupItem = keepItem->parent() ? keepItem->parent() : keepItem;
+    if (!keepItem->parent()) {
+        keepItem = groupItem->child(0);
+    }
+
+    QVector<qint64> keys;
+    for (int i = 0; i < groupItem->childCount(); i++) {
+        if (groupItem->child(i) != keepItem) {
+            keys.append(this->model->rowKey(groupItem->child(i)->data(0, Qt::UserRole).toInt()));
+        }
+    }
+
+    this->removeRowKeys(keys);
+}
+
+void JsonLinesEditor::on_pushButtonKeepFirst_clicked()
+{
+    QVector<DuplicateFinder::Group> groups = this->duplicateFinder->groups();
+    QHash<qint64, int> rowKeys = this->model->rowKeyMap();
+    QVector<qint64> keys;
+
+    for (const DuplicateFinder::Group &group : groups) {
+        qint64 firstKey = 0;
+        int firstRow = -1;
+
+        // Keys of removed rows are not in the model
+        for (qint64 key : group.keys) {
+            int row = rowKeys.value(key, -1);
+            if (row >= 0 && (firstRow < 0 || row < firstRow)) {
+                firstRow = row;
+                firstKey = key;
+            }
+        }
+
+        for (qint64 key : group.keys) {
+            if (firstRow >= 0 && key != firstKey) {
+                keys.append(key);
+            }
+        }
+    }
+
+    QMessageBox::StandardButton confirm = QMessageBox::question(this,
+                                                                "Remove duplicates",
+                                                                QString("Remove %1 duplicate rows and keep the first row of every group?").arg(keys.size()),
+                                                                QMessageBox::Yes | QMessageBox::Cancel);
+    if (confirm != QMessageBox::Yes) {
+        return;
+    }
+
+    this->removeRowKeys(keys);
+}
+
+void JsonLinesEditor::on_pushButtonValidate_clicked()
+{
+    this->rowValidator->start(this->model->snapshot());
+
+    ui->treeWidgetIssues->clear();
+    ui->labelIssues->setText("Checking rows...");
+}
+
+void JsonLinesEditor::validationFinished(qint64 elapsedMs)
+{
+    this->journalMessage(QString("Validated %1 rows in %2 s: %3 issues in %4 rows").
+                         arg(this->model->rowCount()).
+                         arg(elapsedMs / 1000.0, 0, 'f', 2).
+                         arg(this->rowValidator->issueCount()).
+                         arg(this->rowValidator->entries().size()));
+
+    this->refreshIssues();
+}
+
+// Panel is refreshed when it is shown, edits only mark it. Edits in a row
+// refresh it once.
+void JsonLinesEditor::issuesChanged()
+{
+    if (!this->rowValidator->hasResult()) {
+        return;
+    }
+
+    if (ui->tabsMainWidget->currentWidget() == ui->tabIssues) {
+        this->issuesTimer.start();
+    } else {
+        this->isIssuesDirty = true;
+    }
+}
+
+void JsonLinesEditor::refreshIssues()
+{
+    this->isIssuesDirty = false;
+    ui->treeWidgetIssues->clear();
+
+    if (!this->rowValidator->hasResult()) {
+        ui->labelIssues->setText(this->rowValidator->isRunning() ? "Checking rows..." : "");
+        return;
+    }
+
+    QVector<RowValidator::Entry> entries = this->rowValidator->entries();
+
+    // Entries in key order until the item limit, the view sorts them
+    QList<QTreeWidgetItem *> items;
+
+    for (const RowValidator::Entry &entry : entries) {
+        if (items.size() >= maxIssueItems) {
+            break;
+        }
+
+        int row = this->model->findRowKey(entry.key);
+        if (row < 0) {
+            continue;
+        }
+
+        QStringList values = this->model->rowValues(row);
+        for (const RowValidator::Issue &issue : RowValidator::issues(entry.issues)) {
+            QString value = values.value(issue.column >= 0 ? issue.column : JsonLinesModel::ColumnTerm);
+
+            if (issue.check == RowValidator::ParseError) {
+                JsonLinesParser::Error badLine = this->model->badLine(row);
+                value = QString("Line %1: %2: %3").arg(badLine.lineNumber).arg(badLine.message, badLine.lineText);
+            }
+
+            QTreeWidgetItem *item = new QTreeWidgetItem();
+            item->setData(0, Qt::DisplayRole, row + 1);
+            item->setData(0, Qt::UserRole, row);
+            item->setData(1, Qt::UserRole, int(issue.check));
+            item->setText(1, RowValidator::checkName(issue.check));
+            item->setText(2, issue.column >= 0 ? this->model->headerData(issue.column, Qt::Horizontal).toString() : QString());
+            item->setText(3, value.left(200).replace('\n', ' '));
+            items.append(item);
+        }
+    }
+
+    ui->treeWidgetIssues->addTopLevelItems(items);
+
+    QVector<int> counts = this->rowValidator->checkCounts();
+    QStringList countTexts;
+    for (int check = 0; check < RowValidator::CheckCount; check++) {
+        if (counts.at(check) > 0) {
+            countTexts.append(QString("%1: %2").arg(RowValidator::checkName(RowValidator::Check(check))).arg(counts.at(check)));
+        }
+    }
+
+    int issueCount = this->rowValidator->issueCount();
+    ui->labelIssues->setText(QString("%1 issues in %2 rows%3%4").
+                             arg(issueCount).
+                             arg(entries.size()).
+                             arg(countTexts.isEmpty() ? QString() : QString(" (%1)").arg(countTexts.join(", "))).
+                             arg(issueCount > items.size() ? QString(", first %1 shown").arg(items.size()) : QString()));
+}
+
+void JsonLinesEditor::on_treeWidgetIssues_itemDoubleClicked(QTreeWidgetItem *item, int column)
+{
+    Q_UNUSED(column);
+
+    int row = item->data(0, Qt::UserRole).toInt();
+
+    ui->tabsMainWidget->setCurrentWidget(ui->tabEditor);
+    this->selectRow(row);
+
+    if (item->data(1, Qt::UserRole).toInt() == RowValidator::ParseError && this->selectedRow() == row) {
+        this->on_actionFixLine_triggered();
+    }
+}
+
+void JsonLinesEditor::removeRowKeys(const QVector<qint64> &keys)
+{
+    if (keys.isEmpty()) {
+        return;
+    }
+
+    QHash<qint64, int> rowKeys = this->model->rowKeyMap();
+    QVector<int> rows;
+    QVector<qint64> foundKeys;
+    for (qint64 key : keys) {
+        int row = rowKeys.value(key, -1);
+        if (row >= 0) {
+            rows.append(row);
+            foundKeys.append(key);
+        }
+    }
+
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    // One undo step, rows removed from the last one so row numbers stay valid
+    std::sort(rows.begin(), rows.end());
+    this->editHistory.beginStep("remove duplicates");
+    for (int i = rows.size() - 1; i >= 0; i--) {
+        EditHistory::Edit edit;
+        edit.type = EditHistory::Edit::RemoveRow;
+        edit.row = rows.at(i);
+        edit.content = this->model->rowContent(rows.at(i));
+        this->editHistory.record(edit);
+    }
+    this->endEditStep();
+
+    this->searchIndex->removeRows(foundKeys);
+    this->duplicateFinder->removeKeys(foundKeys);
+    this->rowValidator->removeKeys(foundKeys);
+    this->model->removeRowList(rows);
+
+    this->journalMessage(QString("Removed duplicate rows: %1").arg(rows.size()));
+
+    this->setIsFileChanged(true);
+    this->tableSelectionChanged();
+    this->refreshDuplicates();
+    this->issuesChanged();
+}
+
+void JsonLinesEditor::endEditStep()
+{
+    EditHistory::Step step;
+    if (!this->editHistory.endStep(&step)) {
+        this->journalMessage(QString("Change is larger than the undo memory limit (%1 MB), undo history cleared").
+                             arg(this->editHistory.memoryLimit() / (1024 * 1024)));
+    }
+
+    // Logged even when too large to undo
+    this->logEdits(step.edits, false);
+    this->updateUndoActions();
+}
+
+void JsonLinesEditor::updateUndoActions()
+{
+    bool isEditable = !this->model->isLoading();
+
+    ui->actionUndo->setEnabled(isEditable && this->editHistory.canUndo());
+    ui->actionUndo->setText(this->editHistory.canUndo() ? QString("Undo %1").arg(this->editHistory.undoName()) : "Undo");
+    ui->actionRedo->setEnabled(isEditable && this->editHistory.canRedo());
+    ui->actionRedo->setText(this->editHistory.canRedo() ? QString("Redo %1").arg(this->editHistory.redoName()) : "Redo");
+}
+
+// Undo runs the edits backwards with old and new swapped. Consecutive row
+// insertions or removals go to the model in one pass, field edits of a row
+// in one setRowValues().
+void JsonLinesEditor::applyEditStep(const EditHistory::Step &step, bool isUndo)
+{
+    int count = step.edits.size();
+    auto editAt = [&step, count, isUndo](int i) -> const EditHistory::Edit & {
+        return step.edits.at(isUndo ? count - 1 - i : i);
+    };
+    auto isInsertion = [isUndo](const EditHistory::Edit &edit) {
+        return (edit.type == EditHistory::Edit::InsertRow) != isUndo;
+    };
+
+    int i = 0;
+    while (i < count) {
+        const EditHistory::Edit &edit = editAt(i);
+
+        if (edit.type == EditHistory::Edit::SetField) {
+            int row = edit.row;
+            QStringList oldValues = this->model->rowValues(row);
+            QStringList values = oldValues.mid(0, JsonLinesModel::ColumnCount);
+
+            while (i < count && editAt(i).type == EditHistory::Edit::SetField && editAt(i).row == row) {
+                const EditHistory::Edit &fieldEdit = editAt(i++);
+                if (fieldEdit.column < values.size()) {
+                    values[fieldEdit.column] = isUndo ? fieldEdit.oldText : fieldEdit.newText;
+                }
+            }
+
+            if (row < 0 || row >= this->model->rowCount()) {
+                continue;
+            }
+
+            qint64 oldKey = this->model->rowKey(row);
+            this->model->setRowValues(row, values);
+            this->searchIndex->updateRow(oldKey, this->model->rowKey(row), values);
+            this->duplicateFinder->updateRow(oldKey, oldValues, this->model->rowKey(row), values);
+            this->rowValidator->updateRow(oldKey, this->model->rowKey(row), values);
+            continue;
+        }
+
+        // Insertions in ascending and removals in descending row order are
+        // the same as one insertRowContents() or removeRowList()
+        bool isInsert = isInsertion(edit);
+        QVector<int> rowList;
+        QVector<JsonLinesModel::RowContent> contents;
+
+        while (i < count && editAt(i).type != EditHistory::Edit::SetField && isInsertion(editAt(i)) == isInsert) {
+            int row = editAt(i).row;
+            if (!rowList.isEmpty() && (isInsert ? row <= rowList.last() : row >= rowList.last())) {
+                break;
+            }
+            rowList.append(row);
+            contents.append(editAt(i).content);
+            i++;
+        }
+
+        if (isInsert) {
+            this->model->insertRowContents(rowList, contents);
+
+            for (int row : rowList) {
+                qint64 key = this->model->rowKey(row);
+                QStringList values = this->model->rowValues(row);
+                this->searchIndex->updateRow(key, key, values);
+                this->duplicateFinder->updateRow(key, QStringList(), key, values);
+                this->rowValidator->updateRow(key, key, values, this->model->isRawRow(row));
+            }
+        } else {
+            QVector<qint64> keys;
+            for (int row : rowList) {
+                keys.append(this->model->rowKey(row));
+            }
+
+            this->searchIndex->removeRows(keys);
+            this->duplicateFinder->removeKeys(keys);
+            this->rowValidator->removeKeys(keys);
+
+            if (rowList.size() == 1) {
+                this->model->removeRow(rowList.first());
+            } else {
+                this->model->removeRowList(rowList);
+            }
+        }
+    }
+
+    this->duplicatesChanged();
+    this->issuesChanged();
+    this->setIsFileChanged(true);
+    this->tableSelectionChanged();
+    this->updateUndoActions();
+}
+
+void JsonLinesEditor::on_actionUndo_triggered()
+{
+    if (this->model->isLoading() || !this->editHistory.canUndo()) {
+        return;
+    }
+
+    EditHistory::Step step = this->editHistory.takeUndo();
+    this->applyEditStep(step, true);
+    this->logEdits(step.edits, true);
+
+    this->journalMessage(QString("Undo %1: %2 edits").arg(step.name).arg(step.edits.size()));
+}
+
+void JsonLinesEditor::on_actionRedo_triggered()
+{
+    if (this->model->isLoading() || !this->editHistory.canRedo()) {
+        return;
+    }
+
+    EditHistory::Step step = this->editHistory.takeRedo();
+    this->applyEditStep(step, false);
+    this->logEdits(step.edits, false);
+
+    this->journalMessage(QString("Redo %1: %2 edits").arg(step.name).arg(step.edits.size()));
+}
+
+void JsonLinesEditor::logEdits(const QVector<EditHistory::Edit> &edits, bool isUndo)
+{
+    if (edits.isEmpty() || this->editLog.filePath().isEmpty()) {
+        return;
+    }
+
+    this->editLog.append(edits, isUndo);
+
+    // Bulk edits are written at once, small ones within the autosave interval
+    if (this->editLog.pendingCount() >= EditLog::batchSize) {
+        this->flushEditLog();
+    } else if (!this->autosaveTimer.isActive()) {
+        this->autosaveTimer.start();
+    }
+}
+
+void JsonLinesEditor::flushEditLog()
+{
+    this->autosaveTimer.stop();
+
+    QString error;
+    if (!this->editLog.flush(&error)) {
+        this->journalMessage(QString("Cannot write edit log: %1").arg(error));
+    }
+}
+
+void JsonLinesEditor::startEditLog(const QString &filePath)
+{
+    this->autosaveTimer.stop();
+
+    QString error;
+    if (!this->editLog.start(filePath, &error)) {
+        this->journalMessage(QString("Cannot start edit log, edits cannot be recovered after a crash: %1. File: %2").arg(error, filePath));
+    }
+}
+
+void JsonLinesEditor::checkForRecovery()
+{
+    for (const QString &filePath : this->editLog.loggedFiles()) {
+        QMessageBox::StandardButton answer = QMessageBox::question(this,
+                                            "Recover edits",
+                                            QString("The program stopped with unsaved edits of:\n%1\n\nOpen the file and recover them?").arg(filePath),
+                                            QMessageBox::Yes|QMessageBox::No);
+        if (answer == QMessageBox::Yes) {
+            this->journalMessage(QString("Recovering edits: %1").arg(filePath));
+            this->recoveringFilePath = filePath;
+            if (!this->loadEditableFile(filePath)) {
+                this->recoveringFilePath = "";
+            }
+            // Other logs are offered on the next start
+            return;
+        }
+
+        this->journalMessage(QString("Discarded unsaved edits: %1").arg(filePath));
+        this->editLog.discard(filePath);
+    }
+}
+
+// Entries are applied as one redo step, they are not undoable. The log
+// goes on from the recovered state.
+void JsonLinesEditor::recoverEdits(const QString &filePath)
+{
+    QVector<EditHistory::Edit> edits;
+    QString error;
+
+    if (!this->editLog.read(filePath, &edits, &error)) {
+        QString message = QString("Cannot recover edits: %1. File: %2").arg(error, filePath);
+        this->journalMessage(message);
+        QMessageBox::warning(this,
+                             "Cannot recover edits",
+                             message,
+                             QMessageBox::Ok);
+        this->startEditLog(filePath);
+        return;
+    }
+
+    EditHistory::Step step;
+    step.edits = edits;
+    this->applyEditStep(step, false);
+    this->editLog.resume(filePath);
+
+    QString message = QString("Recovered %1 edits: %2").arg(edits.size()).arg(filePath);
+    this->journalMessage(message);
+    ui->statusbar->showMessage(message);
+}
+
+void JsonLinesEditor::on_actionUndoSettings_triggered()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("Undo settings");
+
+    QSpinBox *memoryLimit = new QSpinBox(&dialog);
+    memoryLimit->setRange(0, 64 * 1024);
+    memoryLimit->setSuffix(" MB");
+    memoryLimit->setSpecialValueText("Unlimited");
+    memoryLimit->setValue(int(this->editHistory.memoryLimit() / (1024 * 1024)));
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    QObject::connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    QFormLayout *layout = new QFormLayout(&dialog);
+    layout->addRow("Undo history memory:", memoryLimit);
+    layout->addRow(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    qint64 limit = qint64(memoryLimit->value()) * 1024 * 1024;
+    this->editHistory.setMemoryLimit(limit);
+    this->appCache->setConfigValue("undo_memory_limit", QString::number(limit));
+
+    this->journalMessage(QString("Undo history memory: %1 MB, %2 MB used").
+                         arg(memoryLimit->value()).
+                         arg(this->editHistory.memoryUsed() / (1024.0 * 1024.0), 0, 'f', 1));
+
+    this->updateUndoActions();
+}
+
+void JsonLinesEditor::on_actionFollowFile_toggled(bool isChecked)
+{
+    this->updateFileWatcher();
+
+    if (isChecked) {
+        this->journalMessage(QString("Following file: %1").arg(this->openedFile()));
+        // Lines added while not following
+        this->followFile();
+    }
+}
+
+void JsonLinesEditor::updateFileWatcher()
+{
+    QString filePath = this->openedFile();
+    bool isFollowing = ui->actionFollowFile->isChecked() && !filePath.isEmpty();
+
+    if (!this->fileWatcher.files().isEmpty()) {
+        this->fileWatcher.removePaths(this->fileWatcher.files());
+    }
+
+    if (isFollowing && QFileInfo::exists(filePath)) {
+        this->fileWatcher.addPath(filePath);
+    }
+}
+
+void JsonLinesEditor::followFile()
+{
+    QString filePath = this->openedFile();
+
+    if (!ui->actionFollowFile->isChecked() || filePath.isEmpty()) {
+        return;
+    }
+
+    // Still loading, look again later
+    if (this->model->isLoading()) {
+        this->followTimer.start();
+        return;
+    }
+
+    // Watcher drops a file that was removed or renamed, watch the new one
+    if (this->fileWatcher.files().isEmpty()) {
+        this->updateFileWatcher();
+    }
+
+    int firstRow = this->model->rowCount();
+    int appendedRows = 0;
+
+    switch (this->model->readAppended(&appendedRows)) {
+    case JsonLinesModel::FollowAppended: {
+        QVector<qint64> keys;
+        QVector<QStringList> values;
+        keys.reserve(appendedRows);
+        values.reserve(appendedRows);
+
+        for (int row = firstRow; row < firstRow + appendedRows; row++) {
+            keys.append(this->model->rowKey(row));
+            values.append(this->model->rowValues(row));
+            this->duplicateFinder->updateRow(keys.last(), QStringList(), keys.last(), values.last());
+            this->rowValidator->updateRow(keys.last(), keys.last(), values.last(), this->model->isRawRow(row));
+        }
+
+        this->searchIndex->addRows(keys, values);
+        this->duplicatesChanged();
+        this->issuesChanged();
+
+        this->journalMessage(QString("Appended %1 rows: %2").arg(appendedRows).arg(filePath));
+        break;
+    }
+    case JsonLinesModel::FollowReplaced:
+        if (this->isFileChanged() || this->isItemChanged()) {
+            // Loading again would drop the changes
+            ui->actionFollowFile->setChecked(false);
+
+            QString message = QString("File was truncated or replaced, stopped following to keep unsaved changes: %1").arg(filePath);
+            this->journalMessage(message);
+            ui->statusbar->showMessage(message);
+        } else {
+            this->journalMessage(QString("File was truncated or replaced, loading it again: %1").arg(filePath));
+            this->loadEditableFile(filePath);
+        }
+        break;
+    case JsonLinesModel::FollowFailed: {
+        ui->actionFollowFile->setChecked(false);
+
+        QString error = this->model->errorLine() > 0
+                ? QString("Cannot follow file: on line %1. Error:%2. File: %3").arg(this->model->errorLine()).arg(this->model->errorString(), filePath)
+                : QString("Cannot follow file: %1. File: %2").arg(this->model->errorString(), filePath);
+        this->journalMessage(error);
+        ui->statusbar->showMessage(error);
+        break;
+    }
+    case JsonLinesModel::FollowUnchanged:
+        break;
+    }
+}
@@ -0,0 +1,268 @@
+#ifndef JSONLINESEDITOR_H
+#define JSONLINESEDITOR_H
+
+#include <QMainWindow>
+#include "appcache.h"
+#include "core/backupmanager.h"
+#include "core/duplicatefinder.h"
+#include "core/edithistory.h"
+#include "core/editlog.h"
+#include "core/journal.h"
+#include "core/jsonlinesfiltermodel.h"
+#include "core/jsonlinesmodel.h"
+#include "core/rowvalidator.h"
+#include "core/searchindex.h"
+#include <QCloseEvent>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidgetItem>
+
+QT_BEGIN_NAMESPACE
+namespace Ui { class JsonLinesEditor; }
+QT_END_NAMESPACE
+
+class JsonLinesEditor : public QMainWindow
+{
+    Q_OBJECT
+    Q_PROPERTY(bool isFileChanged READ isFileChanged WRITE setIsFileChanged NOTIFY isFileChangedUpdated)
+    Q_PROPERTY(bool isItemChanged READ isItemChanged WRITE setIsItemChanged NOTIFY isItemChangedUpdated)
+    Q_PROPERTY(QString openedFile READ openedFile WRITE setOpenedFile NOTIFY openedFileUpdated)
+
+
+public:
+    JsonLinesEditor(QWidget *parent = nullptr);
+    ~JsonLinesEditor();
+
+protected:
+    void closeEvent(QCloseEvent *event) override {
+        if (checkForExit()) {
+            // Edits left unsaved on purpose are not recovered
+            this->editLog.stop();
+            this->journal->flush();
+            event->accept();
+        } else {
+            event->ignore();
+        }
+    }
+
+private slots:
+    void on_actionExit_triggered();
+
+    bool checkForExit();
+    void checkForCloseFile();
+    void selectFileAndOpen();
+    bool loadEditableFile(const QString &filePath);
+    void loadingProgress(qint64 bytesLoaded, qint64 bytesTotal, int rowsLoaded);
+    void loadingFinished(int status);
+    void journalMessage(const QString& message);
+    void flushJournal();
+    void openedFileChanged(const QString &filePath);
+
+    void on_actionAbout_triggered();
+
+    void on_actionClearCache_triggered();
+
+    void on_actionSaveTrace_triggered();
+
+    void on_actionUndo_triggered();
+
+    void on_actionRedo_triggered();
+
+    void on_actionUndoSettings_triggered();
+
+    void flushEditLog();
+    void checkForRecovery();
+
+    void on_actionFollowFile_toggled(bool isChecked);
+    void followFile();
+
+    void on_actionOpen_triggered();
+
+    void tableSelectionChanged();
+
+    void on_toolButton_TermSearchGoogle_clicked();
+
+    void on_toolButton_TermOrigSearchGooglech_clicked();
+
+    void on_lineEditTerm_textChanged();
+
+    void on_lineEditTermOrig_textChanged();
+
+    void on_plainTextDefinition_textChanged();
+
+    void on_plainTextEditDefinitionOrig_textChanged();
+
+    void on_lineEditSource_textChanged();
+
+    void on_toolButtonSaveItem_clicked();
+
+    void on_actionSave_triggered();
+
+    void on_actionCloseFile_triggered();
+
+    void on_actionSaveAs_triggered();
+
+    void on_actionCreate_triggered();
+
+    void on_toolButton_AddRow_clicked();
+
+    void on_toolButton_RemoveRow_clicked();
+
+    void on_actionBackupSettings_triggered();
+
+    void on_lineEditSearch_textChanged();
+
+    void on_lineEditSearch_returnPressed();
+
+    void runSearch();
+    void searchIndexBuilt(bool isBuilt, int rowCount, qint64 elapsedMs);
+
+    void on_lineEditFilter_returnPressed();
+
+    void on_lineEditFilter_textChanged();
+
+    void applyFilter();
+    void filterFinished(int matchCount, qint64 elapsedMs);
+
+    void sortByColumn(int column);
+    void sortFinished(qint64 elapsedMs);
+
+    void on_actionClearSort_triggered();
+
+    void on_actionSaveSorted_toggled(bool isChecked);
+
+    void on_actionTolerantLoading_toggled(bool isChecked);
+
+    void on_actionFixLine_triggered();
+
+    void on_pushButtonFindDuplicates_clicked();
+
+    void on_pushButtonKeepSelected_clicked();
+
+    void on_pushButtonKeepFirst_clicked();
+
+    void on_treeWidgetDuplicates_itemDoubleClicked(QTreeWidgetItem *item, int column);
+
+    void on_treeWidgetDuplicates_itemSelectionChanged();
+
+    void duplicatesFound(qint64 elapsedMs);
+    void refreshDuplicates();
+
+    void on_pushButtonValidate_clicked();
+
+    void on_treeWidgetIssues_itemDoubleClicked(QTreeWidgetItem *item, int column);
+
+    void validationFinished(qint64 elapsedMs);
+    void refreshIssues();
+
+signals:
+    void isFileChangedUpdated(bool);
+    void isItemChangedUpdated(bool);
+    void openedFileUpdated(QString);
+//    void newJournalMessage(const QString& message);
+
+private:
+    Ui::JsonLinesEditor *ui;
+    const QString defaultFileUnsaved = "unsaved";
+    AppCache *appCache = new AppCache();
+    Journal *journal = new Journal();
+    QTimer journalTimer;
+    quint64 journalShownId = 0;         // last entry in the Journal tab
+    BackupManager *backupManager = nullptr;
+    SearchIndex *searchIndex = nullptr;
+    QTimer searchTimer;
+    QVector<int> searchRows;            // matching rows, ascending
+    QFileSystemWatcher fileWatcher;     // opened file while following it
+    QTimer followTimer;
+    DuplicateFinder *duplicateFinder = new DuplicateFinder(this);
+    bool isDuplicatesDirty = false;
+    static const int maxDuplicateGroups = 1000;
+    RowValidator *rowValidator = new RowValidator(this);
+    bool isIssuesDirty = false;
+    QTimer issuesTimer;                 // refreshes the Issues tab after edits
+    static const int maxIssueItems = 10000;
+    JsonLinesModel *model = new JsonLinesModel(this);
+    JsonLinesFilterModel *filterModel = new JsonLinesFilterModel(this->model, this);
+    EditHistory editHistory;
+    EditLog editLog;
+    QTimer autosaveTimer;               // flushes the edit log
+    QString recoveringFilePath = "";    // loading to replay its edit log
+    QProgressBar *loadingProgressBar = nullptr;
+    QPushButton *loadingCancelButton = nullptr;
+    QElapsedTimer loadingTimer;
+    qint64 traceStart = 0;              // Tracer::now() when the last load or save started
+    QString loadingFilePath = "";
+    int rowsUpdated = 0;
+    int rowsInserted = 0;
+    QString lastPath = "";
+
+
+    // Field text the editor panel was filled with, a keystroke compares
+    // lengths and hashes only the rare text of the same length
+    struct FieldBaseline {
+        int length = 0;
+        size_t hash = 0;
+    };
+    FieldBaseline fieldBaselines[JsonLinesModel::ColumnCount];
+    quint32 changedFields = 0;          // bit per column differing from its baseline
+
+    bool isFileChangedVal = false;
+    bool isItemChangedVal = false;
+    QString openedFileVal = "";
+
+    bool isFileChanged() const { return isFileChangedVal; }
+    void setIsFileChanged(bool val) {
+        if (isFileChangedVal != val) {
+            isFileChangedVal = val;
+            emit isFileChangedUpdated(val);
+        }
+    }
+
+    bool isItemChanged() const { return isItemChangedVal; }
+    void setIsItemChanged(bool val) {
+        if (isItemChangedVal != val) {
+            isItemChangedVal = val;
+            emit isItemChangedUpdated(val);
+        }
+    }
+
+    QString openedFile() const { return openedFileVal; }
+    void setOpenedFile(QString val) {
+        if (openedFileVal != val) {
+            openedFileVal = val;
+            emit openedFileUpdated(val);
+        }
+    }
+
+    bool initDataDirs();
+    int selectedRow() const;
+    QModelIndex viewIndex(int row) const;
+    void selectRow(int row);
+    void setViewModel(QAbstractItemModel *viewModel);
+    void resetItemBaseline();
+    void checkFieldChanged(int column);
+    void enableEditor();
+    void disableEditor();
+    void setLoadingState(bool isLoading);
+    bool saveFile(bool saveAs = false);
+    bool createFileBackup(const QString &filePath);
+    void pruneBackups(const QString &baseName);
+    void rebuildSearchIndex(const QString &filePath);
+    void selectSearchMatch(bool isNext);
+    void duplicatesChanged();
+    void issuesChanged();
+    void removeRowKeys(const QVector<qint64> &keys);
+    void endEditStep();
+    void applyEditStep(const EditHistory::Step &step, bool isUndo);
+    void updateUndoActions();
+    void logEdits(const QVector<EditHistory::Edit> &edits, bool isUndo);
+    void startEditLog(const QString &filePath);
+    void recoverEdits(const QString &filePath);
+    void updateFileWatcher();
+    BackupManager::Policy loadBackupPolicy();
+    void saveBackupPolicy(const BackupManager::Policy &policy);
+};
+#endif // JSONLINESEDITOR_H
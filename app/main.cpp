@@ -0,0 +1,21 @@
+#include "jsonlineseditor.h"
+#include "core/jsonlinescli.h"
+
+#include <QApplication>
+
+int main(int argc, char *argv[])
+{
+    // Batch mode needs no display
+    if (JsonLinesCli::isCliArguments(argc, argv)) {
+        QCoreApplication a(argc, argv);
+        QCoreApplication::setApplicationName("JsonLinesEditor");
+        QCoreApplication::setApplicationVersion(APP_VERSION);
+
+        return JsonLinesCli::run(a.arguments());
+    }
+
+    QApplication a(argc, argv);
+    JsonLinesEditor w;
+    w.show();
+    return a.exec();
+}
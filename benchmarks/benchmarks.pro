@@ -0,0 +1,15 @@
+# Benchmarks, built apart from the application:
+#   qmake benchmarks/benchmarks.pro && make
+# The indexing and serializer targets compile the core sources they
+# measure directly, the suite links the core library built with them.
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    core \
+    indexing \
+    serializer \
+    suite
+
+core.subdir = ../core
+suite.depends = core
@@ -0,0 +1,15 @@
+QT = core
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = bench_indexing
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../core/linescanner.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../core/linescanner.h
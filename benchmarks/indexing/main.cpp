@@ -0,0 +1,175 @@
+// Line indexing throughput: QTextStream::readLine() loop used by the editor
+// before the memory-mapped loader vs LineScanner implementations.
+//
+// Usage: bench_indexing [file.jsonl] [repeats]
+// Without a file a synthetic 256 MB JSONL file is generated.
+
+#include "core/linescanner.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QVector>
+
+static QTextStream out(stdout);
+
+static bool generateFile(QFile *file, qint64 targetSize)
+{
+    QByteArray line = "{\"definition\":\"Definition text of the term, long enough to look like real data\","
+                      "\"original_definition\":\"Original definition text of the term\","
+                      "\"original_term\":\"term\",\"source\":\"https://example.com/wiki\",\"term\":\"term\"}\n";
+    QByteArray block;
+    int counter = 0;
+
+    while (block.size() < 1024 * 1024) {
+        // Vary line length and mix in blank and CRLF lines
+        block.append(line.constData(), line.size() - 1);
+        block.append(QByteArray(counter % 7, ' '));
+        block.append(counter % 11 == 0 ? "\r\n" : "\n");
+        if (counter % 97 == 0) {
+            block.append("\n");
+        }
+        counter++;
+    }
+
+    for (qint64 written = 0; written < targetSize; written += block.size()) {
+        if (file->write(block) != block.size()) {
+            return false;
+        }
+    }
+
+    return file->flush();
+}
+
+static qint64 indexReadLine(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+
+    QTextStream in(&file);
+    in.setEncoding(QStringConverter::Utf8);
+
+    qint64 rows = 0;
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (!line.isEmpty()) {
+            rows++;
+        }
+    }
+
+    return rows;
+}
+
+static qint64 indexScanner(const char *data, qint64 size, LineScanner::FindNewlineFunc findNewline)
+{
+    QVector<qint64> offsets;
+    const char *end = data + size;
+    const char *lineStart = data;
+
+    while (lineStart < end) {
+        const char *newline = findNewline(lineStart, end);
+        const char *begin = lineStart;
+        const char *last = newline;
+
+        lineStart = newline + 1;
+
+        while (begin < last && LineScanner::isSpace(*begin)) {
+            begin++;
+        }
+        while (last > begin && LineScanner::isSpace(*(last - 1))) {
+            last--;
+        }
+        if (begin != last) {
+            offsets.append(begin - data);
+        }
+    }
+
+    return offsets.size();
+}
+
+static void report(const char *name, qint64 rows, qint64 bytes, qint64 nsecs)
+{
+    double seconds = nsecs / 1e9;
+    out << QString("%1 rows: %2 time: %3 s speed: %4 GB/s").
+           arg(QString::fromLatin1(name), -10).
+           arg(rows).
+           arg(seconds, 0, 'f', 3).
+           arg(bytes / seconds / 1e9, 0, 'f', 2) << Qt::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    QTemporaryFile generated;
+    QString filePath;
+
+    if (args.size() > 1) {
+        filePath = args.at(1);
+    } else {
+        if (!generated.open() || !generateFile(&generated, 256ll * 1024 * 1024)) {
+            out << "Cannot generate benchmark file" << Qt::endl;
+            return 1;
+        }
+        filePath = generated.fileName();
+    }
+
+    int repeats = args.size() > 2 ? args.at(2).toInt() : 3;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        out << "Cannot open file: " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    qint64 size = file.size();
+    const char *data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data) {
+        out << "Cannot map file: " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    out << QString("File: %1 size: %2 MB SIMD: %3").
+           arg(filePath).
+           arg(size / (1024 * 1024)).
+           arg(QString::fromLatin1(LineScanner::simdLevel())) << Qt::endl;
+
+    struct Scanner {
+        const char *name;
+        LineScanner::FindNewlineFunc func;
+        bool isSupported;
+    };
+
+    const Scanner scanners[] = {
+        {"scalar", &LineScanner::findNewlineScalar, true},
+        {"sse2", &LineScanner::findNewlineSse2, LineScanner::hasSse2()},
+        {"avx2", &LineScanner::findNewlineAvx2, LineScanner::hasAvx2()},
+    };
+
+    // Warm up page cache
+    indexScanner(data, size, &LineScanner::findNewlineScalar);
+
+    for (int i = 0; i < repeats; i++) {
+        QElapsedTimer timer;
+
+        timer.start();
+        qint64 rows = indexReadLine(filePath);
+        report("readLine", rows, size, timer.nsecsElapsed());
+
+        for (const Scanner &scanner : scanners) {
+            if (!scanner.isSupported) {
+                continue;
+            }
+            timer.restart();
+            rows = indexScanner(data, size, scanner.func);
+            report(scanner.name, rows, size, timer.nsecsElapsed());
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Serialization throughput: per-row QJsonObject/QJsonDocument/QTextStream
+// path used by saveFile() before vs JsonLinesWriter. Both outputs are
+// compared byte for byte.
+//
+// Usage: bench_serializer [rows] [repeats]
+
+#include "core/jsonlineswriter.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTextStream>
+
+static QTextStream out(stdout);
+
+static const QStringList keys = {
+    "term",
+    "original_term",
+    "definition",
+    "original_definition",
+    "source"
+};
+
+static QString randomText(QRandomGenerator &random, int length)
+{
+    // Mostly ASCII with Cyrillic, CJK, emoji and characters to be escaped
+    static const QString alphabet = QString::fromUtf8("abcdefghij klmnopqrst uvwxyz ABCDEF 0123456789 "
+                                                      "абвгдеёжзий клмнопрст 中文字符 \"\\\t\n/ 😀");
+    QString text;
+    text.reserve(length);
+
+    while (text.size() < length) {
+        int i = random.bounded(alphabet.size());
+        if (alphabet.at(i).isSurrogate()) {
+            i = alphabet.at(i).isHighSurrogate() ? i : i - 1;
+            text.append(alphabet.mid(i, 2));
+        } else {
+            text.append(alphabet.at(i));
+        }
+    }
+
+    return text;
+}
+
+static QByteArray writeQJsonDocument(const QVector<QStringList> &rows)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    QTextStream stream(&buffer);
+    stream.setEncoding(QStringConverter::Utf8);
+
+    for (const QStringList &values : rows) {
+        QJsonObject obj;
+        for (int i = 0; i < keys.size(); i++) {
+            obj.insert(keys.at(i), values.at(i));
+        }
+        QJsonDocument doc(obj);
+        stream << doc.toJson(QJsonDocument::Compact) << "\n";
+    }
+    stream.flush();
+
+    return buffer.data();
+}
+
+static QByteArray writeJsonLinesWriter(const QVector<QStringList> &rows)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    JsonLinesWriter writer(&buffer, keys);
+    for (const QStringList &values : rows) {
+        writer.writeRow(values);
+    }
+    writer.flush();
+
+    return buffer.data();
+}
+
+static void report(const char *name, qint64 rows, qint64 bytes, qint64 nsecs)
+{
+    double seconds = nsecs / 1e9;
+    out << QString("%1 rows: %2 time: %3 s speed: %4 MB/s %5 rows/s").
+           arg(QString::fromLatin1(name), -18).
+           arg(rows).
+           arg(seconds, 0, 'f', 3).
+           arg(bytes / seconds / (1024 * 1024), 0, 'f', 1).
+           arg(qRound64(rows / seconds)) << Qt::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    int rowCount = args.size() > 1 ? args.at(1).toInt() : 200000;
+    int repeats = args.size() > 2 ? args.at(2).toInt() : 3;
+
+    QRandomGenerator random(42);
+    QVector<QStringList> rows;
+    rows.reserve(rowCount);
+
+    for (int i = 0; i < rowCount; i++) {
+        rows.append({
+            randomText(random, 5 + random.bounded(30)),
+            randomText(random, 5 + random.bounded(30)),
+            randomText(random, 50 + random.bounded(500)),
+            randomText(random, 50 + random.bounded(500)),
+            randomText(random, 10 + random.bounded(20))
+        });
+    }
+
+    for (int i = 0; i < repeats; i++) {
+        QElapsedTimer timer;
+
+        timer.start();
+        QByteArray expected = writeQJsonDocument(rows);
+        report("QJsonDocument", rows.size(), expected.size(), timer.nsecsElapsed());
+
+        timer.restart();
+        QByteArray written = writeJsonLinesWriter(rows);
+        report("JsonLinesWriter", rows.size(), written.size(), timer.nsecsElapsed());
+
+        if (written != expected) {
+            out << "Output mismatch" << Qt::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
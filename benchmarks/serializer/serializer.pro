@@ -0,0 +1,15 @@
+QT = core
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = bench_serializer
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../core/jsonlineswriter.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../core/jsonlineswriter.h
@@ -0,0 +1,146 @@
+#include "datagenerator.h"
+#include "core/jsonlinesmodel.h"
+#include "core/jsonlineswriter.h"
+
+#include <QtMath>
+
+DataGenerator::DataGenerator(const Options &options)
+    : options(options)
+    , random(options.seed)
+{
+    for (int i = 0; i < vocabularySize; i++) {
+        this->words.append(this->makeWord(i >= vocabularySize / 2));
+    }
+
+    for (int i = 0; i < sourceCount; i++) {
+        this->sources.append(QString("https://example.org/%1/%2").arg(this->makeWord(false)).arg(i));
+    }
+}
+
+QString DataGenerator::makeWord(bool isUnicode)
+{
+    static const QString ascii = QString::fromUtf8("abcdefghijklmnopqrstuvwxyz");
+    static const QStringList scripts = {
+        QString::fromUtf8("абвгдеёжзийклмнопрстуфхцчшщъыьэюя"),
+        QString::fromUtf8("αβγδεζηθικλμνξοπρστυφχψω"),
+        QString::fromUtf8("的一是不了人我在有他这中大来上国个到说们为子和你地出道也时年得就那要下以生会自着去之过家学对可她里后小么心多天而能好都然没日于起还发成事只作当想看文无开手十用主行方又如前所本见经头面公同三已老从动两长知民样现与"),
+    };
+
+    int length = this->random.bounded(3, 10);
+    QString word;
+
+    if (!isUnicode) {
+        for (int i = 0; i < length; i++) {
+            word.append(ascii.at(this->random.bounded(ascii.size())));
+        }
+        return word;
+    }
+
+    // Emoji are surrogate pairs, one in sixteen words
+    if (this->random.bounded(16) == 0) {
+        static const char32_t emoji[] = {0x1F600, 0x1F680, 0x1F4DA, 0x1F30D, 0x2764};
+        word.append(QString::fromUcs4(&emoji[this->random.bounded(5)], 1));
+        return word;
+    }
+
+    const QString &script = scripts.at(this->random.bounded(scripts.size()));
+    // CJK words are shorter
+    if (&script == &scripts.last()) {
+        length = this->random.bounded(1, 4);
+    }
+    for (int i = 0; i < length; i++) {
+        word.append(script.at(this->random.bounded(script.size())));
+    }
+    return word;
+}
+
+int DataGenerator::pickWord(QRandomGenerator &random, bool isUnicode) const
+{
+    // Squared uniform gives a skew towards the first words of each half
+    double x = random.generateDouble();
+    int half = vocabularySize / 2;
+    int index = qMin(int(x * x * half), half - 1);
+    return isUnicode ? half + index : index;
+}
+
+QString DataGenerator::makeText(int averageLength, bool isUnicodeMix)
+{
+    int length = this->random.bounded(qMax(averageLength / 2, 1), averageLength * 3 / 2 + 1);
+    QString text;
+
+    while (text.size() < length) {
+        if (!text.isEmpty()) {
+            // Now and then punctuation and characters JSON has to escape
+            switch (this->random.bounded(64)) {
+            case 0:
+                text.append(", ");
+                break;
+            case 1:
+                text.append(" \"");
+                break;
+            case 2:
+                text.append("\\");
+                break;
+            case 3:
+                text.append("\t");
+                break;
+            default:
+                text.append(' ');
+                break;
+            }
+        }
+
+        bool isUnicode = isUnicodeMix && this->random.generateDouble() < this->options.unicodeRatio;
+        text.append(this->words.at(this->pickWord(this->random, isUnicode)));
+    }
+
+    return text;
+}
+
+QStringList DataGenerator::nextRow()
+{
+    QStringList values;
+
+    values.append(this->makeText(this->options.termLength, true));
+    values.append(this->makeText(this->options.termLength, false));
+    values.append(this->makeText(this->options.definitionLength, true));
+    values.append(this->makeText(this->options.definitionLength, false));
+    values.append(this->sources.at(this->pickWord(this->random, false) % sourceCount));
+
+    return values;
+}
+
+qint64 DataGenerator::write(QIODevice *device)
+{
+    JsonLinesWriter writer(device, JsonLinesModel::fieldKeys());
+
+    for (qint64 row = 0; row < this->options.rows; row++) {
+        if (writer.writeRow(this->nextRow()) < 0) {
+            return -1;
+        }
+    }
+
+    if (!writer.flush()) {
+        return -1;
+    }
+
+    return writer.pos();
+}
+
+const QStringList &DataGenerator::vocabulary() const
+{
+    return this->words;
+}
+
+QStringList DataGenerator::sampleWords(int count, quint32 seed) const
+{
+    QRandomGenerator sampler(seed);
+    QStringList sample;
+
+    for (int i = 0; i < count; i++) {
+        bool isUnicode = sampler.generateDouble() < this->options.unicodeRatio;
+        sample.append(this->words.at(this->pickWord(sampler, isUnicode)));
+    }
+
+    return sample;
+}
@@ -0,0 +1,50 @@
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include <QIODevice>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QVector>
+
+// Deterministic generator of five-field JSON Lines rows. The same options
+// and seed always give the same bytes. Text is made of words from a fixed
+// vocabulary picked with a skew, so common words repeat like in real data
+// and search queries built from vocabulary() find matches. unicodeRatio is
+// the share of non-ASCII words (Cyrillic, Greek, CJK, emoji) in term and
+// definition, original fields stay ASCII. Sources come from a small set.
+class DataGenerator
+{
+public:
+    struct Options {
+        qint64 rows = 1000000;
+        int termLength = 24;            // average length in characters
+        int definitionLength = 240;
+        double unicodeRatio = 0.5;
+        quint32 seed = 1;
+    };
+
+    explicit DataGenerator(const Options &options);
+
+    QStringList nextRow();
+    // Returns bytes written, -1 on write error
+    qint64 write(QIODevice *device);
+
+    const QStringList &vocabulary() const;
+    // Words picked the same way rows pick them
+    QStringList sampleWords(int count, quint32 seed) const;
+
+private:
+    static const int vocabularySize = 8192;
+    static const int sourceCount = 32;
+
+    QString makeWord(bool isUnicode);
+    QString makeText(int averageLength, bool isUnicodeMix);
+    int pickWord(QRandomGenerator &random, bool isUnicode) const;
+
+    Options options;
+    QRandomGenerator random;
+    QStringList words;              // ASCII half first, then non-ASCII
+    QStringList sources;
+};
+
+#endif // DATAGENERATOR_H
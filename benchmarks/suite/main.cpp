@@ -0,0 +1,575 @@
+// End-to-end benchmark suite over a generated five-field JSON Lines file:
+// file indexing, parsing, model population, saving, compressed saving and
+// loading, backup and search.
+// Every benchmark runs --repeats times, results are printed as JSON so
+// runs can be compared by scripts.
+//
+// Usage: bench_suite [--rows N] [--term-length N] [--definition-length N]
+//                    [--unicode 0..1] [--seed N] [--repeats N] [--queries N]
+//                    [--only name,...] [--output results.json] [file]
+//        bench_suite --generate out.jsonl [generator options]
+//
+// Without a file a temporary one is generated, the same options and seed
+// always give the same file.
+
+#include "core/backupmanager.h"
+#include "core/jsonlinesmodel.h"
+#include "core/jsonlinesparser.h"
+#include "core/jsonlineswriter.h"
+#include "core/linescanner.h"
+#include "core/searchindex.h"
+#include "datagenerator.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <functional>
+
+static QTextStream err(stderr);
+
+struct Result {
+    QString name;
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    QVector<qint64> nsecs;
+    QJsonObject extra;
+};
+
+static QJsonObject resultObject(const Result &result)
+{
+    QJsonObject object;
+    object.insert("name", result.name);
+    object.insert("rows", result.rows);
+    object.insert("bytes", result.bytes);
+
+    if (result.nsecs.isEmpty()) {
+        return object;
+    }
+
+    QVector<qint64> sorted = result.nsecs;
+    std::sort(sorted.begin(), sorted.end());
+
+    double median = sorted.at(sorted.size() / 2) / 1e6;
+    double seconds = median / 1e3;
+
+    QJsonArray runs;
+    for (qint64 nsecs : result.nsecs) {
+        runs.append(nsecs / 1e6);
+    }
+
+    object.insert("runs_ms", runs);
+    object.insert("min_ms", sorted.first() / 1e6);
+    object.insert("median_ms", median);
+    object.insert("max_ms", sorted.last() / 1e6);
+    if (seconds > 0) {
+        object.insert("rows_per_s", result.rows / seconds);
+        object.insert("mb_per_s", result.bytes / seconds / (1024 * 1024));
+    }
+    for (auto it = result.extra.constBegin(); it != result.extra.constEnd(); ++it) {
+        object.insert(it.key(), it.value());
+    }
+
+    return object;
+}
+
+// Runs func repeats times, func returns false on error
+static bool measure(Result *result, int repeats, const std::function<bool()> &func)
+{
+    err << "Running " << result->name << Qt::endl;
+
+    for (int i = 0; i < repeats; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!func()) {
+            return false;
+        }
+        result->nsecs.append(timer.nsecsElapsed());
+    }
+
+    return true;
+}
+
+// A failed benchmark is reported and left out of the results
+static void appendResult(QVector<Result> *results, const Result &result, bool isMeasured)
+{
+    if (!isMeasured || result.nsecs.isEmpty()) {
+        err << "Benchmark failed: " << result.name << Qt::endl;
+        return;
+    }
+
+    results->append(result);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("bench_suite");
+    app.setApplicationVersion(APP_VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("JSON Lines editor benchmark suite");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", "JSON Lines file to use instead of a generated one.", "[file]");
+    parser.addOptions({
+        {"rows", "Generated rows.", "count", "1000000"},
+        {"term-length", "Average term length in characters.", "length", "24"},
+        {"definition-length", "Average definition length in characters.", "length", "240"},
+        {"unicode", "Share of non-ASCII words in term and definition, 0 to 1.", "ratio", "0.5"},
+        {"seed", "Generator seed.", "seed", "1"},
+        {"repeats", "Runs of every benchmark.", "count", "3"},
+        {"queries", "Search queries per run.", "count", "100"},
+        {"only", "Comma separated benchmarks to run.", "names"},
+        {"output", "Write JSON results to file instead of stdout.", "file"},
+        {"generate", "Only generate the file and exit.", "file"},
+    });
+    parser.process(app);
+
+    DataGenerator::Options options;
+    options.rows = parser.value("rows").toLongLong();
+    options.termLength = parser.value("term-length").toInt();
+    options.definitionLength = parser.value("definition-length").toInt();
+    options.unicodeRatio = qBound(0.0, parser.value("unicode").toDouble(), 1.0);
+    options.seed = parser.value("seed").toUInt();
+
+    int repeats = qMax(parser.value("repeats").toInt(), 1);
+    int queryCount = qMax(parser.value("queries").toInt(), 1);
+    QStringList only = parser.value("only").split(',', Qt::SkipEmptyParts);
+
+    DataGenerator generator(options);
+
+    if (parser.isSet("generate")) {
+        QSaveFile file(parser.value("generate"));
+        if (!file.open(QIODevice::WriteOnly) || generator.write(&file) < 0 || !file.commit()) {
+            err << "Cannot write file: " << file.errorString() << Qt::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        err << "Cannot create temporary directory: " << tempDir.errorString() << Qt::endl;
+        return 1;
+    }
+
+    QString filePath;
+    bool isGenerated = parser.positionalArguments().isEmpty();
+
+    if (isGenerated) {
+        filePath = tempDir.filePath("generated.jsonl");
+        err << "Generating " << options.rows << " rows" << Qt::endl;
+
+        QFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly) || generator.write(&file) < 0) {
+            err << "Cannot generate file: " << file.errorString() << Qt::endl;
+            return 1;
+        }
+    } else {
+        filePath = parser.positionalArguments().first();
+    }
+
+    JsonLinesSource source;
+    QString error;
+    if (!JsonLinesSource::open(filePath, &source, &error)) {
+        err << "Cannot open file: " << error << Qt::endl;
+        return 1;
+    }
+
+    auto isSelected = [&only](const QString &name) {
+        return only.isEmpty() || only.contains(name);
+    };
+
+    QVector<Result> results;
+    qint64 rowCount = 0;
+
+    // Warms up the page cache as well
+    {
+        QVector<JsonLinesRowRef> rows;
+        JsonLinesParser::Error parseError;
+        if (!JsonLinesParser::indexLines(source.data, source.size, &rows, &parseError)) {
+            err << "Line " << parseError.lineNumber << ": " << parseError.message << Qt::endl;
+            return 1;
+        }
+        rowCount = rows.size();
+    }
+
+    if (rowCount == 0) {
+        err << "File has no rows" << Qt::endl;
+        return 1;
+    }
+
+    if (isSelected("index")) {
+        Result result;
+        result.name = "index";
+        result.rows = rowCount;
+        result.bytes = source.size;
+        result.extra.insert("simd", QString::fromLatin1(LineScanner::simdLevel()));
+
+        bool isMeasured = measure(&result, repeats, [&source]() {
+            qint64 lines = 0;
+            LineScanner::forEachLine(source.data, source.size, [&lines](int, const char *, const char *) {
+                lines++;
+                return true;
+            });
+            return lines > 0;
+        });
+        appendResult(&results, result, isMeasured);
+    }
+
+    if (isSelected("parse")) {
+        Result result;
+        result.name = "parse";
+        result.rows = rowCount;
+        result.bytes = source.size;
+
+        bool isMeasured = measure(&result, repeats, [&source]() {
+            QVector<JsonLinesRowRef> rows;
+            JsonLinesParser::Error parseError;
+            return JsonLinesParser::indexLines(source.data, source.size, &rows, &parseError);
+        });
+        appendResult(&results, result, isMeasured);
+    }
+
+    JsonLinesModel model;
+
+    if (isSelected("model_load")) {
+        Result result;
+        result.name = "model_load";
+        result.rows = rowCount;
+        result.bytes = source.size;
+
+        bool isMeasured = measure(&result, repeats, [&model, &filePath]() {
+            return model.load(filePath);
+        });
+        if (!isMeasured) {
+            err << "Cannot load file: " << model.errorString() << Qt::endl;
+        }
+        appendResult(&results, result, isMeasured);
+    }
+
+    if (!model.load(filePath)) {
+        err << "Cannot load file: " << model.errorString() << Qt::endl;
+        return 1;
+    }
+
+    if (isSelected("model_read")) {
+        // Every cell through data() as the view reads it while scrolling
+        Result result;
+        result.name = "model_read";
+        result.rows = rowCount;
+        result.bytes = source.size;
+
+        bool isMeasured = measure(&result, repeats, [&model]() {
+            qint64 length = 0;
+            for (int row = 0; row < model.rowCount(); row++) {
+                for (int column = 0; column < model.columnCount(); column++) {
+                    length += model.data(model.index(row, column)).toString().size();
+                }
+            }
+            return length > 0;
+        });
+        appendResult(&results, result, isMeasured);
+    }
+
+    if (isSelected("save_patch")) {
+        // One row in a hundred edited, the rest copied as byte ranges
+        Result result;
+        result.name = "save_patch";
+        result.rows = rowCount;
+        result.bytes = source.size;
+
+        QString savedPath = tempDir.filePath("saved.jsonl");
+        JsonLinesModel::SaveStats stats;
+        bool isMeasured = true;
+
+        err << "Running " << result.name << Qt::endl;
+
+        for (int i = 0; i < repeats && isMeasured; i++) {
+            JsonLinesModel edited;
+            if (!edited.load(filePath)) {
+                err << "Cannot load file: " << edited.errorString() << Qt::endl;
+                isMeasured = false;
+                break;
+            }
+            for (int row = 0; row < edited.rowCount(); row += 100) {
+                QStringList values = edited.rowValues(row);
+                values[JsonLinesModel::ColumnTerm].append(" edited");
+                edited.setRowValues(row, values);
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            if (!edited.save(savedPath)) {
+                err << "Cannot save file: " << edited.errorString() << Qt::endl;
+                isMeasured = false;
+                break;
+            }
+            result.nsecs.append(timer.nsecsElapsed());
+            stats = edited.saveStats();
+        }
+
+        result.extra.insert("copied_rows", stats.copiedRows);
+        result.extra.insert("encoded_rows", stats.encodedRows);
+        appendResult(&results, result, isMeasured);
+    }
+
+    if (isSelected("save_encode")) {
+        // Every row decoded and encoded again, as saveFile() did before
+        // unchanged rows were copied
+        Result result;
+        result.name = "save_encode";
+        result.rows = rowCount;
+        result.bytes = source.size;
+
+        QString savedPath = tempDir.filePath("encoded.jsonl");
+        JsonLinesModel::Snapshot snapshot = model.snapshot();
+
+        bool isMeasured = measure(&result, repeats, [&snapshot, &savedPath]() {
+            QSaveFile file(savedPath);
+            if (!file.open(QIODevice::WriteOnly)) {
+                return false;
+            }
+            JsonLinesWriter writer(&file, JsonLinesModel::fieldKeys());
+            for (int row = 0; row < snapshot.rowCount(); row++) {
+                if (writer.writeRow(snapshot.rowValues(row)) < 0) {
+                    return false;
+                }
+            }
+            return writer.flush() && file.commit();
+        });
+        if (!isMeasured) {
+            err << "Cannot save file" << Qt::endl;
+        }
+        appendResult(&results, result, isMeasured);
+    }
+
+    // Multithreaded compressed save, then the streaming load of its output
+    const QVector<QPair<QString, QString>> compressedFormats = {{"gzip", "gz"}, {"zstd", "zst"}};
+    for (const QPair<QString, QString> &format : compressedFormats) {
+        QString compressedPath = tempDir.filePath("compressed.jsonl." + format.second);
+
+        if (isSelected("save_" + format.first) || isSelected("load_" + format.first)) {
+            Result result;
+            result.name = "save_" + format.first;
+            result.rows = rowCount;
+            result.bytes = source.size;
+
+            bool isMeasured = true;
+
+            err << "Running " << result.name << Qt::endl;
+
+            // Saving switches the model to the saved file, a fresh one every time
+            for (int i = 0; i < repeats && isMeasured; i++) {
+                JsonLinesModel plain;
+                if (!plain.load(filePath)) {
+                    err << "Cannot load file: " << plain.errorString() << Qt::endl;
+                    isMeasured = false;
+                    break;
+                }
+
+                QElapsedTimer timer;
+                timer.start();
+                if (!plain.save(compressedPath)) {
+                    err << "Cannot save file: " << plain.errorString() << Qt::endl;
+                    isMeasured = false;
+                    break;
+                }
+                result.nsecs.append(timer.nsecsElapsed());
+            }
+
+            result.extra.insert("compressed_size", QFileInfo(compressedPath).size());
+            if (isSelected(result.name)) {
+                appendResult(&results, result, isMeasured);
+            }
+        }
+
+        if (isSelected("load_" + format.first)) {
+            Result result;
+            result.name = "load_" + format.first;
+            result.rows = rowCount;
+            result.bytes = source.size;
+
+            JsonLinesModel compressed;
+            bool isMeasured = measure(&result, repeats, [&compressed, &compressedPath]() {
+                return compressed.load(compressedPath);
+            });
+            if (!isMeasured) {
+                err << "Cannot load file: " << compressed.errorString() << Qt::endl;
+            }
+            appendResult(&results, result, isMeasured);
+        }
+    }
+
+    if (isSelected("backup")) {
+        Result result;
+        result.name = "backup";
+        result.rows = rowCount;
+        result.bytes = source.size;
+
+        BackupManager backupManager(tempDir.filePath("backups"));
+        QDir().mkpath(tempDir.filePath("backups"));
+        BackupManager::Method method = BackupManager::Copy;
+
+        bool isMeasured = measure(&result, repeats, [&backupManager, &filePath, &method, &error]() {
+            QString backupPath;
+            return backupManager.createBackup(filePath, &backupPath, &method, &error);
+        });
+        if (!isMeasured) {
+            err << "Cannot create backup: " << error << Qt::endl;
+        }
+
+        result.extra.insert("method", BackupManager::methodName(method));
+        appendResult(&results, result, isMeasured);
+    }
+
+    if (isSelected("search_build") || isSelected("search_query")) {
+        QString databasePath = tempDir.filePath("cache.db");
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+        db.setDatabaseName(databasePath);
+        bool isOpen = db.open();
+        if (!isOpen) {
+            err << "Cannot open database" << Qt::endl;
+        }
+        QSqlQuery query(db);
+        query.exec("CREATE TABLE IF NOT EXISTS _config (_key VARCHAR (50) PRIMARY KEY, value TEXT NOT NULL)");
+
+        SearchIndex searchIndex(databasePath);
+        JsonLinesModel::Snapshot snapshot = model.snapshot();
+
+        Result build;
+        build.name = "search_build";
+        build.rows = rowCount;
+        build.bytes = source.size;
+
+        // An empty stamp is never reused, every run builds again
+        bool isBuilt = isOpen && measure(&build, isSelected("search_build") ? repeats : 1, [&searchIndex, &snapshot]() {
+            bool isBuilt = false;
+            QEventLoop loop;
+            QObject::connect(&searchIndex, &SearchIndex::buildFinished, &loop, [&loop, &isBuilt](bool built) {
+                isBuilt = built;
+                loop.quit();
+            });
+            searchIndex.rebuild(QString(), snapshot);
+            loop.exec();
+            return isBuilt;
+        });
+
+        if (isOpen && !isBuilt) {
+            err << "Cannot build search index: " << searchIndex.errorString() << Qt::endl;
+        }
+        if (isSelected("search_build")) {
+            appendResult(&results, build, isBuilt);
+        }
+
+        if (isSelected("search_query")) {
+            // Half single words, half two-word queries, ASCII and not
+            QStringList words = isGenerated ? generator.sampleWords(queryCount * 3 / 2 + 1, options.seed + 1) : QStringList();
+            QStringList queries;
+            for (int i = 0; i < queryCount && i < words.size(); i++) {
+                queries.append(i % 2 ? words.at(i) + " " + words.at(queryCount + i / 2) : words.at(i));
+            }
+            if (queries.isEmpty()) {
+                // Words of the user file
+                for (int row = 0; row < snapshot.rowCount() && queries.size() < queryCount; row += qMax(snapshot.rowCount() / queryCount, 1)) {
+                    queries.append(snapshot.rowValues(row).value(JsonLinesModel::ColumnTerm).section(' ', 0, 0));
+                }
+            }
+
+            Result result;
+            result.name = "search_query";
+            result.rows = queries.size();
+
+            qint64 matches = 0;
+            QVector<qint64> queryNsecs;
+
+            // Nothing to query without the index
+            bool isMeasured = isBuilt && !queries.isEmpty() && measure(&result, repeats, [&searchIndex, &queries, &matches, &queryNsecs]() {
+                matches = 0;
+                for (const QString &text : queries) {
+                    QElapsedTimer timer;
+                    timer.start();
+                    QString error;
+                    matches += searchIndex.search(text, &error).size();
+                    if (!error.isEmpty()) {
+                        err << "Search error: " << error << Qt::endl;
+                        return false;
+                    }
+                    queryNsecs.append(timer.nsecsElapsed());
+                }
+                return true;
+            });
+
+            if (isMeasured && !queryNsecs.isEmpty()) {
+                std::sort(queryNsecs.begin(), queryNsecs.end());
+                result.extra.insert("matches", matches);
+                result.extra.insert("query_median_ms", queryNsecs.at(queryNsecs.size() / 2) / 1e6);
+                result.extra.insert("query_p95_ms", queryNsecs.at(queryNsecs.size() * 95 / 100) / 1e6);
+            }
+            appendResult(&results, result, isMeasured);
+        }
+    }
+
+    QJsonObject generatorObject;
+    generatorObject.insert("rows", options.rows);
+    generatorObject.insert("term_length", options.termLength);
+    generatorObject.insert("definition_length", options.definitionLength);
+    generatorObject.insert("unicode", options.unicodeRatio);
+    generatorObject.insert("seed", qint64(options.seed));
+
+    QJsonObject fileObject;
+    fileObject.insert("path", isGenerated ? QString() : filePath);
+    fileObject.insert("generated", isGenerated);
+    fileObject.insert("size", source.size);
+    fileObject.insert("rows", rowCount);
+
+    QJsonObject systemObject;
+    systemObject.insert("version", QString(APP_VERSION));
+    systemObject.insert("qt", QString::fromLatin1(qVersion()));
+    systemObject.insert("cpu", QSysInfo::currentCpuArchitecture());
+    systemObject.insert("os", QSysInfo::prettyProductName());
+    systemObject.insert("threads", QThread::idealThreadCount());
+    systemObject.insert("simd", QString::fromLatin1(LineScanner::simdLevel()));
+
+    QJsonArray resultArray;
+    for (const Result &result : results) {
+        resultArray.append(resultObject(result));
+    }
+
+    QJsonObject report;
+    report.insert("system", systemObject);
+    report.insert("generator", isGenerated ? QJsonValue(generatorObject) : QJsonValue());
+    report.insert("file", fileObject);
+    report.insert("repeats", repeats);
+    report.insert("results", resultArray);
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet("output")) {
+        QSaveFile file(parser.value("output"));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+            err << "Cannot write results: " << file.errorString() << Qt::endl;
+            return 1;
+        }
+    } else {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(json);
+    }
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+QT = core sql concurrent
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = bench_suite
+
+include(../../version.pri)
+
+# core is built by benchmarks.pro next to the benchmarks build directory
+CORE_BUILD_DIR = $$OUT_PWD/../../core
+include(../../core/core.pri)
+
+SOURCES += \
+    datagenerator.cpp \
+    main.cpp
+
+HEADERS += \
+    datagenerator.h
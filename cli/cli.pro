@@ -0,0 +1,17 @@
+QT = core
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = jsonlines-cli
+
+include(../version.pri)
+include(../core/core.pri)
+
+SOURCES += \
+    main.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,12 @@
+#include "core/jsonlinescli.h"
+
+#include <QCoreApplication>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("JsonLinesEditor");
+    QCoreApplication::setApplicationVersion(APP_VERSION);
+
+    return JsonLinesCli::run(a.arguments());
+}
@@ -0,0 +1,491 @@
+#include "backupmanager.h"
+#include "compressedwriter.h"
+#include "tracer.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+
+#include <algorithm>
+#include <cstring>
+
+#include <zstd.h>
+
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+BackupManager::BackupManager(const QString &backupDir)
+    : backupDir(backupDir)
+{
+
+}
+
+void BackupManager::setPolicy(const Policy &policy)
+{
+    this->retention = policy;
+}
+
+BackupManager::Policy BackupManager::policy() const
+{
+    return this->retention;
+}
+
+QString BackupManager::backupBaseName(const QString &filePath)
+{
+    QFileInfo fileInfo(filePath);
+    QString path = fileInfo.exists() ? fileInfo.canonicalFilePath() : fileInfo.absoluteFilePath();
+    QByteArray hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex().left(8);
+
+    return fileInfo.completeBaseName() + "." + fileInfo.suffix() + "." + QString::fromLatin1(hash) + ".bak";
+}
+
+QString BackupManager::methodName(Method method)
+{
+    switch (method) {
+    case Reflink:
+        return "reflink";
+    case Copy:
+        return "copy";
+    case Delta:
+        return "delta";
+    }
+    return "";
+}
+
+bool BackupManager::isDelta(const QString &fileName)
+{
+    return fileName.endsWith(".delta");
+}
+
+int BackupManager::backupNumber(const QString &fileName, const QString &baseName)
+{
+    if (isDelta(fileName)) {
+        return backupNumber(fileName.chopped(6), baseName);
+    }
+
+    if (fileName == baseName) {
+        return 0;
+    }
+
+    if (!fileName.startsWith(baseName + ".")) {
+        return -1;
+    }
+
+    bool isNumber = false;
+    int number = fileName.mid(baseName.size() + 1).toInt(&isNumber);
+
+    return isNumber && number > 0 ? number : -1;
+}
+
+// Backups of one file ordered by number, or all backups ordered by time
+// when baseName is empty. Oldest first.
+QFileInfoList BackupManager::backups(const QString &backupDir, const QString &baseName)
+{
+    QFileInfoList files = QDir(backupDir).entryInfoList({"*.bak", "*.bak.*"}, QDir::Files);
+
+    if (baseName.isEmpty()) {
+        // ctime is the backup time for clones too, mtime is the data time
+        std::sort(files.begin(), files.end(), [](const QFileInfo &a, const QFileInfo &b) {
+            return a.metadataChangeTime() < b.metadataChangeTime();
+        });
+        return files;
+    }
+
+    QFileInfoList result;
+    for (const QFileInfo &file : files) {
+        if (backupNumber(file.fileName(), baseName) >= 0) {
+            result.append(file);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [&baseName](const QFileInfo &a, const QFileInfo &b) {
+        return backupNumber(a.fileName(), baseName) < backupNumber(b.fileName(), baseName);
+    });
+
+    return result;
+}
+
+static bool cloneFile(const QString &filePath, const QString &backupPath)
+{
+#ifdef Q_OS_LINUX
+    QFile source(filePath);
+    QFile target(backupPath);
+
+    if (!source.open(QIODevice::ReadOnly) || !target.open(QIODevice::WriteOnly | QIODevice::NewOnly)) {
+        return false;
+    }
+
+    if (ioctl(target.handle(), FICLONE, source.handle()) == 0) {
+        return true;
+    }
+
+    target.close();
+    target.remove();
+#else
+    Q_UNUSED(filePath);
+    Q_UNUSED(backupPath);
+#endif
+    return false;
+}
+
+static const char deltaMagic[8] = {'J', 'L', 'B', 'D', 'E', 'L', 'T', 'A'};
+static const quint32 deltaVersion = 1;
+static const qint64 compareStep = 1024 * 1024;
+static const qint64 copyStep = 4 * 1024 * 1024;
+
+struct DeltaHeader {
+    QString baseName;           // full backup in the same directory
+    qint64 baseSize = 0;
+    qint64 size = 0;            // of the file backed up
+    qint64 prefix = 0;          // bytes taken from the start of the base
+    qint64 suffix = 0;          // bytes taken from the end of the base
+};
+
+static bool readDeltaHeader(QIODevice *device, DeltaHeader *header)
+{
+    char magic[sizeof(deltaMagic)];
+    if (device->read(magic, sizeof(magic)) != qint64(sizeof(magic)) || memcmp(magic, deltaMagic, sizeof(magic)) != 0) {
+        return false;
+    }
+
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_15);
+
+    quint32 version = 0;
+    stream >> version;
+    if (version != deltaVersion) {
+        return false;
+    }
+
+    stream >> header->baseName >> header->baseSize >> header->size >> header->prefix >> header->suffix;
+
+    return stream.status() == QDataStream::Ok && header->prefix >= 0 && header->suffix >= 0 &&
+           header->prefix + header->suffix <= qMin(header->size, header->baseSize);
+}
+
+// File name of the full backup a delta needs, empty when it cannot be read
+static QString deltaBaseName(const QString &deltaPath)
+{
+    QFile delta(deltaPath);
+    DeltaHeader header;
+
+    if (!delta.open(QIODevice::ReadOnly) || !readDeltaHeader(&delta, &header)) {
+        return QString();
+    }
+
+    return header.baseName;
+}
+
+// False when the file differs too much from the base or on error, a full
+// backup is made then
+static bool writeDelta(const QString &filePath, const QString &basePath, const QString &deltaPath)
+{
+    TraceSpan span("backup delta");
+
+    QFile file(filePath);
+    QFile base(basePath);
+
+    if (!file.open(QIODevice::ReadOnly) || !base.open(QIODevice::ReadOnly) || file.size() == 0 || base.size() == 0) {
+        return false;
+    }
+
+    DeltaHeader header;
+    header.baseName = QFileInfo(basePath).fileName();
+    header.baseSize = base.size();
+    header.size = file.size();
+
+    const uchar *data = file.map(0, header.size);
+    const uchar *baseData = base.map(0, header.baseSize);
+    if (data == nullptr || baseData == nullptr) {
+        return false;
+    }
+
+    // A step at a time, then to the byte in the first step that differs
+    qint64 common = qMin(header.size, header.baseSize);
+    while (header.prefix < common) {
+        qint64 step = qMin(compareStep, common - header.prefix);
+        if (memcmp(data + header.prefix, baseData + header.prefix, size_t(step)) != 0) {
+            while (data[header.prefix] == baseData[header.prefix]) {
+                header.prefix++;
+            }
+            break;
+        }
+        header.prefix += step;
+    }
+
+    while (header.suffix < common - header.prefix) {
+        qint64 step = qMin(compareStep, common - header.prefix - header.suffix);
+        const uchar *end = data + header.size - header.suffix;
+        const uchar *baseEnd = baseData + header.baseSize - header.suffix;
+        if (memcmp(end - step, baseEnd - step, size_t(step)) != 0) {
+            while (end[-1] == baseEnd[-1]) {
+                end--;
+                baseEnd--;
+                header.suffix++;
+            }
+            break;
+        }
+        header.suffix += step;
+    }
+
+    qint64 changed = header.size - header.prefix - header.suffix;
+    if (changed > header.size / 2) {
+        return false;
+    }
+
+    QFile delta(deltaPath);
+    if (!delta.open(QIODevice::WriteOnly | QIODevice::NewOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&delta);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream.writeRawData(deltaMagic, sizeof(deltaMagic));
+    stream << deltaVersion << header.baseName << header.baseSize << header.size << header.prefix << header.suffix;
+
+    CompressedWriter compressor(&delta, CompressedSource::Zstd);
+    bool isWritten = stream.status() == QDataStream::Ok && compressor.open(QIODevice::WriteOnly);
+
+    for (qint64 written = 0; isWritten && written < changed; written += copyStep) {
+        qint64 length = qMin(copyStep, changed - written);
+        isWritten = compressor.write(reinterpret_cast<const char *>(data) + header.prefix + written, length) == length;
+    }
+
+    if (!isWritten || !compressor.finish() || !delta.flush()) {
+        delta.close();
+        delta.remove();
+        return false;
+    }
+
+    return true;
+}
+
+static bool copyBytes(QIODevice *source, qint64 length, QIODevice *target)
+{
+    QByteArray buffer;
+
+    while (length > 0) {
+        buffer = source->read(qMin(copyStep, length));
+        if (buffer.isEmpty() || target->write(buffer) != buffer.size()) {
+            return false;
+        }
+        length -= buffer.size();
+    }
+
+    return true;
+}
+
+// Decompresses the rest of source, false unless it holds length bytes
+static bool decompressBytes(QIODevice *source, qint64 length, QIODevice *target)
+{
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    if (!context) {
+        return false;
+    }
+
+    QByteArray out(qsizetype(ZSTD_DStreamOutSize()), Qt::Uninitialized);
+    qint64 produced = 0;
+    bool isValid = true;
+
+    while (isValid && !source->atEnd()) {
+        QByteArray in = source->read(qint64(ZSTD_DStreamInSize()));
+        ZSTD_inBuffer input = { in.constData(), size_t(in.size()), 0 };
+
+        while (isValid && input.pos < input.size) {
+            ZSTD_outBuffer output = { out.data(), size_t(out.size()), 0 };
+            size_t ret = ZSTD_decompressStream(context, &output, &input);
+
+            isValid = !ZSTD_isError(ret) && target->write(out.constData(), qint64(output.pos)) == qint64(output.pos);
+            produced += qint64(output.pos);
+        }
+    }
+
+    ZSTD_freeDCtx(context);
+
+    return isValid && produced == length;
+}
+
+bool BackupManager::restoreBackup(const QString &backupPath, const QString &targetPath, QString *error)
+{
+    TraceSpan span("backup restore");
+
+    QFile backup(backupPath);
+    if (!backup.open(QIODevice::ReadOnly)) {
+        *error = backup.errorString();
+        return false;
+    }
+
+    QSaveFile target(targetPath);
+    if (!target.open(QIODevice::WriteOnly)) {
+        *error = target.errorString();
+        return false;
+    }
+
+    if (!isDelta(backupPath)) {
+        if (!copyBytes(&backup, backup.size(), &target)) {
+            *error = "Cannot copy backup";
+            return false;
+        }
+    } else {
+        DeltaHeader header;
+        if (!readDeltaHeader(&backup, &header)) {
+            *error = "Not a delta backup";
+            return false;
+        }
+
+        QFile base(QFileInfo(backupPath).dir().absoluteFilePath(header.baseName));
+        if (!base.open(QIODevice::ReadOnly) || base.size() != header.baseSize) {
+            *error = QString("Full backup missing or changed: %1").arg(header.baseName);
+            return false;
+        }
+
+        bool isRestored = copyBytes(&base, header.prefix, &target) &&
+                          decompressBytes(&backup, header.size - header.prefix - header.suffix, &target) &&
+                          base.seek(header.baseSize - header.suffix) &&
+                          copyBytes(&base, header.suffix, &target);
+        if (!isRestored) {
+            *error = "Delta backup is damaged";
+            return false;
+        }
+    }
+
+    if (!target.commit()) {
+        *error = target.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool BackupManager::createBackup(const QString &filePath, QString *backupPath, Method *method, QString *error)
+{
+    TraceSpan span("backup");
+
+    QString baseName = backupBaseName(filePath);
+    QFileInfoList existing = backups(this->backupDir, baseName);
+
+    int number = existing.isEmpty() ? 0 : backupNumber(existing.last().fileName(), baseName) + 1;
+    *backupPath = QDir(this->backupDir).filePath(number == 0 ? baseName : QString("%1.%2").arg(baseName).arg(number));
+
+    if (cloneFile(filePath, *backupPath)) {
+        *method = Reflink;
+        return true;
+    }
+
+    // Against the newest full backup, unless too much changed since
+    for (int i = existing.size() - 1; i >= 0; i--) {
+        if (!isDelta(existing.at(i).fileName())) {
+            if (writeDelta(filePath, existing.at(i).absoluteFilePath(), *backupPath + ".delta")) {
+                *backupPath += ".delta";
+                *method = Delta;
+                return true;
+            }
+            break;
+        }
+    }
+
+    QFile source(filePath);
+    if (source.copy(*backupPath)) {
+        *method = Copy;
+        return true;
+    }
+
+    *error = source.errorString();
+    return false;
+}
+
+// Name of the file a backup belongs to, without the .N counter
+static QString backupGroup(const QString &fileName)
+{
+    QString name = BackupManager::isDelta(fileName) ? fileName.chopped(6) : fileName;
+    int dot = name.lastIndexOf('.');
+    bool isNumber = false;
+    name.mid(dot + 1).toInt(&isNumber);
+
+    return isNumber ? name.left(dot) : name;
+}
+
+// Applies the policy to backups of baseName, or to backups of every file
+// when baseName is empty. The newest backup of a file is always kept.
+int BackupManager::prune(const QString &backupDir, const QString &baseName, const Policy &policy)
+{
+    TraceSpan span("backup prune");
+
+    int removed = 0;
+
+    // Age and size apply to all backups, so the newest of every file is
+    // looked up even when pruning one
+    QStringList groups;
+    for (const QFileInfo &file : backups(backupDir, "")) {
+        QString group = backupGroup(file.fileName());
+        if (!groups.contains(group)) {
+            groups.append(group);
+        }
+    }
+
+    QSet<QString> newest;
+    QSet<QString> removing;             // file names
+
+    for (const QString &group : groups) {
+        QFileInfoList fileBackups = backups(backupDir, group);
+        if (fileBackups.isEmpty()) {
+            continue;
+        }
+        newest.insert(fileBackups.last().fileName());
+
+        if (policy.keepCount <= 0 || (!baseName.isEmpty() && group != baseName)) {
+            continue;
+        }
+
+        for (int i = 0; i < fileBackups.size() - policy.keepCount; i++) {
+            removing.insert(fileBackups.at(i).fileName());
+        }
+    }
+
+    QFileInfoList allBackups = backups(backupDir, "");
+    QDateTime expired = QDateTime::currentDateTime().addDays(-policy.keepDays);
+    qint64 totalSize = 0;
+
+    for (const QFileInfo &file : allBackups) {
+        if (!removing.contains(file.fileName())) {
+            totalSize += file.size();
+        }
+    }
+
+    // Oldest first
+    for (const QFileInfo &file : allBackups) {
+        if (newest.contains(file.fileName()) || removing.contains(file.fileName())) {
+            continue;
+        }
+
+        bool isExpired = policy.keepDays > 0 && file.metadataChangeTime() < expired;
+        bool isOverSize = policy.maxTotalSize > 0 && totalSize > policy.maxTotalSize;
+
+        if (isExpired || isOverSize) {
+            removing.insert(file.fileName());
+            totalSize -= file.size();
+        }
+    }
+
+    // Full backups stay while a delta left needs them
+    QSet<QString> bases;
+    for (const QFileInfo &file : allBackups) {
+        if (isDelta(file.fileName()) && !removing.contains(file.fileName())) {
+            bases.insert(deltaBaseName(file.absoluteFilePath()));
+        }
+    }
+
+    for (const QFileInfo &file : allBackups) {
+        if (removing.contains(file.fileName()) && !bases.contains(file.fileName()) && QFile::remove(file.absoluteFilePath())) {
+            removed++;
+        }
+    }
+
+    return removed;
+}
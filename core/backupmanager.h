@@ -0,0 +1,57 @@
+#ifndef BACKUPMANAGER_H
+#define BACKUPMANAGER_H
+
+#include <QFileInfo>
+#include <QList>
+#include <QString>
+
+// File backups in <cache>/backups/ named <name>.<suffix>.<hash>.bak,
+// .bak.1, ... where hash is a short hash of the absolute path, so files of
+// the same name in other directories keep their own backups. Backups named
+// before that (<name>.<suffix>.bak) are still listed and pruned as a group
+// of their own. A backup is a reflink (FICLONE) where the filesystem
+// supports it. Else it is a delta (.bak.N.delta) against the newest full
+// backup: the bytes before the first and after the last difference are
+// taken from that backup, the ones between are stored zstd compressed.
+// When they are more than half of the file a plain copy is made instead,
+// the next deltas are against it. Never a hard link: programs appending to
+// the file or other editors write to the inode in place and would change
+// the backup too. A full backup is kept while a delta needs it.
+class BackupManager
+{
+public:
+    enum Method {
+        Reflink = 0,
+        Copy,
+        Delta
+    };
+
+    // Zero disables the limit
+    struct Policy {
+        int keepCount = 20;             // per file
+        int keepDays = 30;
+        qint64 maxTotalSize = 0;        // bytes, all backups together
+    };
+
+    explicit BackupManager(const QString &backupDir);
+
+    void setPolicy(const Policy &policy);
+    Policy policy() const;
+
+    bool createBackup(const QString &filePath, QString *backupPath, Method *method, QString *error);
+    // Writes the file a backup holds, a delta applied to its full backup
+    static bool restoreBackup(const QString &backupPath, const QString &targetPath, QString *error);
+
+    static QString backupBaseName(const QString &filePath);
+    static QFileInfoList backups(const QString &backupDir, const QString &baseName);
+    static int backupNumber(const QString &fileName, const QString &baseName);
+    static bool isDelta(const QString &fileName);
+    static int prune(const QString &backupDir, const QString &baseName, const Policy &policy);
+    static QString methodName(Method method);
+
+private:
+    QString backupDir;
+    Policy retention;
+};
+
+#endif // BACKUPMANAGER_H
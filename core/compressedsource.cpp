@@ -0,0 +1,599 @@
+#include "compressedsource.h"
+#include "tracer.h"
+
+#include <QMutexLocker>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+#include <zlib.h>
+#include <zstd.h>
+
+static const int windowSize = 32768;
+// zlib counts input and output in 32 bits
+static const qint64 maxStep = 1 << 30;
+
+// zstd seekable format, see CompressedWriter::writeSeekTable()
+static const quint32 skippableMagic = 0x184D2A5E;
+static const quint32 seekableMagic = 0x8F92EAB1;
+static const qint64 seekFooterSize = 9;
+
+CompressedSource::CompressedSource(Format format, const char *data, qint64 size)
+    : sourceFormat(format)
+    , data(data)
+    , dataSize(size)
+    , spans(cacheSizeMb)
+{
+
+}
+
+CompressedSource::Format CompressedSource::format() const
+{
+    return this->sourceFormat;
+}
+
+bool CompressedSource::isBuilt() const
+{
+    QMutexLocker locker(&this->mutex);
+    return this->isComplete;
+}
+
+qint64 CompressedSource::size() const
+{
+    QMutexLocker locker(&this->mutex);
+    return this->decompressedSize;
+}
+
+CompressedSource::Format CompressedSource::detect(const char *data, qint64 size)
+{
+    if (size >= 2 && uchar(data[0]) == 0x1f && uchar(data[1]) == 0x8b) {
+        return Gzip;
+    }
+
+    // zstd frame, or a skippable frame before one
+    if (size >= 4 && (memcmp(data, "\x28\xB5\x2F\xFD", 4) == 0
+                      || ((uchar(data[0]) & 0xf0) == 0x50 && memcmp(data + 1, "\x2A\x4D\x18", 3) == 0))) {
+        return Zstd;
+    }
+
+    return Plain;
+}
+
+CompressedSource::Format CompressedSource::formatForPath(const QString &filePath)
+{
+    if (filePath.endsWith(".gz", Qt::CaseInsensitive)) {
+        return Gzip;
+    }
+
+    if (filePath.endsWith(".zst", Qt::CaseInsensitive) || filePath.endsWith(".zstd", Qt::CaseInsensitive)) {
+        return Zstd;
+    }
+
+    return Plain;
+}
+
+QString CompressedSource::formatName(Format format)
+{
+    switch (format) {
+    case Gzip:
+        return "gzip";
+    case Zstd:
+        return "zstd";
+    default:
+        return "plain";
+    }
+}
+
+bool CompressedSource::build(const BlockFunction &block, QString *error)
+{
+    TraceSpan span("decompress");
+
+    {
+        QMutexLocker locker(&this->mutex);
+        this->checkpoints.clear();
+        this->spans.clear();
+        this->memory.clear();
+        this->memoryStart = 0;
+        this->isInMemory = false;
+        this->isComplete = false;
+        this->decompressedSize = 0;
+        this->seekableSize = -1;
+    }
+
+    // Frames listed by a seek table can be read at once
+    QVector<Checkpoint> frames;
+    qint64 framesSize = 0;
+    if (this->sourceFormat == Zstd && this->readSeekTable(&frames, &framesSize)) {
+        QMutexLocker locker(&this->mutex);
+        this->checkpoints = frames;
+        this->seekableSize = framesSize;
+    }
+
+    bool isBuilt = this->sourceFormat == Gzip ? this->buildGzip(block, error) : this->buildZstd(block, error);
+
+    QMutexLocker locker(&this->mutex);
+    this->isComplete = isBuilt;
+
+    return isBuilt;
+}
+
+bool CompressedSource::buildGzip(const BlockFunction &block, QString *error)
+{
+    // Output is passed on in blocks, the window before them is kept as
+    // history for the checkpoints
+    QByteArray buffer(windowSize + blockSize, Qt::Uninitialized);
+    char *out = buffer.data();
+    qint64 used = 0;
+    qint64 passed = 0;
+    qint64 totalOut = 0;
+    qint64 lastOut = 0;
+    qint64 in = 0;
+
+    while (in < this->dataSize) {
+        // Members are concatenated, anything else after them is ignored as gzip does
+        if (detect(this->data + in, this->dataSize - in) != Gzip) {
+            if (in == 0) {
+                *error = "Not gzip data";
+                return false;
+            }
+            break;
+        }
+
+        Checkpoint memberStart;
+        memberStart.in = in;
+        memberStart.out = totalOut;
+        this->addCheckpoint(memberStart);
+        lastOut = totalOut;
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+
+        if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+            *error = "Out of memory";
+            return false;
+        }
+
+        int ret = Z_OK;
+        while (ret != Z_STREAM_END) {
+            if (in == this->dataSize) {
+                inflateEnd(&stream);
+                *error = "Unexpected end of compressed data";
+                return false;
+            }
+
+            qint64 space = buffer.size() - used;
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(this->data + in));
+            stream.avail_in = uInt(qMin(this->dataSize - in, maxStep));
+            stream.next_out = reinterpret_cast<Bytef *>(out + used);
+            stream.avail_out = uInt(space);
+
+            // Stops at every deflate block boundary
+            ret = inflate(&stream, Z_BLOCK);
+            if (ret != Z_OK && ret != Z_STREAM_END) {
+                *error = stream.msg ? QString::fromLatin1(stream.msg) : QString("Invalid compressed data");
+                inflateEnd(&stream);
+                return false;
+            }
+
+            qint64 produced = space - stream.avail_out;
+            in = reinterpret_cast<const char *>(stream.next_in) - this->data;
+            used += produced;
+            totalOut += produced;
+
+            // Between blocks and not in the last one: decompression can resume here
+            if (ret == Z_OK && (stream.data_type & 128) && !(stream.data_type & 64) && totalOut - lastOut >= spanSize) {
+                int length = int(qMin(qint64(windowSize), used));
+
+                Checkpoint checkpoint;
+                checkpoint.in = in;
+                checkpoint.out = totalOut;
+                checkpoint.bits = stream.data_type & 7;
+                checkpoint.isRaw = true;
+                checkpoint.window = QByteArray(out + used - length, length);
+                this->addCheckpoint(checkpoint);
+                lastOut = totalOut;
+            }
+
+            if (used == buffer.size()) {
+                if (!block(out + passed, used - passed, in)) {
+                    inflateEnd(&stream);
+                    *error = "Canceled";
+                    return false;
+                }
+
+                memmove(out, out + used - windowSize, windowSize);
+                used = windowSize;
+                passed = windowSize;
+            }
+        }
+
+        inflateEnd(&stream);
+    }
+
+    if (used > passed && !block(out + passed, used - passed, in)) {
+        *error = "Canceled";
+        return false;
+    }
+
+    QMutexLocker locker(&this->mutex);
+    this->decompressedSize = totalOut;
+
+    return true;
+}
+
+bool CompressedSource::buildZstd(const BlockFunction &block, QString *error)
+{
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    if (!context) {
+        *error = "Out of memory";
+        return false;
+    }
+
+    QByteArray buffer(blockSize, Qt::Uninitialized);
+    qint64 used = 0;
+    qint64 totalOut = 0;
+    qint64 in = 0;
+    bool isFrameStart = true;
+
+    while (in < this->dataSize) {
+        if (isFrameStart && this->seekableSize < 0) {
+            Checkpoint checkpoint;
+            checkpoint.in = in;
+            checkpoint.out = totalOut;
+            this->addCheckpoint(checkpoint);
+        }
+        isFrameStart = false;
+
+        ZSTD_inBuffer input = { this->data + in, size_t(qMin(this->dataSize - in, maxStep)), 0 };
+        ZSTD_outBuffer output = { buffer.data() + used, size_t(buffer.size() - used), 0 };
+
+        size_t ret = ZSTD_decompressStream(context, &output, &input);
+        if (ZSTD_isError(ret)) {
+            *error = QString::fromLatin1(ZSTD_getErrorName(ret));
+            ZSTD_freeDCtx(context);
+            return false;
+        }
+
+        in += qint64(input.pos);
+
+        {
+            // Data of the current frame is kept until it ends, all of it
+            // from the first frame too large to decompress on every read
+            QMutexLocker locker(&this->mutex);
+
+            this->memory.append(buffer.constData() + used, qsizetype(output.pos));
+            if (!this->isInMemory && this->memory.size() > maxSpanSize) {
+                this->isInMemory = true;
+            }
+
+            if (ret == 0 && !this->isInMemory) {
+                this->memory.clear();
+                this->memoryStart = totalOut + qint64(output.pos);
+            }
+        }
+
+        used += qint64(output.pos);
+        totalOut += qint64(output.pos);
+
+        // Frame is decoded and flushed
+        if (ret == 0) {
+            isFrameStart = true;
+        }
+
+        if (used == buffer.size()) {
+            if (!block(buffer.constData(), used, in)) {
+                ZSTD_freeDCtx(context);
+                *error = "Canceled";
+                return false;
+            }
+            used = 0;
+        }
+    }
+
+    ZSTD_freeDCtx(context);
+
+    if (!isFrameStart) {
+        *error = "Unexpected end of compressed data";
+        return false;
+    }
+
+    if (this->seekableSize >= 0 && this->seekableSize != totalOut) {
+        *error = "Seek table does not match the compressed data";
+        return false;
+    }
+
+    if (used > 0 && !block(buffer.constData(), used, in)) {
+        *error = "Canceled";
+        return false;
+    }
+
+    QMutexLocker locker(&this->mutex);
+    this->decompressedSize = totalOut;
+
+    return true;
+}
+
+// Frame checkpoints from a seek table ending the data, false when there is
+// none or it does not describe the frames before it
+bool CompressedSource::readSeekTable(QVector<Checkpoint> *checkpoints, qint64 *size) const
+{
+    if (this->dataSize < 8 + seekFooterSize
+            || qFromLittleEndian<quint32>(this->data + this->dataSize - 4) != seekableMagic) {
+        return false;
+    }
+
+    quint32 frameCount = qFromLittleEndian<quint32>(this->data + this->dataSize - seekFooterSize);
+    uchar descriptor = uchar(this->data[this->dataSize - 5]);
+
+    // Reserved bits are zero, the top one adds a checksum to every entry
+    if (frameCount == 0 || (descriptor & 0x7c)) {
+        return false;
+    }
+
+    qint64 entrySize = (descriptor & 0x80) ? 12 : 8;
+    qint64 tableSize = 8 + frameCount * entrySize + seekFooterSize;
+    if (tableSize > this->dataSize) {
+        return false;
+    }
+
+    const char *table = this->data + this->dataSize - tableSize;
+    if (qFromLittleEndian<quint32>(table) != skippableMagic
+            || qFromLittleEndian<quint32>(table + 4) != quint32(tableSize - 8)) {
+        return false;
+    }
+
+    QVector<Checkpoint> frames;
+    frames.reserve(int(frameCount));
+    qint64 in = 0;
+    qint64 out = 0;
+
+    for (quint32 i = 0; i < frameCount; i++) {
+        const char *entry = table + 8 + i * entrySize;
+
+        Checkpoint checkpoint;
+        checkpoint.in = in;
+        checkpoint.out = out;
+
+        // Empty frame: resume at the later one, as addCheckpoint() does
+        if (!frames.isEmpty() && frames.last().out == out) {
+            frames.last() = checkpoint;
+        } else {
+            frames.append(checkpoint);
+        }
+
+        in += qFromLittleEndian<quint32>(entry);
+        out += qFromLittleEndian<quint32>(entry + 4);
+    }
+
+    if (in != this->dataSize - tableSize) {
+        return false;
+    }
+
+    *checkpoints = frames;
+    *size = out;
+
+    return true;
+}
+
+void CompressedSource::setIndex(const QVector<Checkpoint> &checkpoints, qint64 size)
+{
+    QMutexLocker locker(&this->mutex);
+
+    this->checkpoints = checkpoints;
+    this->decompressedSize = size;
+    this->isComplete = true;
+    this->spans.clear();
+    this->memory.clear();
+    this->memoryStart = 0;
+    this->isInMemory = false;
+}
+
+bool CompressedSource::openSeekable()
+{
+    QVector<Checkpoint> frames;
+    qint64 size = 0;
+
+    if (this->sourceFormat != Zstd || !this->readSeekTable(&frames, &size)) {
+        return false;
+    }
+
+    this->setIndex(frames, size);
+
+    return true;
+}
+
+void CompressedSource::addCheckpoint(const Checkpoint &checkpoint)
+{
+    QMutexLocker locker(&this->mutex);
+
+    // Empty member or frame: resume at the later one
+    if (!this->checkpoints.isEmpty() && this->checkpoints.last().out == checkpoint.out) {
+        this->spans.remove(this->checkpoints.size() - 1);
+        this->checkpoints.last() = checkpoint;
+        return;
+    }
+
+    this->checkpoints.append(checkpoint);
+}
+
+QByteArray CompressedSource::read(qint64 offset, qint64 length) const
+{
+    if (offset < 0 || length < 0) {
+        return QByteArray();
+    }
+
+    QByteArray result;
+    result.reserve(qsizetype(length));
+
+    // A range can cross checkpoints
+    while (result.size() < length) {
+        qint64 position = offset + result.size();
+        qint64 remaining = length - result.size();
+
+        {
+            QMutexLocker locker(&this->mutex);
+
+            if (this->isComplete && offset + length > this->decompressedSize) {
+                return QByteArray();
+            }
+
+            if (this->isInMemory && position >= this->memoryStart) {
+                qint64 start = position - this->memoryStart;
+                if (start + remaining > this->memory.size()) {
+                    return QByteArray();
+                }
+                result.append(this->memory.constData() + start, qsizetype(remaining));
+                break;
+            }
+        }
+
+        qint64 start = 0;
+        QByteArray data = this->span(position, offset + length, &start);
+
+        qint64 skip = position - start;
+        if (skip >= data.size()) {
+            return QByteArray();
+        }
+
+        result.append(data.constData() + skip, qsizetype(qMin(data.size() - skip, remaining)));
+    }
+
+    return result;
+}
+
+// Decompressed data from the checkpoint at or before position up to the
+// next one, or while building up to minEnd at least
+QByteArray CompressedSource::span(qint64 position, qint64 minEnd, qint64 *start) const
+{
+    Checkpoint checkpoint;
+    qint64 end = -1;
+    int index = 0;
+
+    {
+        QMutexLocker locker(&this->mutex);
+
+        auto found = std::upper_bound(this->checkpoints.constBegin(), this->checkpoints.constEnd(), position,
+                                      [](qint64 value, const Checkpoint &checkpoint) {
+            return value < checkpoint.out;
+        });
+
+        if (found == this->checkpoints.constBegin()) {
+            return QByteArray();
+        }
+
+        index = int(found - this->checkpoints.constBegin()) - 1;
+        checkpoint = this->checkpoints.at(index);
+        *start = checkpoint.out;
+
+        if (QByteArray *cached = this->spans.object(index)) {
+            return *cached;
+        }
+
+        if (index + 1 < this->checkpoints.size()) {
+            end = this->checkpoints.at(index + 1).out;
+        } else if (this->isComplete) {
+            end = this->decompressedSize;
+        } else if (this->seekableSize >= 0) {
+            end = this->seekableSize;
+        }
+    }
+
+    bool isWhole = end >= 0;
+    qint64 length = (isWhole ? end : minEnd) - checkpoint.out;
+
+    QByteArray data = this->sourceFormat == Gzip ? this->decompressGzip(checkpoint, length)
+                                                 : this->decompressZstd(checkpoint, length);
+
+    if (isWhole && data.size() == length) {
+        QMutexLocker locker(&this->mutex);
+        this->spans.insert(index, new QByteArray(data), qMax(1, int(data.size() / (1024 * 1024))));
+    }
+
+    return data;
+}
+
+QByteArray CompressedSource::decompressGzip(const Checkpoint &checkpoint, qint64 length) const
+{
+    TraceSpan span("decompress span");
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    int ret = Z_OK;
+
+    if (checkpoint.isRaw) {
+        ret = inflateInit2(&stream, -15);
+        if (ret == Z_OK && checkpoint.bits > 0) {
+            ret = inflatePrime(&stream, checkpoint.bits, uchar(this->data[checkpoint.in - 1]) >> (8 - checkpoint.bits));
+        }
+        if (ret == Z_OK) {
+            ret = inflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(checkpoint.window.constData()),
+                                       uInt(checkpoint.window.size()));
+        }
+    } else {
+        ret = inflateInit2(&stream, 15 + 16);
+    }
+
+    if (ret != Z_OK) {
+        inflateEnd(&stream);
+        return QByteArray();
+    }
+
+    QByteArray out(qsizetype(length), Qt::Uninitialized);
+    qint64 in = checkpoint.in;
+    qint64 produced = 0;
+
+    while (produced < length && in < this->dataSize) {
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(this->data + in));
+        stream.avail_in = uInt(qMin(this->dataSize - in, maxStep));
+        stream.next_out = reinterpret_cast<Bytef *>(out.data() + produced);
+        stream.avail_out = uInt(qMin(length - produced, maxStep));
+
+        ret = inflate(&stream, Z_NO_FLUSH);
+
+        in = reinterpret_cast<const char *>(stream.next_in) - this->data;
+        produced = reinterpret_cast<char *>(stream.next_out) - out.data();
+
+        if (ret != Z_OK) {
+            break;
+        }
+    }
+
+    inflateEnd(&stream);
+    out.truncate(qsizetype(produced));
+
+    return out;
+}
+
+QByteArray CompressedSource::decompressZstd(const Checkpoint &checkpoint, qint64 length) const
+{
+    TraceSpan span("decompress span");
+
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    if (!context) {
+        return QByteArray();
+    }
+
+    QByteArray out(qsizetype(length), Qt::Uninitialized);
+    qint64 in = checkpoint.in;
+    qint64 produced = 0;
+
+    while (produced < length && in < this->dataSize) {
+        ZSTD_inBuffer input = { this->data + in, size_t(qMin(this->dataSize - in, maxStep)), 0 };
+        ZSTD_outBuffer output = { out.data() + produced, size_t(length - produced), 0 };
+
+        size_t ret = ZSTD_decompressStream(context, &output, &input);
+        if (ZSTD_isError(ret)) {
+            break;
+        }
+
+        in += qint64(input.pos);
+        produced += qint64(output.pos);
+    }
+
+    ZSTD_freeDCtx(context);
+    out.truncate(qsizetype(produced));
+
+    return out;
+}
@@ -0,0 +1,98 @@
+#ifndef COMPRESSEDSOURCE_H
+#define COMPRESSEDSOURCE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+// Random access to gzip and zstd compressed data. build() decompresses the
+// whole data once, in order, and records checkpoints where decompression
+// can restart: every gzip member and zstd frame start, and a deflate block
+// boundary every spanSize bytes inside a gzip member, with the 32 KB window
+// needed to resume there (as zlib's zran example does). read() then
+// decompresses only from the nearest checkpoint and keeps recent spans in a
+// cache. zstd frames cannot be entered in the middle, from the first frame
+// larger than maxSpanSize the decompressed data is kept in memory, a file
+// compressed as one frame is then held whole. Files written by
+// CompressedWriter are made of small independent members or frames and
+// need no windows; the seek table of the zstd seekable format at their end
+// gives all frame checkpoints before build() starts. Reads are thread safe
+// and allowed while build() runs, for data it has already passed on or
+// that a seek table lists.
+class CompressedSource
+{
+public:
+    enum Format {
+        Plain = 0,
+        Gzip,
+        Zstd
+    };
+
+    struct Checkpoint {
+        qint64 in = 0;              // compressed offset, next byte to read
+        qint64 out = 0;             // decompressed offset
+        int bits = 0;               // gzip: bits of the byte before in not read yet
+        bool isRaw = false;         // gzip: inside a deflate stream, window holds its history
+        QByteArray window;
+    };
+
+    // Gets decompressed data in order, inputPos is the compressed offset
+    // reached. Returning false stops build().
+    typedef std::function<bool(const char *data, qint64 length, qint64 inputPos)> BlockFunction;
+
+    static const qint64 blockSize = 4 * 1024 * 1024;
+    static const qint64 spanSize = 4 * 1024 * 1024;
+    static const qint64 maxSpanSize = 64 * 1024 * 1024;
+    static const int cacheSizeMb = 64;
+
+    // data must stay valid while the source is used
+    CompressedSource(Format format, const char *data, qint64 size);
+
+    Format format() const;
+    bool isBuilt() const;
+    qint64 size() const;            // decompressed size, once built
+
+    bool build(const BlockFunction &block, QString *error);
+    // Checkpoints known from writing the data, instead of build()
+    void setIndex(const QVector<Checkpoint> &checkpoints, qint64 size);
+    // Checkpoints from the seek table, instead of build(). False when the
+    // data has none.
+    bool openSeekable();
+
+    // Empty when the range is out of the data
+    QByteArray read(qint64 offset, qint64 length) const;
+
+    static Format detect(const char *data, qint64 size);
+    // By file name extension
+    static Format formatForPath(const QString &filePath);
+    static QString formatName(Format format);
+
+private:
+    bool buildGzip(const BlockFunction &block, QString *error);
+    bool buildZstd(const BlockFunction &block, QString *error);
+    bool readSeekTable(QVector<Checkpoint> *checkpoints, qint64 *size) const;
+    void addCheckpoint(const Checkpoint &checkpoint);
+    QByteArray span(qint64 position, qint64 minEnd, qint64 *start) const;
+    QByteArray decompressGzip(const Checkpoint &checkpoint, qint64 length) const;
+    QByteArray decompressZstd(const Checkpoint &checkpoint, qint64 length) const;
+
+    Format sourceFormat;
+    const char *data;
+    qint64 dataSize;
+
+    mutable QMutex mutex;
+    QVector<Checkpoint> checkpoints;
+    qint64 decompressedSize = 0;
+    bool isComplete = false;
+    qint64 seekableSize = -1;       // zstd: decompressed size listed by the seek table
+    QByteArray memory;              // zstd: decompressed data from memoryStart
+    qint64 memoryStart = 0;
+    bool isInMemory = false;
+    mutable QCache<int, QByteArray> spans;
+};
+
+#endif // COMPRESSEDSOURCE_H
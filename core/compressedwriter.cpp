@@ -0,0 +1,206 @@
+#include "compressedwriter.h"
+#include "tracer.h"
+
+#include <QThread>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <cstring>
+
+#include <zlib.h>
+#include <zstd.h>
+
+static void appendLittleEndian(QByteArray &out, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 4);
+}
+
+CompressedWriter::CompressedWriter(QIODevice *device, CompressedSource::Format format, QObject *parent)
+    : QIODevice(parent)
+    , device(device)
+    , format(format)
+{
+    this->block.reserve(blockSize);
+}
+
+CompressedWriter::~CompressedWriter()
+{
+    for (PendingBlock &pending : this->pendingBlocks) {
+        pending.future.waitForFinished();
+    }
+}
+
+bool CompressedWriter::isSequential() const
+{
+    return true;
+}
+
+QVector<CompressedSource::Checkpoint> CompressedWriter::checkpoints() const
+{
+    return this->writtenBlocks;
+}
+
+qint64 CompressedWriter::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+
+    return -1;
+}
+
+qint64 CompressedWriter::writeData(const char *data, qint64 length)
+{
+    qint64 taken = 0;
+
+    while (taken < length) {
+        qint64 part = qMin(length - taken, blockSize - this->block.size());
+        this->block.append(data + taken, qsizetype(part));
+        taken += part;
+
+        if (this->block.size() == blockSize && !this->submitBlock()) {
+            return -1;
+        }
+    }
+
+    return length;
+}
+
+bool CompressedWriter::submitBlock()
+{
+    QByteArray data;
+    data.swap(this->block);
+    this->block.reserve(blockSize);
+
+    CompressedSource::Format format = this->format;
+
+    PendingBlock pending;
+    pending.length = data.size();
+    pending.future = QtConcurrent::run([format, data]() {
+        return compressBlock(format, data);
+    });
+    this->pendingBlocks.append(pending);
+
+    // Enough blocks in flight to keep every thread busy
+    while (this->pendingBlocks.size() > QThread::idealThreadCount() * 2) {
+        if (!this->writeNextBlock()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CompressedWriter::writeNextBlock()
+{
+    PendingBlock pending = this->pendingBlocks.takeFirst();
+    QByteArray compressed = pending.future.result();
+
+    if (compressed.isEmpty()) {
+        this->setErrorString("Compression failed");
+        return false;
+    }
+
+    if (this->device->write(compressed) != compressed.size()) {
+        this->setErrorString(this->device->errorString());
+        return false;
+    }
+
+    CompressedSource::Checkpoint checkpoint;
+    checkpoint.in = this->compressedPos;
+    checkpoint.out = this->uncompressedPos;
+    this->writtenBlocks.append(checkpoint);
+    this->compressedSizes.append(compressed.size());
+
+    this->compressedPos += compressed.size();
+    this->uncompressedPos += pending.length;
+
+    return true;
+}
+
+bool CompressedWriter::finish()
+{
+    if (!this->block.isEmpty() && !this->submitBlock()) {
+        return false;
+    }
+
+    while (!this->pendingBlocks.isEmpty()) {
+        if (!this->writeNextBlock()) {
+            return false;
+        }
+    }
+
+    if (this->format == CompressedSource::Zstd && !this->writtenBlocks.isEmpty()) {
+        return this->writeSeekTable();
+    }
+
+    return true;
+}
+
+// Skippable frame listing the frame sizes, readers ignore it unless they
+// know the seekable format
+bool CompressedWriter::writeSeekTable()
+{
+    QByteArray table;
+    int frameCount = this->writtenBlocks.size();
+
+    appendLittleEndian(table, 0x184D2A5E);
+    appendLittleEndian(table, quint32(frameCount * 8 + 9));
+
+    for (int i = 0; i < frameCount; i++) {
+        qint64 nextOut = i + 1 < frameCount ? this->writtenBlocks.at(i + 1).out : this->uncompressedPos;
+        appendLittleEndian(table, quint32(this->compressedSizes.at(i)));
+        appendLittleEndian(table, quint32(nextOut - this->writtenBlocks.at(i).out));
+    }
+
+    appendLittleEndian(table, quint32(frameCount));
+    table.append(char(0));
+    appendLittleEndian(table, 0x8F92EAB1);
+
+    if (this->device->write(table) != table.size()) {
+        this->setErrorString(this->device->errorString());
+        return false;
+    }
+
+    this->compressedPos += table.size();
+
+    return true;
+}
+
+QByteArray CompressedWriter::compressBlock(CompressedSource::Format format, const QByteArray &data)
+{
+    TraceSpan span("compress block");
+
+    QByteArray out;
+
+    if (format == CompressedSource::Zstd) {
+        out.resize(qsizetype(ZSTD_compressBound(size_t(data.size()))));
+        size_t length = ZSTD_compress(out.data(), size_t(out.size()), data.constData(), size_t(data.size()), zstdLevel);
+        if (ZSTD_isError(length)) {
+            return QByteArray();
+        }
+        out.truncate(qsizetype(length));
+        return out;
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (deflateInit2(&stream, gzipLevel, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return QByteArray();
+    }
+
+    out.resize(qsizetype(deflateBound(&stream, uLong(data.size()))));
+
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    stream.avail_in = uInt(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = uInt(out.size());
+
+    int ret = deflate(&stream, Z_FINISH);
+    out.truncate(qsizetype(stream.total_out));
+    deflateEnd(&stream);
+
+    return ret == Z_STREAM_END ? out : QByteArray();
+}
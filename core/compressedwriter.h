@@ -0,0 +1,61 @@
+#ifndef COMPRESSEDWRITER_H
+#define COMPRESSEDWRITER_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QIODevice>
+#include <QVector>
+
+#include "compressedsource.h"
+
+// Compressing output device. Written data is cut in blocks compressed on
+// the global thread pool as independent gzip members or zstd frames, and
+// written to the device in order, so any block start is a checkpoint for
+// CompressedSource. zstd output ends with a seek table in the zstd
+// seekable format. Few blocks are in flight at once, memory use stays
+// bounded whatever the file size.
+class CompressedWriter : public QIODevice
+{
+public:
+    static const qint64 blockSize = 4 * 1024 * 1024;
+    static const int gzipLevel = 6;
+    static const int zstdLevel = 3;
+
+    CompressedWriter(QIODevice *device, CompressedSource::Format format, QObject *parent = nullptr);
+    ~CompressedWriter();
+
+    bool isSequential() const override;
+
+    // Compresses and writes what is left, call before committing the device
+    bool finish();
+
+    // Start of every block written
+    QVector<CompressedSource::Checkpoint> checkpoints() const;
+
+    static QByteArray compressBlock(CompressedSource::Format format, const QByteArray &data);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 length) override;
+
+private:
+    struct PendingBlock {
+        QFuture<QByteArray> future;
+        qint64 length = 0;
+    };
+
+    bool submitBlock();
+    bool writeNextBlock();
+    bool writeSeekTable();
+
+    QIODevice *device;
+    CompressedSource::Format format;
+    QByteArray block;
+    QVector<PendingBlock> pendingBlocks;
+    QVector<CompressedSource::Checkpoint> writtenBlocks;
+    QVector<qint64> compressedSizes;
+    qint64 compressedPos = 0;
+    qint64 uncompressedPos = 0;
+};
+
+#endif // COMPRESSEDWRITER_H
@@ -0,0 +1,23 @@
+# Links the core static library, included by targets using it
+
+QT += sql concurrent
+
+INCLUDEPATH += $$PWD/..
+DEPENDPATH += $$PWD
+
+# Build directory of core, a sibling of the target's one unless set before
+isEmpty(CORE_BUILD_DIR): CORE_BUILD_DIR = $$OUT_PWD/../core
+
+win32:CONFIG(release, debug|release): CORE_LIB_DIR = $$CORE_BUILD_DIR/release
+else:win32:CONFIG(debug, debug|release): CORE_LIB_DIR = $$CORE_BUILD_DIR/debug
+else: CORE_LIB_DIR = $$CORE_BUILD_DIR
+
+LIBS += -L$$CORE_LIB_DIR -ljsonlines-core
+
+# zlib and zstd for compressed files
+unix: CONFIG += link_pkgconfig
+unix: PKGCONFIG += zlib libzstd
+win32: LIBS += -lz -lzstd
+
+win32-g++|!win32: PRE_TARGETDEPS += $$CORE_LIB_DIR/libjsonlines-core.a
+else: PRE_TARGETDEPS += $$CORE_LIB_DIR/jsonlines-core.lib
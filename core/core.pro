@@ -0,0 +1,64 @@
+QT = core sql concurrent
+
+TEMPLATE = lib
+CONFIG += staticlib c++11
+
+TARGET = jsonlines-core
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# zlib and zstd for compressed files
+unix: CONFIG += link_pkgconfig
+unix: PKGCONFIG += zlib libzstd
+
+SOURCES += \
+    backupmanager.cpp \
+    compressedsource.cpp \
+    compressedwriter.cpp \
+    duplicatefinder.cpp \
+    edithistory.cpp \
+    editlog.cpp \
+    journal.cpp \
+    jsonlinescli.cpp \
+    jsonlinescolumns.cpp \
+    jsonlinesfiltermodel.cpp \
+    jsonlinesindex.cpp \
+    jsonlinesloader.cpp \
+    jsonlinesmodel.cpp \
+    jsonlinesparser.cpp \
+    jsonlinesprocessor.cpp \
+    jsonlinesschema.cpp \
+    jsonlineswriter.cpp \
+    linescanner.cpp \
+    rowfilter.cpp \
+    rowsorter.cpp \
+    rowvalidator.cpp \
+    searchindex.cpp \
+    tracer.cpp
+
+HEADERS += \
+    backupmanager.h \
+    compressedsource.h \
+    compressedwriter.h \
+    duplicatefinder.h \
+    edithistory.h \
+    editlog.h \
+    journal.h \
+    jsonlinescli.h \
+    jsonlinescolumns.h \
+    jsonlinesfiltermodel.h \
+    jsonlinesindex.h \
+    jsonlinesloader.h \
+    jsonlinesmodel.h \
+    jsonlinesparser.h \
+    jsonlinesprocessor.h \
+    jsonlinesschema.h \
+    jsonlineswriter.h \
+    linescanner.h \
+    rowfilter.h \
+    rowsorter.h \
+    rowvalidator.h \
+    searchindex.h \
+    tracer.h
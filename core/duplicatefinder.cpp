@@ -0,0 +1,251 @@
+#include "duplicatefinder.h"
+#include "tracer.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QSet>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <algorithm>
+
+DuplicateFinder::DuplicateFinder(QObject *parent)
+    : QObject(parent)
+{
+    connect(&this->watcher, &QFutureWatcher<QVector<Entry>>::finished, this, &DuplicateFinder::hashingFinished);
+}
+
+QString DuplicateFinder::fieldsName(Fields fields)
+{
+    switch (fields) {
+    case TermPair:
+        return "Term + original term";
+    case Definition:
+        return "Definition";
+    case AllFields:
+        return "All fields";
+    }
+    return "";
+}
+
+quint64 DuplicateFinder::hashValues(const QStringList &values, Fields fields)
+{
+    QVector<int> columns;
+
+    switch (fields) {
+    case TermPair:
+        columns = {JsonLinesModel::ColumnTerm, JsonLinesModel::ColumnTermOrig};
+        break;
+    case Definition:
+        columns = {JsonLinesModel::ColumnDefinition};
+        break;
+    case AllFields:
+        for (int column = 0; column < JsonLinesModel::ColumnCount; column++) {
+            columns.append(column);
+        }
+        break;
+    }
+
+    QByteArray data;
+    bool isEmpty = true;
+
+    for (int column : columns) {
+        QString value = values.value(column).trimmed();
+        if (!value.isEmpty()) {
+            isEmpty = false;
+        }
+        data.append(value.toUtf8());
+        data.append('\x1f');
+    }
+
+    if (isEmpty) {
+        return 0;
+    }
+
+    QByteArray digest = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+    // Zero marks rows left out
+    return qMax(qFromLittleEndian<quint64>(digest.constData()), quint64(1));
+}
+
+QVector<DuplicateFinder::Entry> DuplicateFinder::hashRows(const JsonLinesModel::Snapshot &snapshot, Fields fields)
+{
+    TraceSpan span("duplicate hash");
+
+    QVector<Entry> entries(snapshot.rowCount());
+    QVector<int> chunks;
+
+    for (int first = 0; first < snapshot.rowCount(); first += chunkRows) {
+        chunks.append(first);
+    }
+
+    QtConcurrent::blockingMap(chunks, [&snapshot, &entries, fields](int first) {
+        int last = qMin(first + chunkRows, snapshot.rowCount());
+        for (int row = first; row < last; row++) {
+            entries[row].hash = hashValues(snapshot.rowValues(row), fields);
+            entries[row].key = snapshot.rowKey(row);
+        }
+    });
+
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry &entry) {
+        return entry.hash == 0;
+    }), entries.end());
+
+    std::sort(entries.begin(), entries.end());
+
+    return entries;
+}
+
+void DuplicateFinder::start(const JsonLinesModel::Snapshot &snapshot, Fields fields)
+{
+    this->clear();
+
+    this->currentFields = fields;
+    this->startedMs = QDateTime::currentMSecsSinceEpoch();
+
+    this->watcher.setFuture(QtConcurrent::run([snapshot, fields]() {
+        return hashRows(snapshot, fields);
+    }));
+}
+
+void DuplicateFinder::clear()
+{
+    // Result of a running pass is dropped: empty future is canceled
+    this->watcher.setFuture(QFuture<QVector<Entry>>());
+
+    this->entries.clear();
+    this->pendingUpdates.clear();
+    this->isComputed = false;
+}
+
+bool DuplicateFinder::isRunning() const
+{
+    return this->watcher.isRunning();
+}
+
+bool DuplicateFinder::hasResult() const
+{
+    return this->isComputed;
+}
+
+DuplicateFinder::Fields DuplicateFinder::fields() const
+{
+    return this->currentFields;
+}
+
+void DuplicateFinder::hashingFinished()
+{
+    if (this->watcher.future().isCanceled() || this->watcher.future().resultCount() == 0) {
+        return;
+    }
+
+    this->entries = this->watcher.result();
+    this->isComputed = true;
+
+    // Edits made while hashing, in order: undo can restore a removed row
+    // under its old key
+    QVector<PendingUpdate> updates = this->pendingUpdates;
+    this->pendingUpdates.clear();
+
+    for (const PendingUpdate &update : updates) {
+        if (!update.removedKeys.isEmpty()) {
+            this->removeKeys(update.removedKeys);
+        } else {
+            this->updateRow(update.oldKey, update.oldValues, update.newKey, update.newValues);
+        }
+    }
+
+    emit finished(QDateTime::currentMSecsSinceEpoch() - this->startedMs);
+}
+
+void DuplicateFinder::removeEntry(quint64 hash, qint64 key)
+{
+    Entry entry = {hash, key};
+    QVector<Entry>::iterator it = std::lower_bound(this->entries.begin(), this->entries.end(), entry);
+
+    if (it != this->entries.end() && it->hash == hash && it->key == key) {
+        this->entries.erase(it);
+    }
+}
+
+void DuplicateFinder::insertEntry(quint64 hash, qint64 key)
+{
+    Entry entry = {hash, key};
+    this->entries.insert(std::lower_bound(this->entries.begin(), this->entries.end(), entry), entry);
+}
+
+void DuplicateFinder::updateRow(qint64 oldKey, const QStringList &oldValues, qint64 newKey, const QStringList &newValues)
+{
+    if (this->isRunning()) {
+        this->pendingUpdates.append({oldKey, oldValues, newKey, newValues, QVector<qint64>()});
+        return;
+    }
+
+    if (!this->isComputed) {
+        return;
+    }
+
+    quint64 oldHash = hashValues(oldValues, this->currentFields);
+    if (oldHash != 0) {
+        this->removeEntry(oldHash, oldKey);
+    }
+
+    quint64 newHash = hashValues(newValues, this->currentFields);
+    if (newHash != 0) {
+        this->insertEntry(newHash, newKey);
+    }
+}
+
+void DuplicateFinder::removeKeys(const QVector<qint64> &keys)
+{
+    if (this->isRunning()) {
+        if (!keys.isEmpty()) {
+            this->pendingUpdates.append({0, QStringList(), 0, QStringList(), keys});
+        }
+        return;
+    }
+
+    QSet<qint64> removed(keys.constBegin(), keys.constEnd());
+
+    this->entries.erase(std::remove_if(this->entries.begin(), this->entries.end(), [&removed](const Entry &entry) {
+        return removed.contains(entry.key);
+    }), this->entries.end());
+}
+
+QVector<DuplicateFinder::Group> DuplicateFinder::groups() const
+{
+    QVector<Group> groups;
+
+    int i = 0;
+    while (i < this->entries.size()) {
+        int last = i;
+        while (last + 1 < this->entries.size() && this->entries.at(last + 1).hash == this->entries.at(i).hash) {
+            last++;
+        }
+
+        if (last > i) {
+            Group group;
+            group.hash = this->entries.at(i).hash;
+            for (int j = i; j <= last; j++) {
+                group.keys.append(this->entries.at(j).key);
+            }
+            groups.append(group);
+        }
+
+        i = last + 1;
+    }
+
+    return groups;
+}
+
+int DuplicateFinder::duplicateCount() const
+{
+    int count = 0;
+
+    for (int i = 1; i < this->entries.size(); i++) {
+        if (this->entries.at(i).hash == this->entries.at(i - 1).hash) {
+            count++;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,90 @@
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include "jsonlinesmodel.h"
+
+// Exact duplicate detection over a choice of fields. Every row is hashed
+// (first 64 bits of MD5 over the trimmed field values) on the thread pool,
+// the (hash, row key) pairs are kept sorted by hash so duplicates are
+// adjacent. Edits update the sorted list in place. Row keys are
+// JsonLinesModel::rowKey(), rows with all chosen fields empty are left out.
+class DuplicateFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Fields {
+        TermPair = 0,           // term + original_term
+        Definition,             // definition
+        AllFields
+    };
+
+    struct Entry {
+        quint64 hash;
+        qint64 key;
+
+        bool operator<(const Entry &other) const
+        {
+            return this->hash < other.hash || (this->hash == other.hash && this->key < other.key);
+        }
+    };
+
+    struct Group {
+        quint64 hash = 0;
+        QVector<qint64> keys;   // ascending
+    };
+
+    static const int chunkRows = 16384;
+
+    explicit DuplicateFinder(QObject *parent = nullptr);
+
+    void start(const JsonLinesModel::Snapshot &snapshot, Fields fields);
+    void clear();
+    bool isRunning() const;
+    bool hasResult() const;
+    Fields fields() const;
+
+    void updateRow(qint64 oldKey, const QStringList &oldValues, qint64 newKey, const QStringList &newValues);
+    void removeKeys(const QVector<qint64> &keys);
+
+    QVector<Group> groups() const;
+    int duplicateCount() const;             // rows beyond the first of each group
+
+    static QString fieldsName(Fields fields);
+    static quint64 hashValues(const QStringList &values, Fields fields);
+    static QVector<Entry> hashRows(const JsonLinesModel::Snapshot &snapshot, Fields fields);
+
+signals:
+    void finished(qint64 elapsedMs);
+
+private slots:
+    void hashingFinished();
+
+private:
+    // Row update, or removal of removedKeys when not empty
+    struct PendingUpdate {
+        qint64 oldKey;
+        QStringList oldValues;
+        qint64 newKey;
+        QStringList newValues;
+        QVector<qint64> removedKeys;
+    };
+
+    void removeEntry(quint64 hash, qint64 key);
+    void insertEntry(quint64 hash, qint64 key);
+
+    Fields currentFields = TermPair;
+    QVector<Entry> entries;
+    bool isComputed = false;
+
+    QFutureWatcher<QVector<Entry>> watcher;
+    qint64 startedMs = 0;
+    QVector<PendingUpdate> pendingUpdates;     // in the order made
+};
+
+#endif // DUPLICATEFINDER_H
@@ -0,0 +1,193 @@
+#include "edithistory.h"
+
+// Per edit overhead besides the text: the Edit itself and its list slot
+static const qint64 editOverhead = 128;
+static const qint64 keyOverhead = 64;
+
+qint64 EditHistory::Edit::cost() const
+{
+    qint64 bytes = editOverhead + (this->oldText.size() + this->newText.size()) * qint64(sizeof(QChar));
+
+    for (const QString &value : this->content.values) {
+        bytes += value.size() * qint64(sizeof(QChar)) + keyOverhead;
+    }
+
+    for (QJsonObject::const_iterator it = this->content.otherKeys.constBegin(); it != this->content.otherKeys.constEnd(); ++it) {
+        bytes += (it.key().size() + JsonLinesSchema::valueText(it.value()).size()) * qint64(sizeof(QChar)) + keyOverhead;
+    }
+
+    return bytes;
+}
+
+EditHistory::EditHistory()
+{
+
+}
+
+void EditHistory::setMemoryLimit(qint64 bytes)
+{
+    this->limit = bytes;
+    this->trim();
+}
+
+qint64 EditHistory::memoryLimit() const
+{
+    return this->limit;
+}
+
+qint64 EditHistory::memoryUsed() const
+{
+    return this->usedBytes;
+}
+
+void EditHistory::beginStep(const QString &name)
+{
+    if (this->depth++ == 0) {
+        this->current = Step();
+        this->current.name = name;
+    }
+}
+
+void EditHistory::record(const Edit &edit)
+{
+    // Outside of a step the edit is a step of its own
+    if (this->depth == 0) {
+        this->beginStep("Edit");
+        this->record(edit);
+        this->endStep();
+        return;
+    }
+
+    this->current.edits.append(edit);
+    this->current.cost += edit.cost();
+}
+
+void EditHistory::recordFields(int row, const QStringList &oldValues, const QStringList &newValues)
+{
+    int count = qMax(oldValues.size(), newValues.size());
+
+    for (int column = 0; column < count; column++) {
+        QString oldText = oldValues.value(column);
+        QString newText = newValues.value(column);
+
+        if (oldText != newText) {
+            Edit edit;
+            edit.type = Edit::SetField;
+            edit.row = row;
+            edit.column = column;
+            edit.oldText = oldText;
+            edit.newText = newText;
+            this->record(edit);
+        }
+    }
+}
+
+bool EditHistory::endStep(Step *ended)
+{
+    if (this->depth == 0 || --this->depth > 0) {
+        return true;
+    }
+
+    Step step = this->current;
+    this->current = Step();
+
+    if (ended != nullptr) {
+        *ended = step;
+    }
+
+    if (step.edits.isEmpty()) {
+        return true;
+    }
+
+    // A new change makes the undone steps unreachable
+    for (const Step &redoStep : this->redoSteps) {
+        this->usedBytes -= redoStep.cost;
+    }
+    this->redoSteps.clear();
+
+    // Alone over the limit: the step is lost, and the earlier ones with it
+    // since their row numbers may no longer match the rows
+    if (this->limit > 0 && step.cost > this->limit) {
+        for (const Step &undoStep : this->undoSteps) {
+            this->usedBytes -= undoStep.cost;
+        }
+        this->undoSteps.clear();
+        return false;
+    }
+
+    this->undoSteps.append(step);
+    this->usedBytes += step.cost;
+    this->trim();
+
+    return true;
+}
+
+bool EditHistory::canUndo() const
+{
+    return !this->undoSteps.isEmpty();
+}
+
+bool EditHistory::canRedo() const
+{
+    return !this->redoSteps.isEmpty();
+}
+
+QString EditHistory::undoName() const
+{
+    return this->undoSteps.isEmpty() ? QString() : this->undoSteps.last().name;
+}
+
+QString EditHistory::redoName() const
+{
+    return this->redoSteps.isEmpty() ? QString() : this->redoSteps.last().name;
+}
+
+EditHistory::Step EditHistory::takeUndo()
+{
+    if (this->undoSteps.isEmpty()) {
+        return Step();
+    }
+
+    Step step = this->undoSteps.takeLast();
+    this->redoSteps.append(step);
+
+    return step;
+}
+
+EditHistory::Step EditHistory::takeRedo()
+{
+    if (this->redoSteps.isEmpty()) {
+        return Step();
+    }
+
+    Step step = this->redoSteps.takeLast();
+    this->undoSteps.append(step);
+
+    return step;
+}
+
+void EditHistory::clear()
+{
+    this->undoSteps.clear();
+    this->redoSteps.clear();
+    this->current = Step();
+    this->depth = 0;
+    this->usedBytes = 0;
+}
+
+// Zero limit keeps everything
+void EditHistory::trim()
+{
+    if (this->limit <= 0) {
+        return;
+    }
+
+    // Oldest undo steps first, then the redo steps farthest away
+    while (this->usedBytes > this->limit && !this->undoSteps.isEmpty()) {
+        this->usedBytes -= this->undoSteps.takeFirst().cost;
+    }
+
+    while (this->usedBytes > this->limit && !this->redoSteps.isEmpty()) {
+        this->usedBytes -= this->redoSteps.takeFirst().cost;
+    }
+}
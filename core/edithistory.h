@@ -0,0 +1,85 @@
+#ifndef EDITHISTORY_H
+#define EDITHISTORY_H
+
+#include <QString>
+#include <QVector>
+
+#include "jsonlinesmodel.h"
+
+// Undo and redo stacks of compact edits. A step holds only what changed:
+// the changed fields of a row with their old and new text, or the content
+// of an inserted or removed row. Rows are addressed by row number, which
+// is exact since steps are undone and redone in order. Edits recorded
+// between beginStep() and endStep() make one step, so bulk operations are
+// undone at once. The oldest steps are dropped when the stacks use more
+// than the memory limit. A step larger than the limit by itself is not
+// kept and clears the undo stack, as the row numbers of the earlier steps
+// would no longer be exact. The caller applies the edits: in order to
+// redo a step, in reverse order to undo it.
+class EditHistory
+{
+public:
+    struct Edit {
+        enum Type {
+            SetField = 0,
+            InsertRow,
+            RemoveRow
+        };
+
+        Type type = SetField;
+        int row = 0;
+        int column = 0;                         // SetField
+        QString oldText;
+        QString newText;
+        JsonLinesModel::RowContent content;     // InsertRow, RemoveRow
+
+        qint64 cost() const;                    // approximate bytes in memory
+    };
+
+    struct Step {
+        QString name;
+        QVector<Edit> edits;
+        qint64 cost = 0;
+    };
+
+    static const qint64 defaultMemoryLimit = 64 * 1024 * 1024;
+
+    EditHistory();
+
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const;
+    qint64 memoryUsed() const;
+
+    // Steps can nest, the outermost one is recorded
+    void beginStep(const QString &name);
+    void record(const Edit &edit);
+    // Field edits for the columns that differ
+    void recordFields(int row, const QStringList &oldValues, const QStringList &newValues);
+    // false when the step alone is larger than the memory limit and was
+    // dropped with all earlier steps.
+    // ended gets the step that the outermost endStep() closed, kept or not.
+    bool endStep(Step *ended = nullptr);
+
+    bool canUndo() const;
+    bool canRedo() const;
+    QString undoName() const;
+    QString redoName() const;
+
+    // Moves the step to the other stack and returns it
+    Step takeUndo();
+    Step takeRedo();
+
+    void clear();
+
+private:
+    void trim();
+
+    QVector<Step> undoSteps;
+    QVector<Step> redoSteps;
+    Step current;
+    int depth = 0;
+    qint64 usedBytes = 0;
+    qint64 limit = defaultMemoryLimit;
+};
+
+#endif // EDITHISTORY_H
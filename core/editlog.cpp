@@ -0,0 +1,329 @@
+#include "editlog.h"
+#include "compressedsource.h"
+#include "jsonlinesindex.h"
+#include "tracer.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariantList>
+
+// Inserted row content as JSON, the other keys as they are. A raw row is
+// the number of its bad line, the same when the file is loaded again.
+static QString encodeContent(const JsonLinesModel::RowContent &content)
+{
+    QJsonObject object;
+    object.insert("values", QJsonArray::fromStringList(content.values));
+    if (!content.otherKeys.isEmpty()) {
+        object.insert("other", content.otherKeys);
+    }
+    if (content.badLine >= 0) {
+        object.insert("bad", content.badLine);
+    }
+
+    return QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
+static JsonLinesModel::RowContent decodeContent(const QString &text)
+{
+    QJsonObject object = QJsonDocument::fromJson(text.toUtf8()).object();
+    JsonLinesModel::RowContent content;
+
+    for (const QJsonValue &value : object.value("values").toArray()) {
+        content.values.append(value.toString());
+    }
+    content.otherKeys = object.value("other").toObject();
+    content.badLine = object.value("bad").toInt(-1);
+
+    return content;
+}
+
+// Size and fingerprint of the whole file, or of its first baseSize bytes
+// when baseSize is given
+static bool fileFingerprint(const QString &filePath, qint64 baseSize, qint64 *size, QByteArray *fingerprint,
+                            bool *isAppendable, QString *error)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = file.errorString();
+        return false;
+    }
+
+    *size = file.size();
+    qint64 length = baseSize >= 0 ? baseSize : *size;
+
+    if (length > *size) {
+        *error = "File is shorter than when it was edited";
+        return false;
+    }
+
+    if (length == 0) {
+        *fingerprint = JsonLinesIndex::makeFingerprint(nullptr, 0);
+        *isAppendable = true;
+        return true;
+    }
+
+    const char *data = reinterpret_cast<const char *>(file.map(0, length));
+    if (data == nullptr) {
+        *error = file.errorString();
+        return false;
+    }
+
+    *fingerprint = JsonLinesIndex::makeFingerprint(data, length);
+    // Lines appended after a complete last line keep the row numbers,
+    // compressed data cannot be extended that way
+    *isAppendable = data[length - 1] == '\n' && CompressedSource::detect(data, length) == CompressedSource::Plain;
+
+    return true;
+}
+
+EditLog::EditLog()
+{
+
+}
+
+bool EditLog::open(QString *error)
+{
+    QSqlQuery query(QSqlDatabase::database());
+
+    if (!query.exec("CREATE TABLE IF NOT EXISTS _edit_log_base (file TEXT PRIMARY KEY, size INTEGER NOT NULL, fingerprint BLOB NOT NULL)") ||
+            !query.exec("CREATE TABLE IF NOT EXISTS _edit_log (id INTEGER PRIMARY KEY, file TEXT NOT NULL, type INTEGER NOT NULL, "
+                        "row INTEGER NOT NULL, col INTEGER NOT NULL, value TEXT)") ||
+            !query.exec("CREATE INDEX IF NOT EXISTS _edit_log_file ON _edit_log (file, id)")) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+bool EditLog::start(const QString &filePath, QString *error)
+{
+    TraceSpan span("edit log start");
+
+    this->stop();
+
+    qint64 size = 0;
+    QByteArray fingerprint;
+    bool isAppendable = false;
+    if (!fileFingerprint(filePath, -1, &size, &fingerprint, &isAppendable, error)) {
+        return false;
+    }
+
+    this->discard(filePath);
+
+    QSqlQuery query(QSqlDatabase::database());
+    query.prepare("INSERT INTO _edit_log_base (file, size, fingerprint) VALUES (:file, :size, :fingerprint)");
+    query.bindValue(":file", filePath);
+    query.bindValue(":size", size);
+    query.bindValue(":fingerprint", fingerprint);
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    this->currentFile = filePath;
+
+    return true;
+}
+
+void EditLog::resume(const QString &filePath)
+{
+    this->pending.clear();
+    this->currentFile = filePath;
+}
+
+void EditLog::stop()
+{
+    if (!this->currentFile.isEmpty()) {
+        this->discard(this->currentFile);
+    }
+
+    this->currentFile.clear();
+    this->pending.clear();
+}
+
+QString EditLog::filePath() const
+{
+    return this->currentFile;
+}
+
+// Undo runs the edits backwards with their effect inverted
+void EditLog::append(const QVector<EditHistory::Edit> &edits, bool isUndo)
+{
+    if (this->currentFile.isEmpty()) {
+        return;
+    }
+
+    int count = edits.size();
+
+    for (int i = 0; i < count; i++) {
+        const EditHistory::Edit &edit = edits.at(isUndo ? count - 1 - i : i);
+
+        EditHistory::Edit entry;
+        entry.row = edit.row;
+        entry.column = edit.column;
+
+        if (edit.type == EditHistory::Edit::SetField) {
+            entry.type = EditHistory::Edit::SetField;
+            entry.newText = isUndo ? edit.oldText : edit.newText;
+        } else if ((edit.type == EditHistory::Edit::InsertRow) != isUndo) {
+            entry.type = EditHistory::Edit::InsertRow;
+            entry.content = edit.content;
+        } else {
+            entry.type = EditHistory::Edit::RemoveRow;
+        }
+
+        this->pending.append(entry);
+    }
+}
+
+int EditLog::pendingCount() const
+{
+    return this->pending.size();
+}
+
+bool EditLog::flush(QString *error)
+{
+    if (this->pending.isEmpty()) {
+        return true;
+    }
+
+    TraceSpan span("edit log flush");
+
+    QVariantList files;
+    QVariantList types;
+    QVariantList rows;
+    QVariantList columns;
+    QVariantList values;
+
+    for (const EditHistory::Edit &edit : this->pending) {
+        files.append(this->currentFile);
+        types.append(int(edit.type));
+        rows.append(edit.row);
+        columns.append(edit.column);
+        switch (edit.type) {
+        case EditHistory::Edit::SetField:
+            values.append(edit.newText);
+            break;
+        case EditHistory::Edit::InsertRow:
+            values.append(encodeContent(edit.content));
+            break;
+        case EditHistory::Edit::RemoveRow:
+            values.append(QString());
+            break;
+        }
+    }
+
+    // One transaction for the batch, a commit is one WAL append
+    QSqlDatabase db = QSqlDatabase::database();
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO _edit_log (file, type, row, col, value) VALUES (?, ?, ?, ?, ?)");
+    query.addBindValue(files);
+    query.addBindValue(types);
+    query.addBindValue(rows);
+    query.addBindValue(columns);
+    query.addBindValue(values);
+
+    if (!query.execBatch()) {
+        *error = query.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    if (!db.commit()) {
+        *error = db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    this->pending.clear();
+
+    return true;
+}
+
+QStringList EditLog::loggedFiles() const
+{
+    QStringList files;
+
+    QSqlQuery query(QSqlDatabase::database());
+    if (query.exec("SELECT DISTINCT file FROM _edit_log ORDER BY file")) {
+        while (query.next()) {
+            files.append(query.value(0).toString());
+        }
+    }
+
+    return files;
+}
+
+bool EditLog::read(const QString &filePath, QVector<EditHistory::Edit> *edits, QString *error) const
+{
+    TraceSpan span("edit log read");
+
+    QSqlQuery query(QSqlDatabase::database());
+    query.prepare("SELECT size, fingerprint FROM _edit_log_base WHERE file = :file");
+    query.bindValue(":file", filePath);
+    if (!query.exec() || !query.first()) {
+        *error = "Edit log has no base";
+        return false;
+    }
+
+    qint64 baseSize = query.value(0).toLongLong();
+    QByteArray baseFingerprint = query.value(1).toByteArray();
+
+    qint64 size = 0;
+    QByteArray fingerprint;
+    bool isAppendable = false;
+    if (!fileFingerprint(filePath, baseSize, &size, &fingerprint, &isAppendable, error)) {
+        return false;
+    }
+
+    if (fingerprint != baseFingerprint || (size > baseSize && !isAppendable)) {
+        *error = "File was changed since it was edited";
+        return false;
+    }
+
+    query.prepare("SELECT type, row, col, value FROM _edit_log WHERE file = :file ORDER BY id");
+    query.bindValue(":file", filePath);
+    if (!query.exec()) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        EditHistory::Edit edit;
+        edit.type = EditHistory::Edit::Type(query.value(0).toInt());
+        edit.row = query.value(1).toInt();
+        edit.column = query.value(2).toInt();
+        if (edit.type == EditHistory::Edit::SetField) {
+            edit.newText = query.value(3).toString();
+        } else if (edit.type == EditHistory::Edit::InsertRow) {
+            edit.content = decodeContent(query.value(3).toString());
+        }
+        edits->append(edit);
+    }
+
+    return true;
+}
+
+void EditLog::discard(const QString &filePath)
+{
+    QSqlDatabase db = QSqlDatabase::database();
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM _edit_log WHERE file = :file");
+    query.bindValue(":file", filePath);
+    query.exec();
+    query.prepare("DELETE FROM _edit_log_base WHERE file = :file");
+    query.bindValue(":file", filePath);
+    query.exec();
+
+    db.commit();
+}
@@ -0,0 +1,52 @@
+#ifndef EDITLOG_H
+#define EDITLOG_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "edithistory.h"
+
+// Write-ahead log of the edits made to the opened file, in the cache
+// database (tables _edit_log and _edit_log_base). Every committed edit is
+// logged as what it does to the rows: set a field, insert a row, remove a
+// row, undone steps as their inverse. Edits are buffered and written by
+// flush() in one transaction. The base is the file as it was when the log
+// was started, its size and fingerprint (JsonLinesIndex::makeFingerprint);
+// the entries are replayed against a file still starting with the base,
+// lines appended since move no row. Saving the file starts the log again.
+class EditLog
+{
+public:
+    static const int batchSize = 1000;
+
+    EditLog();
+
+    bool open(QString *error);
+
+    // Logs edits of filePath from now on against the file as it is now,
+    // its earlier entries and those of the previous file are dropped
+    bool start(const QString &filePath, QString *error);
+    // Keeps the entries of filePath and adds to them
+    void resume(const QString &filePath);
+    // Drops the entries of the current file and logs nothing more
+    void stop();
+    QString filePath() const;
+
+    void append(const QVector<EditHistory::Edit> &edits, bool isUndo = false);
+    int pendingCount() const;
+    bool flush(QString *error);
+
+    // Files with entries left by an earlier run
+    QStringList loggedFiles() const;
+    // Entries in order as edits to redo. false when the file does not
+    // start with the base anymore and the entries cannot be replayed.
+    bool read(const QString &filePath, QVector<EditHistory::Edit> *edits, QString *error) const;
+    void discard(const QString &filePath);
+
+private:
+    QString currentFile;
+    QVector<EditHistory::Edit> pending;
+};
+
+#endif // EDITLOG_H
@@ -0,0 +1,192 @@
+#include "journal.h"
+
+#include <QDateTime>
+#include <QDir>
+
+QString Journal::Entry::text() const
+{
+    return QDateTime::fromMSecsSinceEpoch(this->time).toString("[hh:mm:ss] ") + this->message;
+}
+
+Journal::Journal()
+{
+
+}
+
+Journal::~Journal()
+{
+    this->stopFileSink();
+}
+
+quint64 Journal::append(const QString &message)
+{
+    Entry entry;
+    entry.time = QDateTime::currentMSecsSinceEpoch();
+    entry.message = message;
+
+    QMutexLocker locker(&this->mutex);
+
+    entry.id = this->nextId++;
+
+    if (this->ring.size() < capacity) {
+        this->ring.append(entry);
+    } else {
+        this->ring[this->next] = entry;
+        this->next = (this->next + 1) % capacity;
+    }
+
+    this->appended.wakeOne();
+
+    return entry.id;
+}
+
+quint64 Journal::lastId() const
+{
+    QMutexLocker locker(&this->mutex);
+    return this->nextId - 1;
+}
+
+QVector<Journal::Entry> Journal::entriesAfter(quint64 id) const
+{
+    QMutexLocker locker(&this->mutex);
+
+    QVector<Entry> entries;
+    if (this->ring.isEmpty()) {
+        return entries;
+    }
+
+    // Ids in the ring are consecutive, oldest at next
+    quint64 firstId = this->ring.at(this->next % this->ring.size()).id;
+    quint64 lastId = this->nextId - 1;
+    quint64 from = qMax(id + 1, firstId);
+
+    entries.reserve(int(lastId >= from ? lastId - from + 1 : 0));
+    for (quint64 entryId = from; entryId <= lastId; entryId++) {
+        entries.append(this->ring.at(int((this->next + (entryId - firstId)) % this->ring.size())));
+    }
+
+    return entries;
+}
+
+bool Journal::startFileSink(const QString &logDir, QString *error)
+{
+    this->stopFileSink();
+
+    if (!QDir().mkpath(logDir)) {
+        *error = QString("Cannot create directory: %1").arg(logDir);
+        return false;
+    }
+
+    this->logDir = logDir;
+    this->logFile.setFileName(QDir(logDir).filePath(QDateTime::currentDateTime().toString("yyyy-MM-dd") + ".log"));
+
+    if (!this->logFile.open(QIODevice::Append | QIODevice::Text)) {
+        *error = this->logFile.errorString();
+        return false;
+    }
+
+    QString header = QString("\n======================%1======================\n").
+            arg(QDateTime::currentDateTime().toString("[hh:mm:ss] "));
+    this->logFile.write(header.toUtf8());
+
+    this->isStopping = false;
+    this->sinkThread = QThread::create([this]() {
+        this->runSink();
+    });
+    this->sinkThread->start();
+
+    return true;
+}
+
+void Journal::flush()
+{
+    QMutexLocker locker(&this->mutex);
+
+    while (this->sinkThread && this->writtenId < this->nextId - 1) {
+        this->appended.wakeOne();
+        this->written.wait(&this->mutex);
+    }
+}
+
+void Journal::stopFileSink()
+{
+    if (!this->sinkThread) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&this->mutex);
+        this->isStopping = true;
+        this->appended.wakeOne();
+    }
+
+    this->sinkThread->wait();
+    delete this->sinkThread;
+    this->sinkThread = nullptr;
+
+    this->logFile.close();
+}
+
+// Runs on the sink thread
+void Journal::runSink()
+{
+    while (true) {
+        QVector<Entry> entries;
+        quint64 skipped = 0;
+        bool isLast = false;
+
+        {
+            QMutexLocker locker(&this->mutex);
+
+            while (!this->isStopping && this->writtenId == this->nextId - 1) {
+                this->appended.wait(&this->mutex);
+            }
+
+            isLast = this->isStopping;
+        }
+
+        entries = this->entriesAfter(this->writtenId);
+        if (!entries.isEmpty()) {
+            // The sink fell behind by more than the ring holds
+            skipped = entries.first().id - this->writtenId - 1;
+            this->writeEntries(entries, skipped);
+        }
+
+        {
+            QMutexLocker locker(&this->mutex);
+            if (!entries.isEmpty()) {
+                this->writtenId = entries.last().id;
+            }
+            this->written.wakeAll();
+        }
+
+        if (isLast && this->writtenId == this->lastId()) {
+            break;
+        }
+    }
+}
+
+bool Journal::writeEntries(const QVector<Entry> &entries, quint64 skipped)
+{
+    QString fileName = QDir(this->logDir).filePath(QDateTime::currentDateTime().toString("yyyy-MM-dd") + ".log");
+
+    // New day, new file
+    if (this->logFile.fileName() != fileName) {
+        this->logFile.close();
+        this->logFile.setFileName(fileName);
+        if (!this->logFile.open(QIODevice::Append | QIODevice::Text)) {
+            return false;
+        }
+    }
+
+    QByteArray data;
+    if (skipped > 0) {
+        data.append(QString("... %1 entries not written\n").arg(skipped).toUtf8());
+    }
+    for (const Entry &entry : entries) {
+        data.append(entry.text().toUtf8());
+        data.append('\n');
+    }
+
+    return this->logFile.write(data) == data.size() && this->logFile.flush();
+}
@@ -0,0 +1,61 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+// Session journal. Entries are kept in a bounded ring in memory, append()
+// only takes a short lock and never touches the disk or the UI, so it can
+// be called per row and from any thread. Once startFileSink() is called a
+// background thread appends new entries to <logDir>/yyyy-MM-dd.log as they
+// arrive, starting with the entries logged before. Readers poll
+// entriesAfter() with the id of the last entry they have seen.
+class Journal
+{
+public:
+    struct Entry {
+        quint64 id = 0;             // increasing from 1
+        qint64 time = 0;            // ms since epoch
+        QString message;
+
+        QString text() const;       // [hh:mm:ss] message
+    };
+
+    static const int capacity = 10000;
+
+    Journal();
+    ~Journal();
+
+    quint64 append(const QString &message);
+    quint64 lastId() const;
+    // Entries still in the ring with id greater than the given one
+    QVector<Entry> entriesAfter(quint64 id) const;
+
+    bool startFileSink(const QString &logDir, QString *error);
+    // Waits until the sink has written every entry appended so far
+    void flush();
+    void stopFileSink();
+
+private:
+    void runSink();
+    bool writeEntries(const QVector<Entry> &entries, quint64 skipped);
+
+    mutable QMutex mutex;
+    QWaitCondition appended;
+    QWaitCondition written;
+    QVector<Entry> ring;
+    int next = 0;                   // slot of the next entry once full
+    quint64 nextId = 1;
+
+    QString logDir;
+    QFile logFile;
+    QThread *sinkThread = nullptr;
+    quint64 writtenId = 0;
+    bool isStopping = false;
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,190 @@
+#include "jsonlinescli.h"
+#include "backupmanager.h"
+#include "jsonlinesmodel.h"
+#include "jsonlinesprocessor.h"
+#include "tracer.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <cstdio>
+#include <cstring>
+
+static const char *modeOptions[] = {"--validate", "--stats", "--normalize", "--dedupe", "--restore-backup"};
+
+bool JsonLinesCli::isCliArguments(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        for (const char *mode : modeOptions) {
+            if (strcmp(argv[i], mode) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int JsonLinesCli::run(const QStringList &arguments)
+{
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Batch processing of JSON Lines files");
+    QCommandLineOption helpOption = parser.addHelpOption();
+    QCommandLineOption versionOption = parser.addVersionOption();
+
+    QCommandLineOption validateOption("validate", "Check every line, report invalid ones.");
+    QCommandLineOption statsOption("stats", "Print row and field statistics.");
+    QCommandLineOption normalizeOption("normalize", "Write rows re-encoded with trimmed values, empty rows dropped.");
+    QCommandLineOption dedupeOption("dedupe", "Write only the first row of each group of duplicates.");
+    QCommandLineOption fieldsOption("dedupe-fields", "Fields compared by --dedupe: term, definition or all (default).", "fields", "all");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Output file, - for stdout.", "file");
+    QCommandLineOption blockOption("block-size", "Input block size in MB (default 64).", "mb", "64");
+    QCommandLineOption traceOption("trace", "Write timing spans as Chrome trace JSON.", "file");
+    QCommandLineOption restoreOption("restore-backup", "Write the file a backup holds to the output, a delta backup applied to its full backup.");
+
+    parser.addOptions({validateOption, statsOption, normalizeOption, dedupeOption, fieldsOption, outputOption, blockOption, traceOption,
+                       restoreOption});
+    parser.addPositionalArgument("input", "Input JSON Lines file, - for stdin.");
+
+    if (!parser.parse(arguments)) {
+        err << parser.errorText() << Qt::endl;
+        return 2;
+    }
+
+    if (parser.isSet(helpOption)) {
+        parser.showHelp(0);
+    }
+    if (parser.isSet(versionOption)) {
+        parser.showVersion();
+    }
+
+    if (parser.positionalArguments().size() != 1) {
+        err << "Exactly one input file expected" << Qt::endl;
+        return 2;
+    }
+
+    if (parser.isSet(restoreOption)) {
+        QString outputPath = parser.value(outputOption);
+        QString error;
+
+        if (outputPath.isEmpty() || outputPath == "-") {
+            err << "Output file is required for --restore-backup" << Qt::endl;
+            return 2;
+        }
+        if (!BackupManager::restoreBackup(parser.positionalArguments().first(), outputPath, &error)) {
+            err << "Cannot restore backup: " << error << Qt::endl;
+            return 2;
+        }
+        return 0;
+    }
+
+    JsonLinesProcessor::Options options;
+    options.normalize = parser.isSet(normalizeOption);
+    options.dedupe = parser.isSet(dedupeOption);
+    options.blockSize = qMax(1LL, parser.value(blockOption).toLongLong()) * 1024 * 1024;
+
+    QString fields = parser.value(fieldsOption);
+    if (fields == "term") {
+        options.dedupeFields = DuplicateFinder::TermPair;
+    } else if (fields == "definition") {
+        options.dedupeFields = DuplicateFinder::Definition;
+    } else if (fields == "all") {
+        options.dedupeFields = DuplicateFinder::AllFields;
+    } else {
+        err << "Unknown --dedupe-fields value: " << fields << Qt::endl;
+        return 2;
+    }
+
+    bool isWriting = options.normalize || options.dedupe;
+    if (isWriting && !parser.isSet(outputOption)) {
+        err << "Output file is required for --normalize and --dedupe" << Qt::endl;
+        return 2;
+    }
+
+    QString inputPath = parser.positionalArguments().first();
+    QFile input(inputPath);
+    bool isInputOpen = inputPath == "-" ? input.open(stdin, QIODevice::ReadOnly) : input.open(QIODevice::ReadOnly);
+    if (!isInputOpen) {
+        err << "Cannot open file: " << inputPath << ": " << input.errorString() << Qt::endl;
+        return 2;
+    }
+
+    // Written to a temporary file and renamed on success, like saving
+    QString outputPath = parser.value(outputOption);
+    QFile stdoutFile;
+    QSaveFile outputFile(outputPath);
+    QIODevice *output = nullptr;
+
+    if (isWriting) {
+        if (outputPath == "-") {
+            stdoutFile.open(stdout, QIODevice::WriteOnly);
+            output = &stdoutFile;
+        } else if (outputFile.open(QIODevice::WriteOnly)) {
+            output = &outputFile;
+        } else {
+            err << "Cannot write file: " << outputPath << ": " << outputFile.errorString() << Qt::endl;
+            return 2;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    JsonLinesProcessor processor(options);
+    JsonLinesProcessor::Stats stats;
+    QString error;
+
+    if (!processor.run(&input, output, &stats, &error)) {
+        err << "Processing failed: " << error << Qt::endl;
+        return 2;
+    }
+
+    if (output == &outputFile && !outputFile.commit()) {
+        err << "Cannot write file: " << outputPath << ": " << outputFile.errorString() << Qt::endl;
+        return 2;
+    }
+
+    for (const JsonLinesParser::Error &lineError : stats.errors) {
+        err << "Line " << lineError.lineNumber << ": " << lineError.message << Qt::endl;
+    }
+    if (stats.invalidRows > stats.errors.size()) {
+        err << "... " << stats.invalidRows - stats.errors.size() << " more invalid rows" << Qt::endl;
+    }
+
+    if (parser.isSet(statsOption)) {
+        // Keep stdout clean when data goes there
+        FILE *statsFile = output == &stdoutFile ? stderr : stdout;
+        QTextStream out(statsFile);
+
+        out << "bytes: " << stats.bytes << Qt::endl;
+        out << "lines: " << stats.lines << Qt::endl;
+        out << "rows: " << stats.rows << Qt::endl;
+        out << "invalid rows: " << stats.invalidRows << Qt::endl;
+        out << "empty rows: " << stats.emptyRows << Qt::endl;
+
+        for (int column = 0; column < stats.fields.size(); column++) {
+            const JsonLinesProcessor::FieldStats &field = stats.fields.at(column);
+            out << JsonLinesModel::fieldKeys().at(column) << ": filled " << field.filled
+                << ", average length " << QString::number(field.filled > 0 ? double(field.length) / field.filled : 0.0, 'f', 1)
+                << Qt::endl;
+        }
+    }
+
+    double seconds = qMax(timer.elapsed(), qint64(1)) / 1000.0;
+
+    err << QString("%1 rows, %2 invalid").arg(stats.rows).arg(stats.invalidRows);
+    if (isWriting) {
+        err << QString(", %1 written, %2 duplicates").arg(stats.writtenRows).arg(stats.duplicateRows);
+    }
+    err << QString(" in %1 s, %2 MB/s").arg(seconds, 0, 'f', 2).arg(stats.bytes / seconds / (1024 * 1024), 0, 'f', 1) << Qt::endl;
+
+    if (parser.isSet(traceOption) && !Tracer::writeChromeTrace(parser.value(traceOption), &error)) {
+        err << "Cannot write trace: " << error << Qt::endl;
+    }
+
+    return stats.invalidRows > 0 ? 1 : 0;
+}
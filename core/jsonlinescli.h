@@ -0,0 +1,18 @@
+#ifndef JSONLINESCLI_H
+#define JSONLINESCLI_H
+
+#include <QStringList>
+
+// Command line mode, runs on QCoreApplication without widgets:
+//   jsonlines-editor --validate|--stats|--normalize|--dedupe in.jsonl -o out.jsonl
+//   jsonlines-editor --restore-backup data.jsonl.<hash>.bak.3.delta -o data.jsonl
+// Input and output can be "-" for stdin and stdout. Exit code is 0 on
+// success, 1 when the input has invalid rows, 2 on usage or I/O errors.
+class JsonLinesCli
+{
+public:
+    static bool isCliArguments(int argc, char *argv[]);
+    static int run(const QStringList &arguments);
+};
+
+#endif // JSONLINESCLI_H
@@ -0,0 +1,125 @@
+#include "jsonlinescolumns.h"
+
+JsonLinesColumns::JsonLinesColumns(int columnCount)
+    : columns(columnCount)
+{
+
+}
+
+int JsonLinesColumns::rowCount() const
+{
+    return this->rows;
+}
+
+int JsonLinesColumns::columnCount() const
+{
+    return this->columns.size();
+}
+
+int JsonLinesColumns::append(const QStringList &values)
+{
+    int row = this->rows++;
+
+    for (Column &column : this->columns) {
+        column.offsets.append(column.arena.size());
+        column.lengths.append(0);
+    }
+
+    this->setValues(row, values);
+
+    return row;
+}
+
+void JsonLinesColumns::replace(int row, const QStringList &values)
+{
+    if (row < 0 || row >= this->rows) {
+        return;
+    }
+
+    for (const Column &column : this->columns) {
+        this->liveBytes -= column.lengths.at(row);
+    }
+
+    this->setValues(row, values);
+
+    // Rewritten when more than half of the arenas are replaced values
+    if (this->arenaBytes > 1024 * 1024 && this->arenaBytes > 2 * this->liveBytes) {
+        this->compact();
+    }
+}
+
+void JsonLinesColumns::setValues(int row, const QStringList &values)
+{
+    for (int i = 0; i < this->columns.size(); i++) {
+        Column &column = this->columns[i];
+        QByteArray value = values.value(i).toUtf8();
+
+        column.offsets[row] = column.arena.size();
+        column.lengths[row] = quint32(value.size());
+        column.arena.append(value);
+
+        this->arenaBytes += value.size();
+        this->liveBytes += value.size();
+    }
+}
+
+QString JsonLinesColumns::value(int row, int column) const
+{
+    if (row < 0 || row >= this->rows || column < 0 || column >= this->columns.size()) {
+        return QString();
+    }
+
+    const Column &data = this->columns.at(column);
+    return QString::fromUtf8(data.arena.constData() + data.offsets.at(row), data.lengths.at(row));
+}
+
+QStringList JsonLinesColumns::rowValues(int row) const
+{
+    QStringList values;
+
+    if (row < 0 || row >= this->rows) {
+        return values;
+    }
+
+    values.reserve(this->columns.size());
+    for (int column = 0; column < this->columns.size(); column++) {
+        values.append(this->value(row, column));
+    }
+
+    return values;
+}
+
+void JsonLinesColumns::clear()
+{
+    this->columns = QVector<Column>(this->columns.size());
+    this->rows = 0;
+    this->arenaBytes = 0;
+    this->liveBytes = 0;
+}
+
+qint64 JsonLinesColumns::arenaSize() const
+{
+    return this->arenaBytes;
+}
+
+void JsonLinesColumns::compact()
+{
+    for (Column &column : this->columns) {
+        QByteArray arena;
+        qint64 size = 0;
+        for (quint32 length : column.lengths) {
+            size += length;
+        }
+        arena.reserve(size);
+
+        for (int row = 0; row < this->rows; row++) {
+            qint64 offset = arena.size();
+            arena.append(column.arena.constData() + column.offsets.at(row), column.lengths.at(row));
+            column.offsets[row] = offset;
+        }
+
+        column.arena = arena;
+    }
+
+    this->arenaBytes = this->liveBytes;
+}
@@ -0,0 +1,48 @@
+#ifndef JSONLINESCOLUMNS_H
+#define JSONLINESCOLUMNS_H
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+
+// Column-wise storage of rows kept in memory (edited and inserted ones).
+// Every column is one contiguous UTF-8 arena with offset and length arrays:
+// 12 bytes per value plus its UTF-8 text, instead of a QString allocation
+// with UTF-16 text per value. Replacing a row appends the new values, the
+// old bytes stay in the arena until it is compacted. Members are implicitly
+// shared, so copies for snapshots are cheap.
+class JsonLinesColumns
+{
+public:
+    explicit JsonLinesColumns(int columnCount = 0);
+
+    int rowCount() const;
+    int columnCount() const;
+
+    // Missing values are empty, extra ones are dropped
+    int append(const QStringList &values);
+    void replace(int row, const QStringList &values);
+
+    QString value(int row, int column) const;
+    QStringList rowValues(int row) const;
+
+    void clear();
+    qint64 arenaSize() const;       // bytes, replaced values too
+
+private:
+    struct Column {
+        QByteArray arena;
+        QVector<qint64> offsets;
+        QVector<quint32> lengths;
+    };
+
+    void setValues(int row, const QStringList &values);
+    void compact();
+
+    QVector<Column> columns;
+    int rows = 0;
+    qint64 arenaBytes = 0;
+    qint64 liveBytes = 0;
+};
+
+#endif // JSONLINESCOLUMNS_H
@@ -0,0 +1,398 @@
+#include "jsonlinesfiltermodel.h"
+
+#include <QDateTime>
+#include <QtConcurrent>
+
+JsonLinesFilterModel::JsonLinesFilterModel(JsonLinesModel *model, QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , model(model)
+{
+    // Before the base class connections, see the class comment
+    connect(model, &QAbstractItemModel::rowsInserted, this, &JsonLinesFilterModel::sourceRowsInserted);
+    connect(model, &QAbstractItemModel::rowsRemoved, this, &JsonLinesFilterModel::sourceRowsRemoved);
+    connect(model, &QAbstractItemModel::dataChanged, this, &JsonLinesFilterModel::sourceDataChanged);
+    connect(model, &QAbstractItemModel::modelReset, this, &JsonLinesFilterModel::sourceModelReset);
+    connect(model, &JsonLinesModel::rowListRemoved, this, &JsonLinesFilterModel::sourceRowListRemoved);
+    connect(model, &JsonLinesModel::rowListInserted, this, &JsonLinesFilterModel::sourceRowListInserted);
+
+    connect(&this->watcher, &QFutureWatcher<RowFilter::Bits>::finished, this, &JsonLinesFilterModel::evaluationFinished);
+    connect(&this->sortWatcher, &QFutureWatcher<QVector<int>>::finished, this, &JsonLinesFilterModel::sortingFinished);
+
+    this->setSourceModel(model);
+}
+
+JsonLinesFilterModel::~JsonLinesFilterModel()
+{
+    this->watcher.waitForFinished();
+    this->sortWatcher.waitForFinished();
+}
+
+void JsonLinesFilterModel::setFilter(const RowFilter &filter)
+{
+    this->pendingFilter = filter;
+    this->startedMs = QDateTime::currentMSecsSinceEpoch();
+    // A running evaluation of another filter is not used
+    this->changeCount++;
+
+    if (filter.isEmpty()) {
+        this->currentFilter = filter;
+        this->bits.clear();
+        this->bitCount = 0;
+        this->invalidateFilter();
+        emit filterFinished(this->model->rowCount(), 0);
+        return;
+    }
+
+    if (!this->watcher.isRunning()) {
+        this->startEvaluation();
+    }
+}
+
+RowFilter JsonLinesFilterModel::filter() const
+{
+    return this->currentFilter;
+}
+
+bool JsonLinesFilterModel::isFiltering() const
+{
+    return this->watcher.isRunning();
+}
+
+int JsonLinesFilterModel::matchCount() const
+{
+    return this->currentFilter.isEmpty() ? this->model->rowCount() : RowFilter::countBits(this->bits);
+}
+
+void JsonLinesFilterModel::startEvaluation()
+{
+    JsonLinesModel::Snapshot snapshot = this->model->snapshot();
+    RowFilter filter = this->pendingFilter;
+
+    this->startedChangeCount = this->changeCount;
+
+    this->watcher.setFuture(QtConcurrent::run([snapshot, filter]() {
+        return filter.evaluate(snapshot, 0, snapshot.rowCount());
+    }));
+}
+
+void JsonLinesFilterModel::evaluationFinished()
+{
+    if (this->pendingFilter.isEmpty()) {
+        return;
+    }
+
+    // Rows were inserted or removed, or the filter changed meanwhile
+    if (this->changeCount != this->startedChangeCount) {
+        this->startEvaluation();
+        return;
+    }
+
+    this->currentFilter = this->pendingFilter;
+    this->pendingFilter = RowFilter();
+    this->bits = this->watcher.result();
+    this->bitCount = this->model->rowCount();
+    this->invalidateFilter();
+
+    emit filterFinished(this->matchCount(), QDateTime::currentMSecsSinceEpoch() - this->startedMs);
+}
+
+void JsonLinesFilterModel::setSortColumns(const QVector<RowSorter::SortColumn> &columns)
+{
+    this->currentSortColumns = columns;
+    this->sortStartedMs = QDateTime::currentMSecsSinceEpoch();
+    this->sortChangeCount++;
+
+    if (columns.isEmpty()) {
+        this->ranks.clear();
+        this->sort(-1);
+        emit sortFinished(0);
+        return;
+    }
+
+    if (!this->sortWatcher.isRunning()) {
+        this->startSorting();
+    }
+}
+
+QVector<RowSorter::SortColumn> JsonLinesFilterModel::sortColumns() const
+{
+    return this->currentSortColumns;
+}
+
+bool JsonLinesFilterModel::isSorted() const
+{
+    return !this->currentSortColumns.isEmpty();
+}
+
+bool JsonLinesFilterModel::isSorting() const
+{
+    return this->sortWatcher.isRunning();
+}
+
+bool JsonLinesFilterModel::isActive() const
+{
+    return !this->currentFilter.isEmpty() || this->isSorted();
+}
+
+QVector<int> JsonLinesFilterModel::sortedRows() const
+{
+    int rowCount = this->model->rowCount();
+    QVector<int> rows;
+    rows.reserve(rowCount);
+
+    // Ranks of removed rows leave holes
+    int rankCount = 0;
+    for (int rank : this->ranks) {
+        rankCount = qMax(rankCount, rank + 1);
+    }
+
+    QVector<int> byRank(rankCount, -1);
+    for (int row = 0; row < this->ranks.size(); row++) {
+        if (this->ranks.at(row) >= 0) {
+            byRank[this->ranks.at(row)] = row;
+        }
+    }
+    for (int row : byRank) {
+        if (row >= 0) {
+            rows.append(row);
+        }
+    }
+
+    // Unranked rows after, in model order
+    for (int row = 0; row < rowCount; row++) {
+        if (row >= this->ranks.size() || this->ranks.at(row) < 0) {
+            rows.append(row);
+        }
+    }
+
+    return rows;
+}
+
+void JsonLinesFilterModel::startSorting()
+{
+    JsonLinesModel::Snapshot snapshot = this->model->snapshot();
+    QVector<RowSorter::SortColumn> columns = this->currentSortColumns;
+
+    this->startedSortChangeCount = this->sortChangeCount;
+
+    this->sortWatcher.setFuture(QtConcurrent::run([snapshot, columns]() {
+        return RowSorter::sortRows(snapshot, columns);
+    }));
+}
+
+void JsonLinesFilterModel::sortingFinished()
+{
+    if (this->currentSortColumns.isEmpty()) {
+        return;
+    }
+
+    // Rows were inserted or removed, or the columns changed meanwhile
+    if (this->sortChangeCount != this->startedSortChangeCount) {
+        this->startSorting();
+        return;
+    }
+
+    QVector<int> rows = this->sortWatcher.result();
+
+    this->ranks.fill(-1, rows.size());
+    for (int i = 0; i < rows.size(); i++) {
+        this->ranks[rows.at(i)] = i;
+    }
+
+    // Ranks decide, the column only has to be valid
+    if (this->sortColumn() == 0) {
+        this->invalidate();
+    } else {
+        this->sort(0);
+    }
+
+    emit sortFinished(QDateTime::currentMSecsSinceEpoch() - this->sortStartedMs);
+}
+
+int JsonLinesFilterModel::rank(int row) const
+{
+    int rank = row < this->ranks.size() ? this->ranks.at(row) : -1;
+    return rank >= 0 ? rank : this->ranks.size() + row;
+}
+
+bool JsonLinesFilterModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    return this->rank(left.row()) < this->rank(right.row());
+}
+
+bool JsonLinesFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    Q_UNUSED(sourceParent);
+
+    return this->currentFilter.isEmpty() || RowFilter::testBit(this->bits, sourceRow);
+}
+
+void JsonLinesFilterModel::sourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+
+    QVector<int> rows;
+    rows.reserve(last - first + 1);
+    for (int row = first; row <= last; row++) {
+        rows.append(row);
+    }
+
+    this->insertRowList(rows);
+}
+
+void JsonLinesFilterModel::sourceRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent);
+
+    QVector<int> rows;
+    rows.reserve(last - first + 1);
+    for (int row = first; row <= last; row++) {
+        rows.append(row);
+    }
+
+    this->removeRowList(rows);
+}
+
+void JsonLinesFilterModel::sourceRowListInserted(const QVector<int> &rows)
+{
+    this->insertRowList(rows);
+    this->isBulkReset = true;
+}
+
+void JsonLinesFilterModel::sourceRowListRemoved(const QVector<int> &rows)
+{
+    this->removeRowList(rows);
+    this->isBulkReset = true;
+}
+
+// Ranks and bits in one pass, the inserted rows are checked here
+void JsonLinesFilterModel::insertRowList(const QVector<int> &rows)
+{
+    this->changeCount++;
+    this->sortChangeCount++;
+
+    if (!this->ranks.isEmpty() && rows.first() < this->ranks.size()) {
+        QVector<int> merged;
+        merged.reserve(this->ranks.size() + rows.size());
+        int next = 0;
+        for (int row : rows) {
+            while (merged.size() < row && next < this->ranks.size()) {
+                merged.append(this->ranks.at(next++));
+            }
+            merged.append(-1);
+        }
+        while (next < this->ranks.size()) {
+            merged.append(this->ranks.at(next++));
+        }
+        this->ranks = merged;
+    }
+
+    if (this->currentFilter.isEmpty()) {
+        return;
+    }
+
+    JsonLinesModel::Snapshot snapshot = this->model->snapshot();
+    RowFilter::Bits inserted;
+
+    // Runs of adjacent rows are evaluated together
+    int first = 0;
+    while (first < rows.size()) {
+        int last = first;
+        while (last + 1 < rows.size() && rows.at(last + 1) == rows.at(last) + 1) {
+            last++;
+        }
+
+        RowFilter::Bits run = this->currentFilter.evaluate(snapshot, rows.at(first), last - first + 1);
+        for (int i = first; i <= last; i++) {
+            RowFilter::setBit(inserted, i, RowFilter::testBit(run, i - first));
+        }
+
+        first = last + 1;
+    }
+
+    this->bits = RowFilter::insertBits(this->bits, this->bitCount, rows, inserted);
+    this->bitCount += rows.size();
+}
+
+void JsonLinesFilterModel::removeRowList(const QVector<int> &rows)
+{
+    this->changeCount++;
+    this->sortChangeCount++;
+
+    if (!this->ranks.isEmpty() && rows.first() < this->ranks.size()) {
+        int next = 0;
+        int target = 0;
+        for (int row = 0; row < this->ranks.size(); row++) {
+            if (next < rows.size() && rows.at(next) == row) {
+                next++;
+            } else {
+                this->ranks[target++] = this->ranks.at(row);
+            }
+        }
+        this->ranks.resize(target);
+    }
+
+    if (this->currentFilter.isEmpty()) {
+        return;
+    }
+
+    int removed = 0;
+    for (int row : rows) {
+        if (row < this->bitCount) {
+            removed++;
+        }
+    }
+
+    this->bits = RowFilter::removeBits(this->bits, this->bitCount, rows);
+    this->bitCount -= removed;
+}
+
+void JsonLinesFilterModel::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (this->currentFilter.isEmpty()) {
+        return;
+    }
+
+    // Only edited rows have new values, a save changes offsets only
+    for (int row = topLeft.row(); row <= bottomRight.row(); row++) {
+        if (this->model->rowKey(row) < 0) {
+            RowFilter::setBit(this->bits, row, this->currentFilter.matches(this->model->rowValues(row)));
+        }
+    }
+}
+
+void JsonLinesFilterModel::sourceModelReset()
+{
+    // Bulk removal or insertion, the bits and ranks were carried over
+    if (this->isBulkReset) {
+        this->isBulkReset = false;
+        return;
+    }
+
+    this->changeCount++;
+    this->sortChangeCount++;
+
+    // Rows cannot be matched to their ranks, model order until sorted again
+    if (!this->currentSortColumns.isEmpty()) {
+        this->ranks.clear();
+        if (!this->sortWatcher.isRunning()) {
+            this->sortStartedMs = QDateTime::currentMSecsSinceEpoch();
+            this->startSorting();
+        }
+    }
+
+    if (this->currentFilter.isEmpty()) {
+        return;
+    }
+
+    // Everything is checked again in background, the view keeps the old
+    // bits until then as for a new filter
+    if (this->pendingFilter.isEmpty()) {
+        this->pendingFilter = this->currentFilter;
+        this->startedMs = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    if (!this->watcher.isRunning()) {
+        this->startEvaluation();
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef JSONLINESFILTERMODEL_H
+#define JSONLINESFILTERMODEL_H
+
+#include <QFutureWatcher>
+#include <QSortFilterProxyModel>
+
+#include "jsonlinesmodel.h"
+#include "rowfilter.h"
+#include "rowsorter.h"
+
+// Rows of a JsonLinesModel matching a RowFilter, optionally sorted.
+// setFilter() evaluates all rows on the thread pool from a snapshot, the
+// view keeps the previous result until then. filterAcceptsRow() only tests
+// the row's bit. The bits follow the model: inserted rows are checked when
+// they arrive, and on dataChanged only rows with values in memory, the
+// edited ones, are checked again, rows read from the file cannot have
+// changed. Bulk removals and insertions of the model shift the bits a word
+// at a time, once per batch. After any other model reset all rows are
+// evaluated again in background like for a new filter. setSortColumns()
+// sorts the rows with RowSorter in background into a rank per model row,
+// lessThan() compares ranks only. Rows inserted later have no rank and
+// follow the sorted ones, edited rows keep their place until sorted again.
+// The model order is never changed. The handlers are connected before
+// QSortFilterProxyModel's own, so the bits and ranks are up to date when it
+// asks for them.
+class JsonLinesFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit JsonLinesFilterModel(JsonLinesModel *model, QObject *parent = nullptr);
+    ~JsonLinesFilterModel();
+
+    // Empty filter shows every row
+    void setFilter(const RowFilter &filter);
+    RowFilter filter() const;
+    bool isFiltering() const;           // evaluating in background
+    int matchCount() const;
+
+    // Empty columns keep the model order
+    void setSortColumns(const QVector<RowSorter::SortColumn> &columns);
+    QVector<RowSorter::SortColumn> sortColumns() const;
+    bool isSorted() const;
+    bool isSorting() const;
+    // Every model row, filtered out ones too, in the order shown
+    QVector<int> sortedRows() const;
+
+    // Filtered or sorted, the view needs this model
+    bool isActive() const;
+
+signals:
+    void filterFinished(int matchCount, qint64 elapsedMs);
+    void sortFinished(qint64 elapsedMs);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+private slots:
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void sourceModelReset();
+    void sourceRowListInserted(const QVector<int> &rows);
+    void sourceRowListRemoved(const QVector<int> &rows);
+    void evaluationFinished();
+    void sortingFinished();
+
+private:
+    void startEvaluation();
+    void startSorting();
+    // rows ascending, as row numbers after the insertion or before the
+    // removal
+    void insertRowList(const QVector<int> &rows);
+    void removeRowList(const QVector<int> &rows);
+    int rank(int row) const;
+
+    JsonLinesModel *model;
+    RowFilter currentFilter;
+    RowFilter::Bits bits;
+    int bitCount = 0;                   // rows covered by bits
+    bool isBulkReset = false;           // the next model reset is a bulk change
+
+    QFutureWatcher<RowFilter::Bits> watcher;
+    RowFilter pendingFilter;
+    int changeCount = 0;                // structural changes of the model and new filters
+    int startedChangeCount = 0;
+    qint64 startedMs = 0;
+
+    QVector<RowSorter::SortColumn> currentSortColumns;
+    QVector<int> ranks;                 // sorted position of every model row, -1 when inserted after
+    QFutureWatcher<QVector<int>> sortWatcher;
+    int sortChangeCount = 0;            // structural changes of the model and new sort columns
+    int startedSortChangeCount = 0;
+    qint64 sortStartedMs = 0;
+};
+
+#endif // JSONLINESFILTERMODEL_H
@@ -0,0 +1,160 @@
+#include "jsonlinesindex.h"
+#include "tracer.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QSaveFile>
+
+#include <climits>
+#include <cstring>
+
+static const quint32 indexMagic = 0x4a4c4958;       // JLIX
+static const quint32 indexVersion = 3;
+
+struct IndexHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 rowSize;
+    qint32 lineCount;
+    qint64 fileSize;
+    qint64 modified;
+    qint64 rowCount;
+    quint64 sampleHash;
+    char fingerprint[20];
+    quint32 keysSize;           // UTF-8 keys after the rows, one per line
+};
+
+QByteArray JsonLinesIndex::makeFingerprint(const char *data, qint64 size)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    qint64 head = qMin(size, fingerprintBlockSize);
+    qint64 tail = qMin(size - head, fingerprintBlockSize);
+
+    hash.addData(QByteArrayView(data, head));
+    hash.addData(QByteArrayView(data + size - tail, tail));
+    hash.addData(QByteArray::number(size));
+
+    return hash.result();
+}
+
+JsonLinesIndex::Match JsonLinesIndex::match(const char *data, qint64 size, qint64 modified) const
+{
+    if (this->fileSize <= 0 || size < this->fileSize) {
+        return Mismatch;
+    }
+
+    if (makeFingerprint(data, this->fileSize) != this->fingerprint) {
+        return Mismatch;
+    }
+
+    if (size == this->fileSize) {
+        return modified == this->modified ? Unchanged : Mismatch;
+    }
+
+    // Tail is parsed from a line start only
+    if (data[this->fileSize - 1] != '\n') {
+        return Mismatch;
+    }
+
+    // Lines changed in the middle move or change the rows after them
+    return sampleRows(data, this->fileSize, this->rows) == this->sampleHash ? Appended : Mismatch;
+}
+
+quint64 JsonLinesIndex::sampleRows(const char *data, qint64 size, const QVector<JsonLinesRowRef> &rows)
+{
+    quint64 hash = 14695981039346656037ULL;
+    int step = qMax(1, int(rows.size() / sampleRowCount));
+
+    for (int i = 0; i < rows.size(); i += step) {
+        const JsonLinesRowRef &ref = rows.at(i);
+        if (ref.offset < 0 || ref.offset + ref.length > size) {
+            return 0;
+        }
+        hash = (hash ^ JsonLinesParser::hashLine(data + ref.offset, data + ref.offset + ref.length)) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+bool JsonLinesIndex::read(const QString &indexPath, JsonLinesIndex *index)
+{
+    QFile file(indexPath);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    IndexHeader header;
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        return false;
+    }
+
+    if (header.magic != indexMagic || header.version != indexVersion || header.rowSize != sizeof(JsonLinesRowRef)) {
+        return false;
+    }
+
+    qint64 rowBytes = header.rowCount * qint64(sizeof(JsonLinesRowRef));
+    if (header.rowCount < 0 || header.rowCount > INT_MAX
+            || file.size() != qint64(sizeof(header)) + rowBytes + header.keysSize) {
+        return false;
+    }
+
+    index->fileSize = header.fileSize;
+    index->modified = header.modified;
+    index->fingerprint = QByteArray(header.fingerprint, sizeof(header.fingerprint));
+    index->sampleHash = header.sampleHash;
+    index->lineCount = header.lineCount;
+    index->rows.resize(header.rowCount);
+
+    if (file.read(reinterpret_cast<char *>(index->rows.data()), rowBytes) != rowBytes) {
+        index->rows.clear();
+        return false;
+    }
+
+    QByteArray keys = file.read(header.keysSize);
+    if (keys.size() != qsizetype(header.keysSize)) {
+        index->rows.clear();
+        return false;
+    }
+    index->keys = keys.isEmpty() ? QStringList() : QString::fromUtf8(keys).split('\n');
+
+    return true;
+}
+
+bool JsonLinesIndex::write(const QString &indexPath, const JsonLinesIndex &index)
+{
+    TraceSpan span("index write");
+
+    QSaveFile file(indexPath);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = indexMagic;
+    header.version = indexVersion;
+    header.rowSize = sizeof(JsonLinesRowRef);
+    header.lineCount = index.lineCount;
+    header.fileSize = index.fileSize;
+    header.modified = index.modified;
+    header.rowCount = index.rows.size();
+    header.sampleHash = index.sampleHash;
+    memcpy(header.fingerprint, index.fingerprint.constData(), qMin(index.fingerprint.size(), qsizetype(sizeof(header.fingerprint))));
+
+    QByteArray keys = index.keys.join('\n').toUtf8();
+    header.keysSize = quint32(keys.size());
+
+    qint64 rowBytes = index.rows.size() * qint64(sizeof(JsonLinesRowRef));
+
+    if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+            || file.write(reinterpret_cast<const char *>(index.rows.constData()), rowBytes) != rowBytes
+            || file.write(keys) != keys.size()) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
@@ -0,0 +1,46 @@
+#ifndef JSONLINESINDEX_H
+#define JSONLINESINDEX_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "jsonlinesparser.h"
+
+// Parse index of a file kept between runs in a sidecar file, see
+// AppCache::getIndexFilePath(). The file is recognized by size, mtime and a
+// fingerprint of its first and last bytes. A file that only got new lines at
+// the end keeps its index and only the tail is parsed again; its mtime has
+// changed, so the bytes of evenly spaced indexed rows must also be the same
+// as when they were indexed.
+class JsonLinesIndex
+{
+public:
+    enum Match {
+        Mismatch = 0,
+        Unchanged,
+        Appended
+    };
+
+    static const qint64 fingerprintBlockSize = 64 * 1024;
+    static const int sampleRowCount = 4096;
+
+    qint64 fileSize = 0;            // bytes indexed
+    qint64 modified = 0;            // mtime, ms since epoch
+    QByteArray fingerprint;
+    quint64 sampleHash = 0;         // sampleRows() of rows
+    int lineCount = 0;              // lines scanned, blank ones too
+    QVector<JsonLinesRowRef> rows;
+    QStringList keys;               // keys beyond the known fields
+
+    Match match(const char *data, qint64 size, qint64 modified) const;
+
+    static QByteArray makeFingerprint(const char *data, qint64 size);
+    // Hash of up to sampleRowCount evenly spaced rows as they are in data
+    static quint64 sampleRows(const char *data, qint64 size, const QVector<JsonLinesRowRef> &rows);
+    static bool read(const QString &indexPath, JsonLinesIndex *index);
+    static bool write(const QString &indexPath, const JsonLinesIndex &index);
+};
+
+#endif // JSONLINESINDEX_H
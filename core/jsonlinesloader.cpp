@@ -0,0 +1,404 @@
+#include "jsonlinesloader.h"
+#include "tracer.h"
+
+#include <QDateTime>
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <climits>
+
+// Complete lines decompressed in a row, parsed in chunks on the pool
+struct LineBatch {
+    QByteArray data;
+    qint64 offset = 0;              // in the decompressed data
+    qint64 inputPos = 0;            // compressed bytes read to get it
+    QVector<JsonLinesParser::Chunk> chunks;
+    QVector<QFuture<void>> futures;
+};
+
+bool JsonLinesSource::open(const QString &filePath, JsonLinesSource *source, QString *error)
+{
+    TraceSpan span("file open");
+
+    QSharedPointer<QFile> file(new QFile(filePath));
+
+    if (!file->open(QIODevice::ReadOnly)) {
+        *error = file->errorString();
+        return false;
+    }
+
+    source->file = file;
+    source->buffer.clear();
+    source->data = nullptr;
+    source->size = file->size();
+    source->compressed.reset();
+
+    if (source->size == 0) {
+        return true;
+    }
+
+    uchar *map = file->map(0, source->size);
+    if (map) {
+        source->data = reinterpret_cast<const char *>(map);
+    } else {
+        // Not mappable (pipe, special filesystem): keep the whole file in memory
+        source->buffer = file->readAll();
+        if (file->error() != QFileDevice::NoError) {
+            *error = file->errorString();
+            return false;
+        }
+        source->data = source->buffer.constData();
+        source->size = source->buffer.size();
+    }
+
+    CompressedSource::Format format = CompressedSource::detect(source->data, source->size);
+    if (format != CompressedSource::Plain) {
+        source->compressed.reset(new CompressedSource(format, source->data, source->size));
+    }
+
+    return true;
+}
+
+QByteArray JsonLinesSource::read(qint64 offset, qint64 length) const
+{
+    if (this->compressed) {
+        return this->compressed->read(offset, length);
+    }
+
+    if (offset < 0 || length < 0 || offset + length > this->size) {
+        return QByteArray();
+    }
+
+    return QByteArray::fromRawData(this->data + offset, length);
+}
+
+JsonLinesLoader::JsonLinesLoader(const JsonLinesSource &source, int loadId, const QString &indexPath, QObject *parent)
+    : QObject(parent)
+    , source(source)
+    , loadId(loadId)
+    , indexPath(indexPath)
+    , errorChunk(INT_MAX)
+    , isCanceled(0)
+{
+
+}
+
+void JsonLinesLoader::setTolerant(bool isTolerant)
+{
+    this->isTolerant = isTolerant;
+}
+
+void JsonLinesLoader::cancel()
+{
+    this->isCanceled.storeRelaxed(1);
+    // Negative value stops every chunk still being parsed
+    this->errorChunk.storeRelaxed(-1);
+}
+
+// Raw rows of a chunk are numbered among all bad lines of the file
+void JsonLinesLoader::sendBadLines(JsonLinesParser::Chunk &chunk, int linesBefore)
+{
+    if (chunk.badLines.isEmpty()) {
+        return;
+    }
+
+    JsonLinesParser::placeBadLines(chunk, this->badLineCount, linesBefore);
+    this->badLineCount += chunk.badLines.size();
+
+    emit badLinesFound(this->loadId, chunk.badLines);
+    chunk.badLines = QVector<JsonLinesParser::Error>();
+}
+
+// Sends the rows of a matching saved index, returns the number of them.
+// The index is reset when it does not match the file, or when only lines
+// were appended and that is not enough.
+int JsonLinesLoader::loadIndex(JsonLinesIndex *index, bool isAppendable)
+{
+    TraceSpan span("index read");
+
+    qint64 modified = this->source.file->fileTime(QFileDevice::FileModificationTime).toMSecsSinceEpoch();
+    JsonLinesIndex::Match match = JsonLinesIndex::Mismatch;
+
+    if (JsonLinesIndex::read(this->indexPath, index)) {
+        match = index->match(this->source.data, this->source.size, modified);
+    }
+
+    if (match == JsonLinesIndex::Mismatch || (match == JsonLinesIndex::Appended && !isAppendable)) {
+        *index = JsonLinesIndex();
+        return 0;
+    }
+
+    const QVector<JsonLinesRowRef> &rows = index->rows;
+
+    if (!index->keys.isEmpty()) {
+        emit keysFound(this->loadId, index->keys);
+    }
+
+    for (int i = 0; i < rows.size(); i += cachedBatchSize) {
+        if (this->isCanceled.loadRelaxed()) {
+            break;
+        }
+
+        emit rowsLoaded(this->loadId, rows.mid(i, cachedBatchSize));
+    }
+
+    emit indexReused(this->loadId, rows.size());
+    emit progress(this->loadId, index->fileSize, this->source.size, rows.size());
+
+    return rows.size();
+}
+
+void JsonLinesLoader::run()
+{
+    if (this->source.compressed) {
+        this->runCompressed();
+        return;
+    }
+
+    TraceSpan span("load");
+
+    const char *data = this->source.data;
+    qint64 size = this->source.size;
+
+    JsonLinesIndex index;
+    bool useIndex = !this->indexPath.isEmpty() && size >= minIndexedSize;
+
+    if (useIndex) {
+        this->loadIndex(&index);
+    }
+
+    qint64 from = index.fileSize;
+
+    int chunkCount = int(qMax(qint64(QThread::idealThreadCount()) * 4, (size - from) / chunkSize));
+    QVector<JsonLinesParser::Chunk> chunks = JsonLinesParser::splitChunks(data, size, chunkCount, from);
+
+    QVector<QFuture<void>> futures;
+    futures.reserve(chunks.size());
+
+    for (JsonLinesParser::Chunk &chunk : chunks) {
+        futures.append(QtConcurrent::run([this, data, &chunk]() {
+            JsonLinesParser::parseChunk(data, chunk, &this->errorChunk, this->isTolerant);
+        }));
+    }
+
+    int status = this->isCanceled.loadRelaxed() ? Canceled : Loaded;
+    JsonLinesParser::Error error;
+    int linesBefore = index.lineCount;
+    int rowCount = index.rows.size();
+
+    // Chunks are queued in order, so they also finish roughly in order
+    for (int i = 0; i < chunks.size() && status == Loaded; i++) {
+        futures[i].waitForFinished();
+
+        if (this->isCanceled.loadRelaxed()) {
+            status = Canceled;
+            break;
+        }
+
+        JsonLinesParser::Chunk &chunk = chunks[i];
+
+        if (chunk.hasError) {
+            status = Failed;
+            error = chunk.error;
+            error.lineNumber += linesBefore;
+            this->errorChunk.storeRelaxed(-1);
+            break;
+        }
+
+        this->sendBadLines(chunk, linesBefore);
+
+        linesBefore += chunk.lineCount;
+        rowCount += chunk.rows.size();
+
+        QStringList keys;
+        for (const QString &key : chunk.keys) {
+            if (!index.keys.contains(key)) {
+                keys.append(key);
+            }
+        }
+        if (!keys.isEmpty()) {
+            index.keys.append(keys);
+            emit keysFound(this->loadId, keys);
+        }
+
+        emit rowsLoaded(this->loadId, chunk.rows);
+        emit progress(this->loadId, chunk.end, size, rowCount);
+
+        if (useIndex) {
+            index.rows.append(chunk.rows);
+        }
+        chunk.rows = QVector<JsonLinesRowRef>();
+    }
+
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+
+    // Saved before finished(), the model waits for this thread then. Raw
+    // rows are not kept in the index, a load that is not tolerant would
+    // take them as parsed.
+    if (useIndex && status == Loaded && this->badLineCount == 0 && index.fileSize != size) {
+        index.fileSize = size;
+        index.modified = this->source.file->fileTime(QFileDevice::FileModificationTime).toMSecsSinceEpoch();
+        index.fingerprint = JsonLinesIndex::makeFingerprint(data, size);
+        index.sampleHash = JsonLinesIndex::sampleRows(data, size, index.rows);
+        index.lineCount = linesBefore;
+        JsonLinesIndex::write(this->indexPath, index);
+    }
+
+    emit finished(this->loadId, status, error);
+}
+
+void JsonLinesLoader::runCompressed()
+{
+    TraceSpan span("load");
+
+    QByteArray lines;               // decompressed, not parsed yet
+    qint64 linesOffset = 0;
+    int chunkBase = 0;
+    QSharedPointer<LineBatch> pending;
+
+    int status = this->isCanceled.loadRelaxed() ? Canceled : Loaded;
+    JsonLinesParser::Error error;
+    int linesBefore = 0;
+    int rowCount = 0;
+    QStringList knownKeys;
+
+    // Any change moves the offsets in a compressed file, only an unchanged
+    // one keeps its index
+    JsonLinesIndex index;
+    bool isSeekable = this->source.compressed->openSeekable();
+    bool useIndex = isSeekable && !this->indexPath.isEmpty() && this->source.size >= minIndexedSize;
+
+    if (useIndex && status == Loaded && this->loadIndex(&index, false) > 0) {
+        status = this->isCanceled.loadRelaxed() ? Canceled : Loaded;
+        emit finished(this->loadId, status, error);
+        return;
+    }
+
+    // Starts parsing the first length bytes of lines
+    auto startBatch = [&](qint64 length, qint64 inputPos) {
+        QSharedPointer<LineBatch> batch(new LineBatch());
+        batch->data = lines.left(qsizetype(length));
+        batch->offset = linesOffset;
+        batch->inputPos = inputPos;
+
+        const char *data = batch->data.constData();
+        batch->chunks = JsonLinesParser::splitChunks(data, length, QThread::idealThreadCount() * 4);
+
+        // Chunk indexes go on between batches, an error stops all later chunks
+        for (JsonLinesParser::Chunk &chunk : batch->chunks) {
+            chunk.index += chunkBase;
+            batch->futures.append(QtConcurrent::run([this, data, &chunk]() {
+                JsonLinesParser::parseChunk(data, chunk, &this->errorChunk, this->isTolerant);
+            }));
+        }
+        chunkBase += batch->chunks.size();
+
+        lines = lines.mid(qsizetype(length));
+        linesOffset += length;
+
+        return batch;
+    };
+
+    auto finishBatch = [&](const QSharedPointer<LineBatch> &batch) {
+        for (int i = 0; i < batch->chunks.size(); i++) {
+            batch->futures[i].waitForFinished();
+
+            if (status != Loaded) {
+                continue;
+            }
+
+            if (this->isCanceled.loadRelaxed()) {
+                status = Canceled;
+                continue;
+            }
+
+            JsonLinesParser::Chunk &chunk = batch->chunks[i];
+
+            if (chunk.hasError) {
+                status = Failed;
+                error = chunk.error;
+                error.lineNumber += linesBefore;
+                this->errorChunk.storeRelaxed(-1);
+                continue;
+            }
+
+            this->sendBadLines(chunk, linesBefore);
+
+            linesBefore += chunk.lineCount;
+            rowCount += chunk.rows.size();
+
+            for (JsonLinesRowRef &ref : chunk.rows) {
+                ref.offset += batch->offset;
+            }
+
+            QStringList keys;
+            for (const QString &key : chunk.keys) {
+                if (!knownKeys.contains(key)) {
+                    keys.append(key);
+                }
+            }
+            if (!keys.isEmpty()) {
+                knownKeys.append(keys);
+                emit keysFound(this->loadId, keys);
+            }
+
+            emit rowsLoaded(this->loadId, chunk.rows);
+            if (useIndex) {
+                index.rows.append(chunk.rows);
+            }
+            chunk.rows = QVector<JsonLinesRowRef>();
+        }
+
+        if (status == Loaded) {
+            emit progress(this->loadId, batch->inputPos, this->source.size, rowCount);
+        }
+    };
+
+    // A batch is parsed while the next one is decompressed
+    QString buildError;
+    bool isBuilt = status == Loaded && this->source.compressed->build([&](const char *data, qint64 length, qint64 inputPos) {
+        lines.append(data, qsizetype(length));
+
+        qint64 cut = lines.size() >= compressedBatchSize ? lines.lastIndexOf('\n') + 1 : 0;
+        if (cut > 0) {
+            QSharedPointer<LineBatch> batch = startBatch(cut, inputPos);
+            if (pending) {
+                finishBatch(pending);
+            }
+            pending = batch;
+        }
+
+        return status == Loaded && !this->isCanceled.loadRelaxed();
+    }, &buildError);
+
+    if (pending) {
+        finishBatch(pending);
+    }
+
+    if (isBuilt && status == Loaded && !lines.isEmpty()) {
+        finishBatch(startBatch(lines.size(), this->source.size));
+    }
+
+    if (status == Loaded && this->isCanceled.loadRelaxed()) {
+        status = Canceled;
+    } else if (status == Loaded && !isBuilt) {
+        status = Failed;
+        error.message = buildError;
+    }
+
+    // Rows are not in the compressed data, there is nothing to sample for
+    // an append
+    if (useIndex && status == Loaded && this->badLineCount == 0) {
+        index.fileSize = this->source.size;
+        index.modified = this->source.file->fileTime(QFileDevice::FileModificationTime).toMSecsSinceEpoch();
+        index.fingerprint = JsonLinesIndex::makeFingerprint(this->source.data, this->source.size);
+        index.lineCount = linesBefore;
+        index.keys = knownKeys;
+        JsonLinesIndex::write(this->indexPath, index);
+    }
+
+    emit finished(this->loadId, status, error);
+}
@@ -0,0 +1,92 @@
+#ifndef JSONLINESLOADER_H
+#define JSONLINESLOADER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFile>
+#include <QObject>
+#include <QSharedPointer>
+
+#include "compressedsource.h"
+#include "jsonlinesindex.h"
+#include "jsonlinesparser.h"
+
+// Memory-mapped JSON Lines file. Copies share the mapping, it stays valid
+// while any copy is alive. gzip and zstd files are detected by their magic
+// bytes, data is then the compressed file and row offsets are in the
+// decompressed data, read through compressed once it is built.
+struct JsonLinesSource {
+    QSharedPointer<QFile> file;
+    QByteArray buffer;              // file contents when it cannot be mapped
+    const char *data = nullptr;
+    qint64 size = 0;
+    QSharedPointer<CompressedSource> compressed;
+
+    static bool open(const QString &filePath, JsonLinesSource *source, QString *error);
+
+    // Shares the mapping of an uncompressed file, empty when out of range
+    QByteArray read(qint64 offset, qint64 length) const;
+};
+
+// Indexes a source on a worker thread. Chunks are parsed on the global
+// thread pool and sent back in line order as row batches, so the first rows
+// are available long before the whole file is parsed. With an index path
+// the index saved by an earlier load is reused when the file is unchanged,
+// or only the appended tail is parsed, and the index is saved on success.
+// Compressed sources are decompressed in order on the loader thread while
+// the lines already decompressed are parsed on the pool. Only seekable zstd
+// files keep a saved index, an unchanged one is opened through its seek
+// table without decompressing anything. A tolerant loader keeps the lines
+// that cannot be parsed as raw rows and sends them with their line numbers,
+// the index is not saved then.
+class JsonLinesLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Status {
+        Loaded = 0,
+        Failed,
+        Canceled
+    };
+
+    static const qint64 chunkSize = 8 * 1024 * 1024;
+    static const int cachedBatchSize = 256 * 1024;
+    // Smaller files are parsed faster than their index is read
+    static const qint64 minIndexedSize = 1024 * 1024;
+    // Decompressed lines parsed at once
+    static const qint64 compressedBatchSize = 32 * 1024 * 1024;
+
+    JsonLinesLoader(const JsonLinesSource &source, int loadId, const QString &indexPath = QString(), QObject *parent = nullptr);
+
+    // Before run()
+    void setTolerant(bool isTolerant);
+
+    void run();
+    void cancel();
+
+signals:
+    void rowsLoaded(int loadId, const QVector<JsonLinesRowRef> &rows);
+    // Keys beyond the known fields first seen in the rows sent next
+    void keysFound(int loadId, const QStringList &keys);
+    // Lines of the raw rows sent next, in order
+    void badLinesFound(int loadId, const QVector<JsonLinesParser::Error> &badLines);
+    void indexReused(int loadId, int cachedRows);
+    void progress(int loadId, qint64 bytesLoaded, qint64 bytesTotal, int rowsLoaded);
+    void finished(int loadId, int status, const JsonLinesParser::Error &error);
+
+private:
+    int loadIndex(JsonLinesIndex *index, bool isAppendable = true);
+    void runCompressed();
+    void sendBadLines(JsonLinesParser::Chunk &chunk, int linesBefore);
+
+    JsonLinesSource source;
+    int loadId;
+    QString indexPath;
+    bool isTolerant = false;
+    int badLineCount = 0;
+    QAtomicInt errorChunk;
+    QAtomicInt isCanceled;
+};
+
+#endif // JSONLINESLOADER_H
@@ -0,0 +1,1321 @@
+#include "jsonlinesmodel.h"
+
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <climits>
+
+#include "compressedwriter.h"
+#include "jsonlineswriter.h"
+#include "linescanner.h"
+#include "tracer.h"
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+JsonLinesModel::JsonLinesModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , storedRows(ColumnCount)
+    , rowCache(rowCacheSize)
+{
+    qRegisterMetaType<QVector<JsonLinesRowRef>>();
+    qRegisterMetaType<JsonLinesParser::Error>();
+    qRegisterMetaType<QVector<JsonLinesParser::Error>>();
+}
+
+JsonLinesModel::~JsonLinesModel()
+{
+    this->stopLoader();
+}
+
+const QStringList &JsonLinesModel::fieldKeys()
+{
+    return JsonLinesSchema::fieldKeys();
+}
+
+int JsonLinesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : this->rows.size();
+}
+
+int JsonLinesModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : this->schema.count();
+}
+
+QVariant JsonLinesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    if (role == Qt::ToolTipRole && this->isRawRow(index.row())) {
+        JsonLinesParser::Error badLine = this->badLine(index.row());
+        return QString("Line %1 cannot be parsed: %2").arg(badLine.lineNumber).arg(badLine.message);
+    }
+
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    return this->rowValues(index.row()).value(index.column());
+}
+
+QVariant JsonLinesModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+
+    switch (section) {
+    case ColumnTerm:
+        return "Term";
+    case ColumnTermOrig:
+        return "Orig term";
+    case ColumnDefinition:
+        return "Definition";
+    case ColumnDefinitionOrig:
+        return "Orig definition";
+    case ColumnSource:
+        return "Source";
+    }
+
+    return this->schema.key(section);
+}
+
+bool JsonLinesModel::insertRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || row > this->rows.size() || count <= 0) {
+        return false;
+    }
+
+    beginInsertRows(parent, row, row + count - 1);
+
+    for (int i = 0; i < count; i++) {
+        RowRef ref;
+        ref.stored = this->storedRows.append(QStringList());
+        this->rows.insert(row + i, ref);
+    }
+
+    endInsertRows();
+    return true;
+}
+
+bool JsonLinesModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > this->rows.size()) {
+        return false;
+    }
+
+    beginRemoveRows(parent, row, row + count - 1);
+    this->rows.remove(row, count);
+    endRemoveRows();
+
+    return true;
+}
+
+void JsonLinesModel::removeRowList(const QVector<int> &rowList)
+{
+    if (rowList.isEmpty()) {
+        return;
+    }
+
+    QVector<int> sorted;
+    sorted.reserve(rowList.size());
+    for (int row : rowList) {
+        if (row >= 0 && row < this->rows.size()) {
+            sorted.append(row);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    // Many runs: one pass over the rows instead of a move per run
+    if (runCount(sorted) > bulkRunCount) {
+        beginResetModel();
+
+        int next = 0;
+        int target = 0;
+        for (int row = 0; row < this->rows.size(); row++) {
+            if (next < sorted.size() && sorted.at(next) == row) {
+                next++;
+            } else {
+                this->rows[target++] = this->rows.at(row);
+            }
+        }
+        this->rows.resize(target);
+
+        emit rowListRemoved(sorted);
+        endResetModel();
+        return;
+    }
+
+    // From the last run, row numbers before it stay valid
+    int last = sorted.size() - 1;
+    while (last >= 0) {
+        int first = last;
+        while (first > 0 && sorted.at(first - 1) == sorted.at(first) - 1) {
+            first--;
+        }
+
+        beginRemoveRows(QModelIndex(), sorted.at(first), sorted.at(last));
+        this->rows.remove(sorted.at(first), last - first + 1);
+        endRemoveRows();
+
+        last = first - 1;
+    }
+}
+
+// Runs of adjacent rows in an ascending list
+int JsonLinesModel::runCount(const QVector<int> &rowList)
+{
+    int count = 0;
+    for (int i = 0; i < rowList.size(); i++) {
+        if (i == 0 || rowList.at(i) != rowList.at(i - 1) + 1) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool JsonLinesModel::load(const QString &filePath)
+{
+    TraceSpan span("model load");
+
+    JsonLinesSource loaded;
+    QString error;
+
+    this->stopLoader();
+
+    if (!JsonLinesSource::open(filePath, &loaded, &error)) {
+        this->setError(error);
+        return false;
+    }
+
+    QVector<RowRef> index;
+    QStringList keys;
+    JsonLinesParser::Error parseError;
+
+    if (loaded.compressed) {
+        // Same streaming load as in background, run here
+        JsonLinesLoader loader(loaded, 0);
+        int status = JsonLinesLoader::Loaded;
+
+        connect(&loader, &JsonLinesLoader::rowsLoaded, [&index](int, const QVector<RowRef> &rows) {
+            index.append(rows);
+        });
+        connect(&loader, &JsonLinesLoader::keysFound, [&keys](int, const QStringList &found) {
+            keys.append(found);
+        });
+        connect(&loader, &JsonLinesLoader::finished, [&status, &parseError](int, int loaderStatus, const JsonLinesParser::Error &error) {
+            status = loaderStatus;
+            parseError = error;
+        });
+
+        loader.run();
+
+        if (status != JsonLinesLoader::Loaded) {
+            this->setError(parseError.message, parseError.lineNumber, parseError.lineText);
+            return false;
+        }
+    } else if (!JsonLinesParser::indexLines(loaded.data, loaded.size, &index, &parseError, &keys)) {
+        this->setError(parseError.message, parseError.lineNumber, parseError.lineText);
+        return false;
+    }
+
+    beginResetModel();
+
+    this->source = loaded;
+    this->sourceId++;
+    this->rows = index;
+    this->storedRows.clear();
+    this->storedOtherKeys.clear();
+    this->badLineList.clear();
+    this->rowCache.clear();
+    this->schema = JsonLinesSchema();
+    this->schema.addKeys(keys);
+    this->setIndexedSize(loaded.size);
+
+    endResetModel();
+
+    this->setError("");
+
+    return true;
+}
+
+bool JsonLinesModel::startLoading(const QString &filePath, const QString &indexPath)
+{
+    JsonLinesSource loaded;
+    QString error;
+
+    this->stopLoader();
+
+    if (!JsonLinesSource::open(filePath, &loaded, &error)) {
+        this->setError(error);
+        return false;
+    }
+
+    beginResetModel();
+
+    this->source = loaded;
+    this->sourceId++;
+    this->rows.clear();
+    this->storedRows.clear();
+    this->storedOtherKeys.clear();
+    this->badLineList.clear();
+    this->rowCache.clear();
+    this->schema = JsonLinesSchema();
+    // Loader indexes the file as mapped now
+    this->setIndexedSize(loaded.size);
+
+    endResetModel();
+
+    this->setError("");
+    this->cachedRows = 0;
+
+    this->loader = new JsonLinesLoader(loaded, ++this->loadId, indexPath);
+    this->loader->setTolerant(this->isTolerant);
+
+    connect(this->loader, &JsonLinesLoader::rowsLoaded, this, &JsonLinesModel::loaderRowsLoaded, Qt::QueuedConnection);
+    connect(this->loader, &JsonLinesLoader::keysFound, this, &JsonLinesModel::loaderKeysFound, Qt::QueuedConnection);
+    connect(this->loader, &JsonLinesLoader::badLinesFound, this, &JsonLinesModel::loaderBadLinesFound, Qt::QueuedConnection);
+    connect(this->loader, &JsonLinesLoader::indexReused, this, &JsonLinesModel::loaderIndexReused, Qt::QueuedConnection);
+    connect(this->loader, &JsonLinesLoader::progress, this, &JsonLinesModel::loaderProgress, Qt::QueuedConnection);
+    connect(this->loader, &JsonLinesLoader::finished, this, &JsonLinesModel::loaderFinished, Qt::QueuedConnection);
+
+    JsonLinesLoader *threadLoader = this->loader;
+    this->loaderThread = QThread::create([threadLoader]() {
+        threadLoader->run();
+    });
+    this->loaderThread->start();
+
+    return true;
+}
+
+void JsonLinesModel::cancelLoading()
+{
+    if (this->loader) {
+        this->loader->cancel();
+    }
+}
+
+bool JsonLinesModel::isLoading() const
+{
+    return this->loaderThread != nullptr;
+}
+
+int JsonLinesModel::cachedRowCount() const
+{
+    return this->cachedRows;
+}
+
+void JsonLinesModel::stopLoader()
+{
+    if (!this->loaderThread) {
+        return;
+    }
+
+    this->loader->cancel();
+    this->loaderThread->wait();
+
+    delete this->loaderThread;
+    delete this->loader;
+
+    this->loaderThread = nullptr;
+    this->loader = nullptr;
+
+    // Batches of the stopped loader still queued are ignored
+    this->loadId++;
+}
+
+void JsonLinesModel::loaderRowsLoaded(int loadId, const QVector<JsonLinesRowRef> &rows)
+{
+    TraceSpan span("model insert");
+
+    if (loadId != this->loadId || rows.isEmpty()) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), this->rows.size(), this->rows.size() + rows.size() - 1);
+    this->rows.append(rows);
+    endInsertRows();
+}
+
+void JsonLinesModel::loaderKeysFound(int loadId, const QStringList &keys)
+{
+    if (loadId != this->loadId) {
+        return;
+    }
+
+    this->addKeys(keys);
+}
+
+// Sent before the rows pointing to them
+void JsonLinesModel::loaderBadLinesFound(int loadId, const QVector<JsonLinesParser::Error> &badLines)
+{
+    if (loadId != this->loadId) {
+        return;
+    }
+
+    this->badLineList.append(badLines);
+}
+
+void JsonLinesModel::addKeys(const QStringList &keys)
+{
+    QStringList added;
+    for (const QString &key : keys) {
+        if (this->schema.indexOf(key) < 0) {
+            added.append(key);
+        }
+    }
+    if (added.isEmpty()) {
+        return;
+    }
+
+    beginInsertColumns(QModelIndex(), this->schema.count(), this->schema.count() + added.size() - 1);
+    this->schema.addKeys(added);
+    // Cached rows were decoded without the new columns
+    this->rowCache.clear();
+    endInsertColumns();
+}
+
+void JsonLinesModel::loaderIndexReused(int loadId, int cachedRows)
+{
+    if (loadId != this->loadId) {
+        return;
+    }
+
+    this->cachedRows = cachedRows;
+}
+
+void JsonLinesModel::loaderProgress(int loadId, qint64 bytesLoaded, qint64 bytesTotal, int rowsLoaded)
+{
+    if (loadId != this->loadId) {
+        return;
+    }
+
+    emit loadingProgress(bytesLoaded, bytesTotal, rowsLoaded);
+}
+
+void JsonLinesModel::loaderFinished(int loadId, int status, const JsonLinesParser::Error &error)
+{
+    if (loadId != this->loadId) {
+        return;
+    }
+
+    this->loaderThread->wait();
+
+    delete this->loaderThread;
+    delete this->loader;
+
+    this->loaderThread = nullptr;
+    this->loader = nullptr;
+
+    if (status == JsonLinesLoader::Failed) {
+        this->setError(error.message, error.lineNumber, error.lineText);
+    } else if (status == JsonLinesLoader::Canceled) {
+        this->setError("Loading canceled");
+    }
+
+    emit loadingFinished(status);
+}
+
+bool JsonLinesModel::save(const QString &filePath, const QVector<int> &order)
+{
+    TraceSpan span("save");
+
+    if (!order.isEmpty() && order.size() != this->rows.size()) {
+        this->setError("Row order does not match the rows");
+        return false;
+    }
+
+    // Rows in the order written, the model keeps its own until committed
+    QVector<RowRef> written = this->rows;
+    if (!order.isEmpty()) {
+        for (int i = 0; i < order.size(); i++) {
+            written[i] = this->rows.at(order.at(i));
+        }
+    }
+
+    // Compressed by the file name, or as the file saved over
+    CompressedSource::Format format = CompressedSource::formatForPath(filePath);
+    if (format == CompressedSource::Plain && this->source.compressed && this->source.file
+            && QFileInfo(this->source.file->fileName()) == QFileInfo(filePath)) {
+        format = this->source.compressed->format();
+    }
+
+    QSaveFile file(filePath);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        this->setError(file.errorString());
+        return false;
+    }
+
+    CompressedWriter compressor(&file, format);
+    QIODevice *output = &file;
+
+    if (format != CompressedSource::Plain) {
+        compressor.open(QIODevice::WriteOnly);
+        output = &compressor;
+    }
+
+    JsonLinesWriter writer(output, fieldKeys());
+
+    QVector<RowRef> savedRows(written.size());
+    JsonLinesColumns savedStoredRows(ColumnCount);
+
+    this->lastSaveStats = SaveStats();
+    this->lastKeyChanges.clear();
+
+    qint64 serializeStart = Tracer::now();
+
+    int row = 0;
+    while (row < written.size()) {
+        const RowRef &ref = written.at(row);
+
+        // Unchanged rows still adjacent in the source are copied as one range,
+        // raw rows with them
+        if (isSourceRow(ref)) {
+            int last = row;
+            while (last + 1 < written.size() && this->isAdjacent(written.at(last), written.at(last + 1))) {
+                last++;
+            }
+
+            qint64 begin = ref.offset;
+            qint64 end = written.at(last).offset + written.at(last).length;
+
+            qint64 offset = writer.pos();
+            for (int i = row; i <= last; i++) {
+                savedRows[i].offset = offset + (written.at(i).offset - begin);
+                savedRows[i].length = written.at(i).length;
+                savedRows[i].stored = written.at(i).stored;
+                if (written.at(i).isRaw()) {
+                    this->lastSaveStats.rawRows++;
+                }
+            }
+
+            if (!writer.flush() || !this->copySourceRange(output, begin, end - begin, offset)) {
+                this->setError(output->errorString());
+                file.cancelWriting();
+                return false;
+            }
+            writer.markWritten(end - begin);
+
+            if (!writer.writeRaw("\n", 1)) {
+                this->setError(output->errorString());
+                file.cancelWriting();
+                return false;
+            }
+
+            this->lastSaveStats.copiedRows += last - row + 1;
+            this->lastSaveStats.copiedBytes += end - begin + 1;
+
+            row = last + 1;
+            continue;
+        }
+
+        // Raw row restored by undo, only its text is left
+        if (ref.isRaw()) {
+            QByteArray line = this->badLineList.at(ref.badLine()).lineText.toUtf8();
+            qint64 offset = writer.pos();
+
+            if (!writer.writeRaw(line.constData(), line.size()) || !writer.writeRaw("\n", 1)) {
+                this->setError(output->errorString());
+                file.cancelWriting();
+                return false;
+            }
+
+            savedRows[row].offset = offset;
+            savedRows[row].length = quint32(line.size());
+            savedRows[row].stored = ref.stored;
+            this->lastSaveStats.rawRows++;
+
+            row++;
+            continue;
+        }
+
+        QStringList values = this->storedRows.rowValues(ref.stored);
+        bool isEmpty = true;
+
+        for (QString &value : values) {
+            value = value.trimmed();
+            if (!value.isEmpty()) {
+                isEmpty = false;
+            }
+        }
+
+        // Keys beyond the known fields are kept from the source line
+        QJsonObject object = this->otherKeys(ref);
+
+        // Skip empty, the row stays in memory only
+        if (isEmpty && object.isEmpty()) {
+            savedRows[row].stored = savedStoredRows.append(values);
+            row++;
+            continue;
+        }
+
+        qint64 offset = writer.pos();
+        qint64 length = -1;
+
+        if (object.isEmpty()) {
+            length = writer.writeRow(values);
+        } else {
+            for (int column = 0; column < ColumnCount; column++) {
+                object.insert(fieldKeys().at(column), values.at(column));
+            }
+            QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+            if (writer.writeRaw(line.constData(), line.size()) && writer.writeRaw("\n", 1)) {
+                length = line.size();
+            }
+        }
+
+        if (length < 0) {
+            this->setError(output->errorString());
+            file.cancelWriting();
+            return false;
+        }
+
+        savedRows[row].offset = offset;
+        savedRows[row].length = quint32(length);
+        this->lastSaveStats.encodedRows++;
+
+        row++;
+    }
+
+    Tracer::record("serialize", serializeStart, Tracer::now() - serializeStart);
+
+    // QSaveFile syncs the data to disk before renaming
+    qint64 commitStart = Tracer::now();
+    bool isCommitted = writer.flush() && (format == CompressedSource::Plain || compressor.finish()) && file.commit();
+    Tracer::record("fsync", commitStart, Tracer::now() - commitStart);
+
+    if (!isCommitted) {
+        this->setError(output->errorString().isEmpty() ? file.errorString() : output->errorString());
+        return false;
+    }
+
+    // Saved file becomes the new source, row numbers are unchanged unless
+    // an order was given
+    QString error;
+    JsonLinesSource saved;
+    if (!JsonLinesSource::open(filePath, &saved, &error)) {
+        this->setError(error);
+        return false;
+    }
+    // Blocks written are the checkpoints, no need to decompress it again
+    if (saved.compressed) {
+        saved.compressed->setIndex(compressor.checkpoints(), writer.pos());
+    }
+    this->source = saved;
+    this->sourceId++;
+    this->setIndexedSize(saved.size);
+
+    for (int i = 0; i < written.size(); i++) {
+        qint64 oldKey = refKey(written.at(i));
+        qint64 newKey = refKey(savedRows.at(i));
+        if (oldKey != newKey) {
+            this->lastKeyChanges.append(qMakePair(oldKey, newKey));
+        }
+    }
+
+    // Rows follow the file order, reordered only now that it is written
+    if (!order.isEmpty()) {
+        beginResetModel();
+    }
+
+    this->rows = savedRows;
+    this->storedRows = savedStoredRows;
+    this->storedOtherKeys.clear();
+    this->rowCache.clear();
+
+    if (!order.isEmpty()) {
+        endResetModel();
+    } else if (!this->rows.isEmpty()) {
+        emit dataChanged(index(0, 0), index(this->rows.size() - 1, this->columnCount() - 1));
+    }
+
+    this->setError("");
+
+    return true;
+}
+
+void JsonLinesModel::clear()
+{
+    this->stopLoader();
+
+    beginResetModel();
+
+    this->source = JsonLinesSource();
+    this->sourceId++;
+    this->rows.clear();
+    this->storedRows.clear();
+    this->storedOtherKeys.clear();
+    this->badLineList.clear();
+    this->rowCache.clear();
+    this->schema = JsonLinesSchema();
+    this->setIndexedSize(0);
+
+    endResetModel();
+}
+
+void JsonLinesModel::setIndexedSize(qint64 size)
+{
+    this->indexedSize = size;
+    this->indexedFingerprint = JsonLinesIndex::makeFingerprint(this->source.data, size);
+}
+
+JsonLinesModel::FollowStatus JsonLinesModel::readAppended(int *appendedRows)
+{
+    TraceSpan span("read appended");
+
+    *appendedRows = 0;
+
+    if (this->isLoading() || !this->source.file) {
+        return FollowUnchanged;
+    }
+
+    // A rotated file may not be created again yet
+    QString filePath = this->source.file->fileName();
+    if (!QFileInfo::exists(filePath)) {
+        return FollowUnchanged;
+    }
+
+    JsonLinesSource current;
+    QString error;
+
+    if (!JsonLinesSource::open(filePath, &current, &error)) {
+        this->setError(error);
+        return FollowFailed;
+    }
+
+    // Whatever was indexed must still be there as it was
+    if (current.size < this->indexedSize
+            || JsonLinesIndex::makeFingerprint(current.data, this->indexedSize) != this->indexedFingerprint) {
+        return FollowReplaced;
+    }
+
+    if (current.size == this->indexedSize) {
+        return FollowUnchanged;
+    }
+
+    // Offsets in compressed data move, the whole file is read again
+    if (current.compressed || this->source.compressed) {
+        return FollowReplaced;
+    }
+
+    const char *data = current.data;
+    qint64 from = this->indexedSize;
+
+    if (from == 0) {
+        from = JsonLinesParser::dataStart(data, current.size);
+    } else if (data[from - 1] != '\n') {
+        // Last line was indexed without its newline, only blanks may follow
+        // it up to the newline
+        qint64 pos = from;
+        while (pos < current.size && data[pos] != '\n') {
+            if (data[pos] != ' ' && data[pos] != '\t' && data[pos] != '\r') {
+                return FollowReplaced;
+            }
+            pos++;
+        }
+        if (pos == current.size) {
+            return FollowUnchanged;
+        }
+        from = pos + 1;
+    }
+
+    // Complete lines only
+    qint64 end = current.size;
+    while (end > from && data[end - 1] != '\n') {
+        end--;
+    }
+    if (end == from) {
+        return FollowUnchanged;
+    }
+
+    int chunkCount = int(qMax(qint64(QThread::idealThreadCount()), (end - from) / JsonLinesLoader::chunkSize));
+    QVector<JsonLinesParser::Chunk> chunks = JsonLinesParser::splitChunks(data, end, chunkCount, from);
+    QAtomicInt errorChunk(INT_MAX);
+
+    bool isTolerant = this->isTolerant;
+    QtConcurrent::blockingMap(chunks, [data, &errorChunk, isTolerant](JsonLinesParser::Chunk &chunk) {
+        JsonLinesParser::parseChunk(data, chunk, &errorChunk, isTolerant);
+    });
+
+    QVector<RowRef> appended;
+    QVector<JsonLinesParser::Error> badLines;
+    QStringList keys;
+    int linesBefore = -1;
+
+    for (JsonLinesParser::Chunk &chunk : chunks) {
+        // Line numbers are only needed here, count the lines before once
+        if ((chunk.hasError || !chunk.badLines.isEmpty()) && linesBefore < 0) {
+            linesBefore = int(std::count(data, data + chunk.begin, '\n'));
+        }
+
+        if (chunk.hasError) {
+            this->setError(chunk.error.message, linesBefore + chunk.error.lineNumber, chunk.error.lineText);
+            return FollowFailed;
+        }
+
+        JsonLinesParser::placeBadLines(chunk, this->badLineList.size() + badLines.size(), qMax(linesBefore, 0));
+        badLines.append(chunk.badLines);
+        if (linesBefore >= 0) {
+            linesBefore += chunk.lineCount;
+        }
+
+        appended.append(chunk.rows);
+        for (const QString &key : chunk.keys) {
+            if (!keys.contains(key)) {
+                keys.append(key);
+            }
+        }
+    }
+
+    // Rows already there keep their offsets in the larger mapping
+    this->source = current;
+    this->setIndexedSize(end);
+    this->addKeys(keys);
+    this->badLineList.append(badLines);
+
+    if (appended.isEmpty()) {
+        return FollowUnchanged;
+    }
+
+    beginInsertRows(QModelIndex(), this->rows.size(), this->rows.size() + appended.size() - 1);
+    this->rows.append(appended);
+    endInsertRows();
+
+    *appendedRows = appended.size();
+
+    return FollowAppended;
+}
+
+JsonLinesModel::SaveStats JsonLinesModel::saveStats() const
+{
+    return this->lastSaveStats;
+}
+
+QVector<QPair<qint64, qint64>> JsonLinesModel::savedKeyChanges() const
+{
+    return this->lastKeyChanges;
+}
+
+bool JsonLinesModel::isAdjacent(const RowRef &ref, const RowRef &next) const
+{
+    if (!isSourceRow(ref) || !isSourceRow(next)) {
+        return false;
+    }
+
+    qint64 end = ref.offset + ref.length;
+    if (next.offset < end) {
+        return false;
+    }
+
+    // Only line breaks and blank lines between, no removed rows
+    QByteArray between = this->source.read(end, next.offset - end);
+    if (between.size() != next.offset - end) {
+        return false;
+    }
+
+    for (char c : between) {
+        if (!LineScanner::isSpace(c)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JsonLinesModel::copySourceRange(QIODevice *target, qint64 sourceOffset, qint64 length, qint64 targetOffset)
+{
+#ifdef Q_OS_LINUX
+    // Let the kernel copy the range (or share extents on CoW filesystems)
+    // without passing it through user space
+    QFileDevice *file = qobject_cast<QFileDevice *>(target);
+    if (file && !this->source.compressed && this->source.buffer.isEmpty() && file->flush()) {
+        off64_t inOffset = sourceOffset;
+        off64_t outOffset = targetOffset;
+        qint64 remaining = length;
+
+        while (remaining > 0) {
+            ssize_t copied = copy_file_range(this->source.file->handle(), &inOffset,
+                                             file->handle(), &outOffset, size_t(remaining), 0);
+            if (copied <= 0) {
+                break;
+            }
+            remaining -= copied;
+        }
+
+        if (!file->seek(outOffset)) {
+            return false;
+        }
+
+        sourceOffset = inOffset;
+        length = remaining;
+    }
+#else
+    Q_UNUSED(targetOffset);
+#endif
+
+    // Write the rest straight from the mapping, or decompressed in blocks
+    while (length > 0) {
+        qint64 part = qMin(length, CompressedSource::blockSize);
+        QByteArray data = this->source.read(sourceOffset, part);
+        if (data.size() != part || target->write(data) != part) {
+            return false;
+        }
+        sourceOffset += part;
+        length -= part;
+    }
+
+    return true;
+}
+
+QStringList JsonLinesModel::keys() const
+{
+    return this->schema.keys();
+}
+
+QStringList JsonLinesModel::rowValues(int row) const
+{
+    if (row < 0 || row >= this->rows.size()) {
+        return QStringList();
+    }
+
+    const RowRef &ref = this->rows.at(row);
+    if (ref.stored >= 0) {
+        return storedValues(this->storedRows, this->storedOtherKeys, ref, this->source, this->schema.keys());
+    }
+
+    if (ref.isRaw()) {
+        return rawValues(this->badLineList.at(ref.badLine()), this->schema.count());
+    }
+
+    if (QStringList *cached = this->rowCache.object(ref.offset)) {
+        return *cached;
+    }
+
+    QStringList values = decodeLine(this->readLine(ref), this->schema.keys());
+    this->rowCache.insert(ref.offset, new QStringList(values));
+
+    return values;
+}
+
+void JsonLinesModel::setRowValues(int row, const QStringList &values)
+{
+    if (row < 0 || row >= this->rows.size()) {
+        return;
+    }
+
+    // Only the known fields are kept, other keys are read from the source
+    // line and written back on save
+    RowRef &ref = this->rows[row];
+    if (ref.stored < 0) {
+        ref.stored = this->storedRows.append(values);
+    } else {
+        this->storedRows.replace(ref.stored, values);
+    }
+
+    emit dataChanged(index(row, 0), index(row, this->columnCount() - 1));
+}
+
+JsonLinesModel::RowContent JsonLinesModel::rowContent(int row) const
+{
+    RowContent content;
+
+    if (row < 0 || row >= this->rows.size()) {
+        return content;
+    }
+
+    const RowRef &ref = this->rows.at(row);
+    if (isSourceRow(ref)) {
+        content.sourceRef = ref;
+        content.sourceId = this->sourceId;
+    }
+
+    // Raw row is restored from its line
+    if (ref.isRaw()) {
+        content.badLine = ref.badLine();
+        return content;
+    }
+
+    content.values = this->rowValues(row).mid(0, ColumnCount);
+    content.otherKeys = this->otherKeys(this->rows.at(row));
+
+    return content;
+}
+
+bool JsonLinesModel::parseRowContent(const QByteArray &line, RowContent *content, QString *error)
+{
+    QByteArray trimmed = line.trimmed();
+
+    if (!JsonLinesParser::parseLine(trimmed.constData(), trimmed.constData() + trimmed.size(), error)) {
+        return false;
+    }
+
+    QJsonObject object = QJsonDocument::fromJson(trimmed).object();
+
+    content->values.clear();
+    for (const QString &key : fieldKeys()) {
+        content->values.append(JsonLinesSchema::valueText(object.value(key)));
+        object.remove(key);
+    }
+    content->otherKeys = object;
+    content->badLine = -1;
+
+    return true;
+}
+
+void JsonLinesModel::insertRowContents(const QVector<int> &rowList, const QVector<RowContent> &contents)
+{
+    int count = qMin(rowList.size(), contents.size());
+    if (count == 0) {
+        return;
+    }
+
+    // Keys of fixed lines may be new
+    for (int i = 0; i < count; i++) {
+        if (!contents.at(i).otherKeys.isEmpty()) {
+            this->addKeys(contents.at(i).otherKeys.keys());
+        }
+    }
+
+    auto storeContent = [this](const RowContent &content) {
+        // Line of the file as it was
+        if (content.sourceId == this->sourceId && isSourceRow(content.sourceRef)) {
+            return content.sourceRef;
+        }
+
+        RowRef ref;
+        if (content.badLine >= 0 && content.badLine < this->badLineList.size()) {
+            ref.stored = JsonLinesRowRef::rawStored(content.badLine);
+            return ref;
+        }
+        ref.stored = this->storedRows.append(content.values.mid(0, ColumnCount));
+        if (!content.otherKeys.isEmpty()) {
+            this->storedOtherKeys.insert(ref.stored, content.otherKeys);
+        }
+        return ref;
+    };
+
+    // Many runs: one merge of the rows instead of a move per run
+    if (runCount(rowList.mid(0, count)) > bulkRunCount) {
+        beginResetModel();
+
+        QVector<RowRef> merged;
+        merged.reserve(this->rows.size() + count);
+        QVector<int> insertedRows;
+        insertedRows.reserve(count);
+
+        int next = 0;
+        for (int i = 0; i < count; i++) {
+            while (merged.size() < rowList.at(i) && next < this->rows.size()) {
+                merged.append(this->rows.at(next++));
+            }
+            insertedRows.append(int(merged.size()));
+            merged.append(storeContent(contents.at(i)));
+        }
+        while (next < this->rows.size()) {
+            merged.append(this->rows.at(next++));
+        }
+        this->rows = merged;
+
+        emit rowListInserted(insertedRows);
+        endResetModel();
+        return;
+    }
+
+    // Ascending, so every run goes to its final row numbers
+    int first = 0;
+    while (first < count) {
+        int last = first;
+        while (last + 1 < count && rowList.at(last + 1) == rowList.at(last) + 1) {
+            last++;
+        }
+
+        int row = qBound(0, rowList.at(first), int(this->rows.size()));
+        QVector<RowRef> run;
+        run.reserve(last - first + 1);
+        for (int i = first; i <= last; i++) {
+            run.append(storeContent(contents.at(i)));
+        }
+
+        beginInsertRows(QModelIndex(), row, row + run.size() - 1);
+        this->rows.insert(row, run.size(), RowRef());
+        std::copy(run.constBegin(), run.constEnd(), this->rows.begin() + row);
+        endInsertRows();
+
+        first = last + 1;
+    }
+}
+
+int JsonLinesModel::appendRow(const QStringList &values)
+{
+    int row = this->rows.size();
+
+    this->insertRows(row, 1);
+    if (!values.isEmpty()) {
+        this->setRowValues(row, values);
+    }
+
+    return row;
+}
+
+QString JsonLinesModel::errorString() const
+{
+    return this->errorStr;
+}
+
+int JsonLinesModel::errorLine() const
+{
+    return this->errorLineNumber;
+}
+
+QString JsonLinesModel::errorLineText() const
+{
+    return this->errorLineStr;
+}
+
+qint64 JsonLinesModel::rowKey(int row) const
+{
+    return refKey(this->rows.at(row));
+}
+
+QHash<qint64, int> JsonLinesModel::rowKeyMap() const
+{
+    QHash<qint64, int> rowKeys;
+    rowKeys.reserve(this->rows.size());
+
+    for (int row = 0; row < this->rows.size(); row++) {
+        rowKeys.insert(refKey(this->rows.at(row)), row);
+    }
+
+    return rowKeys;
+}
+
+int JsonLinesModel::findRowKey(qint64 key) const
+{
+    if (key < 0) {
+        for (int row = 0; row < this->rows.size(); row++) {
+            if (refKey(this->rows.at(row)) == key) {
+                return row;
+            }
+        }
+        return -1;
+    }
+
+    // Rows read from the file keep the file order, in-memory rows between
+    // them are stepped over
+    int low = 0;
+    int high = this->rows.size() - 1;
+
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        int probe = mid;
+
+        while (probe <= high && !isSourceRow(this->rows.at(probe))) {
+            probe++;
+        }
+
+        if (probe > high) {
+            high = mid - 1;
+            continue;
+        }
+
+        qint64 offset = this->rows.at(probe).offset;
+        if (offset == key) {
+            return probe;
+        }
+
+        if (offset < key) {
+            low = probe + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+
+    return -1;
+}
+
+JsonLinesModel::Snapshot JsonLinesModel::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.source = this->source;
+    snapshot.rows = this->rows;
+    snapshot.storedRows = this->storedRows;
+    snapshot.storedOtherKeys = this->storedOtherKeys;
+    snapshot.badLines = this->badLineList;
+    snapshot.keys = this->schema.keys();
+    return snapshot;
+}
+
+QStringList JsonLinesModel::Snapshot::rowValues(int row) const
+{
+    const RowRef &ref = this->rows.at(row);
+
+    if (ref.stored >= 0) {
+        return storedValues(this->storedRows, this->storedOtherKeys, ref, this->source, this->keys);
+    }
+
+    if (ref.isRaw()) {
+        return rawValues(this->badLines.at(ref.badLine()), this->keys.size());
+    }
+
+    if (ref.offset < 0) {
+        return QStringList();
+    }
+
+    return decodeLine(this->source.read(ref.offset, ref.length), this->keys);
+}
+
+qint64 JsonLinesModel::Snapshot::rowKey(int row) const
+{
+    return refKey(this->rows.at(row));
+}
+
+// Stored rows count down from -1, raw rows without a source line below
+// any of them
+qint64 JsonLinesModel::refKey(const RowRef &ref)
+{
+    if (ref.stored >= 0) {
+        return -qint64(ref.stored) - 1;
+    }
+
+    if (ref.offset < 0) {
+        return qint64(INT_MIN) + ref.stored;
+    }
+
+    return ref.offset;
+}
+
+// Rows still read from the source as they are there
+bool JsonLinesModel::isSourceRow(const RowRef &ref)
+{
+    return ref.stored < 0 && ref.offset >= 0;
+}
+
+QStringList JsonLinesModel::rawValues(const JsonLinesParser::Error &badLine, int columnCount)
+{
+    QStringList values;
+    values.reserve(columnCount);
+    values.append(badLine.lineText);
+    while (values.size() < columnCount) {
+        values.append(QString());
+    }
+
+    return values;
+}
+
+void JsonLinesModel::setTolerantLoading(bool isTolerant)
+{
+    this->isTolerant = isTolerant;
+}
+
+bool JsonLinesModel::isTolerantLoading() const
+{
+    return this->isTolerant;
+}
+
+bool JsonLinesModel::isRawRow(int row) const
+{
+    return row >= 0 && row < this->rows.size() && this->rows.at(row).isRaw();
+}
+
+JsonLinesParser::Error JsonLinesModel::badLine(int row) const
+{
+    if (!this->isRawRow(row)) {
+        return JsonLinesParser::Error();
+    }
+
+    return this->badLineList.at(this->rows.at(row).badLine());
+}
+
+QVector<JsonLinesParser::Error> JsonLinesModel::badLines() const
+{
+    return this->badLineList;
+}
+
+QByteArray JsonLinesModel::readLine(const RowRef &ref) const
+{
+    if (ref.offset < 0) {
+        return QByteArray();
+    }
+
+    return this->source.read(ref.offset, ref.length);
+}
+
+QStringList JsonLinesModel::decodeLine(const QByteArray &line)
+{
+    return decodeLine(line, fieldKeys());
+}
+
+QStringList JsonLinesModel::decodeLine(const QByteArray &line, const QStringList &keys)
+{
+    QJsonObject entryTerm = QJsonDocument::fromJson(line).object();
+    QStringList values;
+    values.reserve(keys.size());
+
+    for (const QString &key : keys) {
+        values.append(JsonLinesSchema::valueText(entryTerm.value(key)));
+    }
+
+    return values;
+}
+
+QStringList JsonLinesModel::storedValues(const JsonLinesColumns &storedRows, const QHash<qint32, QJsonObject> &storedOtherKeys,
+                                         const RowRef &ref, const JsonLinesSource &source, const QStringList &keys)
+{
+    QStringList values = storedRows.rowValues(ref.stored);
+
+    if (keys.size() <= ColumnCount) {
+        return values;
+    }
+
+    // Other columns of an edited row come from its source line, of a
+    // restored one from the keys kept with it
+    QHash<qint32, QJsonObject>::const_iterator found = storedOtherKeys.constFind(ref.stored);
+    if (found != storedOtherKeys.constEnd()) {
+        for (int column = ColumnCount; column < keys.size(); column++) {
+            values.append(JsonLinesSchema::valueText(found->value(keys.at(column))));
+        }
+    } else if (ref.offset >= 0) {
+        QStringList lineValues = decodeLine(source.read(ref.offset, ref.length), keys.mid(ColumnCount));
+        values.append(lineValues);
+    }
+
+    return values;
+}
+
+QJsonObject JsonLinesModel::otherKeys(const RowRef &ref) const
+{
+    if (ref.stored >= 0 && this->storedOtherKeys.contains(ref.stored)) {
+        return this->storedOtherKeys.value(ref.stored);
+    }
+
+    QJsonObject object;
+    if (this->schema.count() > ColumnCount && ref.offset >= 0) {
+        object = QJsonDocument::fromJson(this->readLine(ref)).object();
+        for (const QString &key : fieldKeys()) {
+            object.remove(key);
+        }
+    }
+
+    return object;
+}
+
+void JsonLinesModel::setError(const QString &error, int lineNumber, const QString &lineText)
+{
+    this->errorStr = error;
+    this->errorLineNumber = lineNumber;
+    this->errorLineStr = lineText;
+}
@@ -0,0 +1,227 @@
+#ifndef JSONLINESMODEL_H
+#define JSONLINESMODEL_H
+
+#include <QAbstractTableModel>
+#include <QCache>
+#include <QHash>
+#include <QJsonObject>
+#include <QPair>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+#include "jsonlinescolumns.h"
+#include "jsonlinesloader.h"
+#include "jsonlinesparser.h"
+#include "jsonlinesschema.h"
+
+// Table model over a JSON Lines file. The file is memory-mapped and only a
+// byte-offset index of it is kept in memory, rows are decoded on demand and
+// kept in a bounded LRU. Edited and inserted rows live in memory until the
+// next save, which copies unchanged rows as raw byte ranges and encodes only
+// the edited ones. startLoading() indexes the file in background and appends
+// rows in batches while the view is already usable, reusing the index saved
+// at indexPath by an earlier load when the file has not changed. Columns are
+// the known fields followed by other keys found in the data; those are read
+// only and kept as they are when an edited row is saved. readAppended()
+// follows a file that grows, parsing only the lines added since it was
+// indexed. A tolerant load keeps lines that are not JSON objects as raw
+// rows: their text shows in the first column, they are saved as they were
+// and replaced by a parsed row once fixed.
+class JsonLinesModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        ColumnTerm = 0,
+        ColumnTermOrig,
+        ColumnDefinition,
+        ColumnDefinitionOrig,
+        ColumnSource,
+        ColumnCount             // known fields, columnCount() adds found keys
+    };
+
+    // Implicitly shared copy of the rows, can be read from any thread while
+    // the model changes
+    struct Snapshot {
+        JsonLinesSource source;
+        QVector<JsonLinesRowRef> rows;
+        JsonLinesColumns storedRows;
+        QHash<qint32, QJsonObject> storedOtherKeys;
+        QVector<JsonLinesParser::Error> badLines;
+        QStringList keys;
+
+        int rowCount() const { return this->rows.size(); }
+        QStringList rowValues(int row) const;
+        qint64 rowKey(int row) const;
+        bool isRawRow(int row) const { return this->rows.at(row).isRaw(); }
+    };
+
+    explicit JsonLinesModel(QObject *parent = nullptr);
+    ~JsonLinesModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool insertRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+
+    bool load(const QString &filePath);
+    bool startLoading(const QString &filePath, const QString &indexPath = QString());
+    void cancelLoading();
+    bool isLoading() const;
+    int cachedRowCount() const;
+    // order[i] is the row written at i, every row once; the rows take that
+    // order once the file is written. Empty keeps the model order.
+    bool save(const QString &filePath, const QVector<int> &order = QVector<int>());
+    void clear();
+
+    // Used by the next startLoading() and readAppended()
+    void setTolerantLoading(bool isTolerant);
+    bool isTolerantLoading() const;
+
+    enum FollowStatus {
+        FollowUnchanged = 0,
+        FollowAppended,
+        FollowReplaced,         // truncated or replaced, has to be loaded again
+        FollowFailed
+    };
+
+    // Appends the rows of the complete lines added to the file since it was
+    // indexed, a line still being written is left for the next call. Row
+    // numbers and edited rows are kept.
+    FollowStatus readAppended(int *appendedRows);
+
+    // Column keys, the known fields first
+    QStringList keys() const;
+    QStringList rowValues(int row) const;
+    void setRowValues(int row, const QStringList &values);
+    int appendRow(const QStringList &values = QStringList());
+    // Removes many rows, one removal per run of adjacent rows, or one model
+    // reset with rowListRemoved() when there are many runs
+    void removeRowList(const QVector<int> &rowList);
+
+    // Whole row for undo: known field values and the other keys of the row.
+    // A row read from the file also keeps its line there and is put back as
+    // that line, copied as it is on save, until the file is saved or loaded
+    // again.
+    struct RowContent {
+        QStringList values;
+        QJsonObject otherKeys;
+        int badLine = -1;       // raw row: its line in badLines(), values are not set
+        JsonLinesRowRef sourceRef;
+        int sourceId = 0;       // source the ref points into
+    };
+
+    RowContent rowContent(int row) const;
+    // Content of a fixed line, false with the parse error otherwise
+    static bool parseRowContent(const QByteArray &line, RowContent *content, QString *error);
+    // rowList ascending, as row numbers after the insertion. One insertion
+    // per run of adjacent rows, or one model reset with rowListInserted()
+    // when there are many runs.
+    void insertRowContents(const QVector<int> &rowList, const QVector<RowContent> &contents);
+
+    // Row identity until the next load or save: source offset for rows read
+    // from the file, negative for rows kept in memory
+    qint64 rowKey(int row) const;
+    int findRowKey(qint64 key) const;
+    // Row of every key in one pass, for many lookups at once
+    QHash<qint64, int> rowKeyMap() const;
+
+    Snapshot snapshot() const;
+
+    // Rows of lines that could not be parsed, see setTolerantLoading()
+    bool isRawRow(int row) const;
+    JsonLinesParser::Error badLine(int row) const;
+    // Every line kept as a raw row since the load, in line order; fixed
+    // ones stay so that undo can restore them
+    QVector<JsonLinesParser::Error> badLines() const;
+
+    QString errorString() const;
+    int errorLine() const;
+    QString errorLineText() const;
+
+    struct SaveStats {
+        int copiedRows = 0;         // unchanged rows copied as byte ranges
+        qint64 copiedBytes = 0;
+        int encodedRows = 0;        // edited and inserted rows
+        int rawRows = 0;            // lines that could not be parsed, written as they were
+    };
+
+    SaveStats saveStats() const;
+    // Row keys the last save changed, old key first
+    QVector<QPair<qint64, qint64>> savedKeyChanges() const;
+
+    static const QStringList &fieldKeys();
+    // Values of the known fields, or of the given keys
+    static QStringList decodeLine(const QByteArray &line);
+    static QStringList decodeLine(const QByteArray &line, const QStringList &keys);
+
+signals:
+    void loadingProgress(qint64 bytesLoaded, qint64 bytesTotal, int rowsLoaded);
+    void loadingFinished(int status);
+    // Emitted inside the model reset of a bulk removeRowList() or
+    // insertRowContents(), rows ascending, so that per row state can be
+    // carried over instead of rebuilt
+    void rowListRemoved(const QVector<int> &rows);
+    void rowListInserted(const QVector<int> &rows);
+
+private slots:
+    void loaderRowsLoaded(int loadId, const QVector<JsonLinesRowRef> &rows);
+    void loaderKeysFound(int loadId, const QStringList &keys);
+    void loaderBadLinesFound(int loadId, const QVector<JsonLinesParser::Error> &badLines);
+    void loaderIndexReused(int loadId, int cachedRows);
+    void loaderProgress(int loadId, qint64 bytesLoaded, qint64 bytesTotal, int rowsLoaded);
+    void loaderFinished(int loadId, int status, const JsonLinesParser::Error &error);
+
+private:
+    typedef JsonLinesRowRef RowRef;
+
+    static const int rowCacheSize = 4096;
+    // More runs of adjacent rows are removed or inserted in one pass
+    static const int bulkRunCount = 16;
+
+    QByteArray readLine(const RowRef &ref) const;
+    static qint64 refKey(const RowRef &ref);
+    static QStringList rawValues(const JsonLinesParser::Error &badLine, int columnCount);
+    static bool isSourceRow(const RowRef &ref);
+    static int runCount(const QVector<int> &rowList);
+    static QStringList storedValues(const JsonLinesColumns &storedRows, const QHash<qint32, QJsonObject> &storedOtherKeys,
+                                    const RowRef &ref, const JsonLinesSource &source, const QStringList &keys);
+    QJsonObject otherKeys(const RowRef &ref) const;
+    bool isAdjacent(const RowRef &ref, const RowRef &next) const;
+    bool copySourceRange(QIODevice *target, qint64 sourceOffset, qint64 length, qint64 targetOffset);
+    void addKeys(const QStringList &keys);
+    void setIndexedSize(qint64 size);
+    void setError(const QString &error, int lineNumber = 0, const QString &lineText = QString());
+    void stopLoader();
+
+    JsonLinesSource source;
+    int sourceId = 0;                   // changes with source, row offsets are in it
+    QVector<RowRef> rows;
+    JsonLinesSchema schema;
+    JsonLinesColumns storedRows;        // known fields of edited and inserted rows
+    QHash<qint32, QJsonObject> storedOtherKeys;     // other keys of restored rows without a source line
+    QVector<JsonLinesParser::Error> badLineList;    // raw rows point to them, see JsonLinesRowRef::isRaw()
+    bool isTolerant = false;
+    mutable QCache<qint64, QStringList> rowCache;
+
+    qint64 indexedSize = 0;             // source bytes the rows were read from
+    QByteArray indexedFingerprint;      // JsonLinesIndex::makeFingerprint() of them
+
+    SaveStats lastSaveStats;
+    QVector<QPair<qint64, qint64>> lastKeyChanges;
+
+    QThread *loaderThread = nullptr;
+    JsonLinesLoader *loader = nullptr;
+    int loadId = 0;
+    int cachedRows = 0;             // rows taken from the saved index
+
+    QString errorStr;
+    int errorLineNumber = 0;
+    QString errorLineStr;
+};
+
+#endif // JSONLINESMODEL_H
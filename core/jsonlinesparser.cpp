@@ -0,0 +1,204 @@
+#include "jsonlinesparser.h"
+#include "jsonlinesschema.h"
+#include "linescanner.h"
+#include "tracer.h"
+
+#include <QJsonDocument>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <climits>
+#include <cstring>
+
+qint64 JsonLinesParser::dataStart(const char *data, qint64 size)
+{
+    // Same as QTextStream: skip UTF-8 BOM
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        return 3;
+    }
+    return 0;
+}
+
+QVector<JsonLinesParser::Chunk> JsonLinesParser::splitChunks(const char *data, qint64 size, int chunkCount, qint64 from)
+{
+    TraceSpan span("line split");
+
+    QVector<Chunk> chunks;
+
+    qint64 start = qMax(from, dataStart(data, size));
+    qint64 chunkSize = qMax(minChunkSize, (size - start) / qMax(1, chunkCount) + 1);
+
+    while (start < size) {
+        qint64 end = size;
+
+        if (start + chunkSize < size) {
+            // Chunk ends right after a newline
+            end = LineScanner::findNewline(data + start + chunkSize, data + size) - data;
+            end = qMin(end + 1, size);
+        }
+
+        Chunk chunk;
+        chunk.index = chunks.size();
+        chunk.begin = start;
+        chunk.end = end;
+        chunks.append(chunk);
+
+        start = end;
+    }
+
+    return chunks;
+}
+
+bool JsonLinesParser::parseLine(const char *begin, const char *end, QString *errorMessage, QStringList *keys)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(begin, end - begin), &parseError);
+
+    if (parseError.error != QJsonParseError::NoError) {
+        *errorMessage = parseError.errorString();
+        return false;
+    }
+
+    if (!doc.isObject()) {
+        *errorMessage = "Not JSON object";
+        return false;
+    }
+
+    if (keys) {
+        JsonLinesSchema::collectKeys(doc.object(), keys);
+    }
+
+    return true;
+}
+
+quint64 JsonLinesParser::hashLine(const char *begin, const char *end)
+{
+    quint64 hash = 14695981039346656037ULL;
+
+    for (const char *c = begin; c < end; c++) {
+        hash ^= uchar(*c);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+void JsonLinesParser::parseChunk(const char *data, Chunk &chunk, QAtomicInt *errorChunk, bool isTolerant)
+{
+    TraceSpan span("parse chunk");
+
+    chunk.rows.clear();
+    chunk.keys.clear();
+    chunk.badLines.clear();
+    chunk.hasError = false;
+
+    chunk.lineCount = LineScanner::forEachLine(data + chunk.begin, chunk.end - chunk.begin,
+                                               [&](int lineNumber, const char *begin, const char *end) {
+        // Error is already found in an earlier chunk, this one is not needed
+        if (errorChunk && errorChunk->loadRelaxed() < chunk.index) {
+            return false;
+        }
+
+        QString message;
+        bool isParsed = parseLine(begin, end, &message, &chunk.keys);
+
+        if (!isParsed && isTolerant) {
+            Error badLine;
+            badLine.lineNumber = lineNumber;
+            badLine.message = message;
+            badLine.lineText = QString::fromUtf8(begin, end - begin);
+
+            JsonLinesRowRef ref;
+            ref.offset = begin - data;
+            ref.length = quint32(end - begin);
+            ref.stored = JsonLinesRowRef::rawStored(chunk.badLines.size());
+            chunk.rows.append(ref);
+            chunk.badLines.append(badLine);
+
+            return true;
+        }
+
+        if (!isParsed) {
+            chunk.hasError = true;
+            chunk.error.lineNumber = lineNumber;
+            chunk.error.message = message;
+            chunk.error.lineText = QString::fromUtf8(begin, end - begin);
+
+            if (errorChunk) {
+                int current = errorChunk->loadRelaxed();
+                while (chunk.index < current && !errorChunk->testAndSetRelaxed(current, chunk.index, current)) {
+                }
+            }
+            return false;
+        }
+
+        JsonLinesRowRef ref;
+        ref.offset = begin - data;
+        ref.length = quint32(end - begin);
+        chunk.rows.append(ref);
+
+        return true;
+    });
+}
+
+void JsonLinesParser::placeBadLines(Chunk &chunk, int firstBadLine, int linesBefore)
+{
+    if (chunk.badLines.isEmpty()) {
+        return;
+    }
+
+    for (JsonLinesRowRef &ref : chunk.rows) {
+        if (ref.isRaw()) {
+            ref.stored -= firstBadLine;
+        }
+    }
+
+    for (Error &badLine : chunk.badLines) {
+        badLine.lineNumber += linesBefore;
+    }
+}
+
+bool JsonLinesParser::indexLines(const char *data, qint64 size, QVector<JsonLinesRowRef> *rows, Error *error,
+                                 QStringList *keys)
+{
+    TraceSpan span("parse");
+
+    QVector<Chunk> chunks = splitChunks(data, size, QThread::idealThreadCount() * 4);
+    QAtomicInt errorChunk(INT_MAX);
+
+    QtConcurrent::blockingMap(chunks, [data, &errorChunk](Chunk &chunk) {
+        parseChunk(data, chunk, &errorChunk);
+    });
+
+    // First error in line order wins
+    int linesBefore = 0;
+    qsizetype rowCount = 0;
+
+    for (const Chunk &chunk : chunks) {
+        if (chunk.hasError) {
+            *error = chunk.error;
+            error->lineNumber += linesBefore;
+            return false;
+        }
+        linesBefore += chunk.lineCount;
+        rowCount += chunk.rows.size();
+    }
+
+    rows->clear();
+    rows->reserve(rowCount);
+
+    for (Chunk &chunk : chunks) {
+        rows->append(chunk.rows);
+        chunk.rows = QVector<JsonLinesRowRef>();
+
+        if (keys) {
+            for (const QString &key : chunk.keys) {
+                if (!keys->contains(key)) {
+                    keys->append(key);
+                }
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef JSONLINESPARSER_H
+#define JSONLINESPARSER_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct JsonLinesRowRef {
+    qint64 offset = -1;     // start of the trimmed line in the source file
+    quint32 length = 0;     // trimmed line length in bytes
+    qint32 stored = -1;     // index of in-memory row for edited/inserted rows, rawStored() for raw rows
+
+    // Line that could not be parsed, kept as text by a tolerant load
+    bool isRaw() const { return this->stored <= -2; }
+    int badLine() const { return -2 - this->stored; }
+    static qint32 rawStored(int badLine) { return -2 - badLine; }
+};
+
+// Validates and indexes JSON Lines data. The data is split into chunks at
+// line boundaries, chunks are parsed on the global thread pool and merged
+// back in line order.
+class JsonLinesParser
+{
+public:
+    struct Error {
+        int lineNumber = 0;
+        QString message;
+        QString lineText;
+    };
+
+    struct Chunk {
+        int index = 0;
+        qint64 begin = 0;       // byte range in data
+        qint64 end = 0;
+        QVector<JsonLinesRowRef> rows;
+        int lineCount = 0;
+        bool hasError = false;
+        Error error;            // line number is relative to the chunk
+        QVector<Error> badLines;        // tolerant parse: raw rows in order, rawStored() counts from 0 in the chunk
+        QStringList keys;       // keys beyond the known fields, first seen first
+    };
+
+    static const qint64 minChunkSize = 1024 * 1024;
+
+    // keys gets the keys beyond the known fields in order of appearance
+    static bool indexLines(const char *data, qint64 size, QVector<JsonLinesRowRef> *rows, Error *error,
+                           QStringList *keys = nullptr);
+
+    static qint64 dataStart(const char *data, qint64 size);
+    // Chunks cover [from, size), from must be a line start
+    static QVector<Chunk> splitChunks(const char *data, qint64 size, int chunkCount, qint64 from = 0);
+    // errorChunk holds the lowest failed chunk index, chunks after it stop
+    // early. A negative value stops all of them. A tolerant parse does not
+    // fail, lines that are not JSON objects become raw rows.
+    static void parseChunk(const char *data, Chunk &chunk, QAtomicInt *errorChunk = nullptr, bool isTolerant = false);
+    static bool parseLine(const char *begin, const char *end, QString *errorMessage, QStringList *keys = nullptr);
+    // Raw rows of a tolerant parse numbered from firstBadLine, their line
+    // numbers counted from the data start
+    static void placeBadLines(Chunk &chunk, int firstBadLine, int linesBefore);
+
+    // 64-bit FNV-1a, stable between runs unlike qHash()
+    static quint64 hashLine(const char *begin, const char *end);
+};
+
+#endif // JSONLINESPARSER_H
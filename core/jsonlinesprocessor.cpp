@@ -0,0 +1,272 @@
+#include "jsonlinesprocessor.h"
+#include "jsonlinesmodel.h"
+#include "jsonlinesschema.h"
+#include "jsonlineswriter.h"
+#include "linescanner.h"
+#include "tracer.h"
+
+#include <QBuffer>
+#include <QFileDevice>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QtConcurrent>
+
+// Set of nonzero hashes in one flat array with linear probing, zero marks
+// a free slot. At most half full, so 16 to 32 bytes per hash.
+class HashSet
+{
+public:
+    // false when the hash was in the set already
+    bool insert(quint64 hash)
+    {
+        if ((this->count + 1) * 2 > this->slots.size()) {
+            this->grow();
+        }
+
+        qint64 mask = this->slots.size() - 1;
+        for (qint64 i = hash & mask; ; i = (i + 1) & mask) {
+            if (this->slots.at(i) == hash) {
+                return false;
+            }
+            if (this->slots.at(i) == 0) {
+                this->slots[i] = hash;
+                this->count++;
+                return true;
+            }
+        }
+    }
+
+private:
+    void grow()
+    {
+        QVector<quint64> old = this->slots;
+        this->slots = QVector<quint64>(qMax<qint64>(1024, old.size() * 2), 0);
+        this->count = 0;
+
+        for (quint64 hash : old) {
+            if (hash != 0) {
+                this->insert(hash);
+            }
+        }
+    }
+
+    QVector<quint64> slots;         // size is a power of two
+    qint64 count = 0;
+};
+
+JsonLinesProcessor::JsonLinesProcessor(const Options &options)
+    : options(options)
+{
+
+}
+
+void JsonLinesProcessor::processChunk(const char *data, ChunkResult &result, bool isWriting) const
+{
+    TraceSpan span("process chunk");
+
+    result.stats.fields.resize(JsonLinesModel::ColumnCount);
+
+    QBuffer buffer(&result.output);
+    buffer.open(QIODevice::WriteOnly);
+    JsonLinesWriter writer(&buffer, JsonLinesModel::fieldKeys());
+
+    const QStringList &keys = JsonLinesModel::fieldKeys();
+
+    result.lineCount = LineScanner::forEachLine(data + result.begin, result.end - result.begin,
+                                                [&](int lineNumber, const char *begin, const char *end) {
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(begin, end - begin), &parseError);
+
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            result.stats.invalidRows++;
+            if (result.stats.errors.size() < this->options.maxErrors) {
+                JsonLinesParser::Error error;
+                error.lineNumber = lineNumber;
+                error.message = parseError.error != QJsonParseError::NoError ? parseError.errorString() : "Not JSON object";
+                error.lineText = QString::fromUtf8(begin, end - begin);
+                result.stats.errors.append(error);
+            }
+            return true;
+        }
+
+        result.stats.rows++;
+
+        QJsonObject object = doc.object();
+        QStringList values;
+        bool isEmpty = true;
+
+        for (int column = 0; column < keys.size(); column++) {
+            QString value = object.value(keys.at(column)).toString();
+            if (this->options.normalize) {
+                value = value.trimmed();
+            }
+
+            if (!value.trimmed().isEmpty()) {
+                isEmpty = false;
+                result.stats.fields[column].filled++;
+                result.stats.fields[column].length += value.size();
+            }
+            values.append(value);
+        }
+
+        if (isEmpty) {
+            result.stats.emptyRows++;
+        }
+
+        // Same as saving in the editor: rows without values are not written
+        if (!isWriting || (this->options.normalize && isEmpty)) {
+            return true;
+        }
+
+        if (this->options.normalize) {
+            QStringList otherKeys;
+            JsonLinesSchema::collectKeys(object, &otherKeys);
+
+            if (otherKeys.isEmpty()) {
+                writer.writeRow(values);
+            } else {
+                // Keys beyond the known fields are kept as they are
+                for (int column = 0; column < keys.size(); column++) {
+                    object.insert(keys.at(column), values.at(column));
+                }
+                QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+                writer.writeRaw(line.constData(), line.size());
+                writer.writeRaw("\n", 1);
+            }
+            result.lineEnds.append(int(writer.pos()));
+        } else {
+            result.output.append(begin, end - begin);
+            result.output.append('\n');
+            result.lineEnds.append(result.output.size());
+        }
+
+        result.hashes.append(this->options.dedupe ? DuplicateFinder::hashValues(values, this->options.dedupeFields) : 0);
+
+        return true;
+    });
+
+    writer.flush();
+}
+
+bool JsonLinesProcessor::run(QIODevice *input, QIODevice *output, Stats *stats, QString *error)
+{
+    *stats = Stats();
+    stats->fields.resize(JsonLinesModel::ColumnCount);
+
+    HashSet seen;
+    QByteArray block;
+    bool isEnd = false;
+
+    while (!isEnd) {
+        // Read until the block holds at least one line break
+        qint64 target = this->options.blockSize;
+        qint64 cut = -1;
+
+        while (cut < 0) {
+            while (block.size() < target) {
+                QByteArray part = input->read(target - block.size());
+                if (part.isEmpty()) {
+                    break;
+                }
+                block.append(part);
+            }
+
+            if (block.size() < target) {
+                QFileDevice *file = qobject_cast<QFileDevice *>(input);
+                if (file && file->error() != QFileDevice::NoError) {
+                    *error = file->errorString();
+                    return false;
+                }
+                isEnd = true;
+                cut = block.size();
+                break;
+            }
+
+            cut = block.lastIndexOf('\n') + 1;
+            if (cut == 0) {
+                cut = -1;
+                target += this->options.blockSize;
+            }
+        }
+
+        if (cut == 0) {
+            break;
+        }
+
+        TraceSpan span("process block");
+
+        const char *data = block.constData();
+        QVector<JsonLinesParser::Chunk> chunks = JsonLinesParser::splitChunks(data, cut, QThread::idealThreadCount() * 4);
+
+        QVector<ChunkResult> results(chunks.size());
+        for (int i = 0; i < chunks.size(); i++) {
+            results[i].begin = chunks.at(i).begin;
+            results[i].end = chunks.at(i).end;
+        }
+
+        bool isWriting = output != nullptr;
+        QtConcurrent::blockingMap(results, [this, data, isWriting](ChunkResult &result) {
+            this->processChunk(data, result, isWriting);
+        });
+
+        // Merge in line order
+        for (ChunkResult &result : results) {
+            for (JsonLinesParser::Error chunkError : result.stats.errors) {
+                if (stats->errors.size() >= this->options.maxErrors) {
+                    break;
+                }
+                chunkError.lineNumber += int(stats->lines);
+                stats->errors.append(chunkError);
+            }
+
+            stats->lines += result.lineCount;
+            stats->rows += result.stats.rows;
+            stats->invalidRows += result.stats.invalidRows;
+            stats->emptyRows += result.stats.emptyRows;
+
+            for (int column = 0; column < stats->fields.size(); column++) {
+                stats->fields[column].filled += result.stats.fields.at(column).filled;
+                stats->fields[column].length += result.stats.fields.at(column).length;
+            }
+
+            if (!isWriting) {
+                continue;
+            }
+
+            TraceSpan writeSpan("write");
+
+            if (!this->options.dedupe) {
+                if (output->write(result.output) != result.output.size()) {
+                    *error = output->errorString();
+                    return false;
+                }
+                stats->writtenRows += result.lineEnds.size();
+                continue;
+            }
+
+            int lineStart = 0;
+            for (int i = 0; i < result.lineEnds.size(); i++) {
+                int lineEnd = result.lineEnds.at(i);
+                quint64 hash = result.hashes.at(i);
+
+                if (hash != 0 && !seen.insert(hash)) {
+                    stats->duplicateRows++;
+                } else {
+                    if (output->write(result.output.constData() + lineStart, lineEnd - lineStart) != lineEnd - lineStart) {
+                        *error = output->errorString();
+                        return false;
+                    }
+                    stats->writtenRows++;
+                }
+
+                lineStart = lineEnd;
+            }
+        }
+
+        stats->bytes += cut;
+        block.remove(0, cut);
+    }
+
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef JSONLINESPROCESSOR_H
+#define JSONLINESPROCESSOR_H
+
+#include <QIODevice>
+#include <QVector>
+
+#include "duplicatefinder.h"
+#include "jsonlinesparser.h"
+
+// Streaming batch processing for the command line: validation, statistics,
+// normalization and deduplication in one pass. Input is read in blocks
+// ending at a line break, every block is split into chunks parsed on the
+// global thread pool, results are merged in line order. Memory use is
+// bounded by the block size, plus 16 to 32 bytes per unique row when
+// deduplicating.
+class JsonLinesProcessor
+{
+public:
+    struct Options {
+        bool normalize = false;         // re-encode rows with trimmed values
+        bool dedupe = false;            // keep first row of each duplicate group
+        DuplicateFinder::Fields dedupeFields = DuplicateFinder::AllFields;
+        qint64 blockSize = 64 * 1024 * 1024;
+        int maxErrors = 100;            // errors kept for the report
+    };
+
+    struct FieldStats {
+        qint64 filled = 0;              // rows with non-empty value
+        qint64 length = 0;              // total length in characters
+    };
+
+    struct Stats {
+        qint64 bytes = 0;
+        qint64 lines = 0;               // blank lines too
+        qint64 rows = 0;                // valid rows
+        qint64 invalidRows = 0;
+        qint64 emptyRows = 0;           // valid rows with every field empty
+        qint64 duplicateRows = 0;
+        qint64 writtenRows = 0;
+        QVector<FieldStats> fields;
+        QVector<JsonLinesParser::Error> errors;
+    };
+
+    explicit JsonLinesProcessor(const Options &options);
+
+    // output can be null when nothing is written
+    bool run(QIODevice *input, QIODevice *output, Stats *stats, QString *error);
+
+private:
+    struct ChunkResult {
+        qint64 begin = 0;
+        qint64 end = 0;
+        int lineCount = 0;
+        QByteArray output;              // kept rows, one per line
+        QVector<int> lineEnds;          // end of every row in output
+        QVector<quint64> hashes;        // dedupe hash of every row in output
+        Stats stats;
+    };
+
+    void processChunk(const char *data, ChunkResult &result, bool isWriting) const;
+
+    Options options;
+};
+
+#endif // JSONLINESPROCESSOR_H
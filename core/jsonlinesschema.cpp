@@ -0,0 +1,100 @@
+#include "jsonlinesschema.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+
+JsonLinesSchema::JsonLinesSchema()
+{
+    this->addKeys(fieldKeys());
+}
+
+const QStringList &JsonLinesSchema::fieldKeys()
+{
+    static const QStringList keys = {
+        "term",
+        "original_term",
+        "definition",
+        "original_definition",
+        "source"
+    };
+    return keys;
+}
+
+bool JsonLinesSchema::isFieldKey(const QString &key)
+{
+    return fieldKeys().contains(key);
+}
+
+int JsonLinesSchema::count() const
+{
+    return this->keyList.size();
+}
+
+const QStringList &JsonLinesSchema::keys() const
+{
+    return this->keyList;
+}
+
+QString JsonLinesSchema::key(int column) const
+{
+    return this->keyList.value(column);
+}
+
+int JsonLinesSchema::indexOf(const QString &key) const
+{
+    return this->keyIndex.value(key, -1);
+}
+
+int JsonLinesSchema::addKeys(const QStringList &keys)
+{
+    int added = 0;
+
+    for (const QString &key : keys) {
+        if (!this->keyIndex.contains(key)) {
+            this->keyIndex.insert(key, this->keyList.size());
+            this->keyList.append(key);
+            added++;
+        }
+    }
+
+    return added;
+}
+
+void JsonLinesSchema::collectKeys(const QJsonObject &object, QStringList *keys)
+{
+    // Most rows have just the known fields
+    int known = 0;
+    for (const QString &key : fieldKeys()) {
+        if (object.contains(key)) {
+            known++;
+        }
+    }
+    if (object.size() == known) {
+        return;
+    }
+
+    for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+        QString key = it.key();
+        if (!isFieldKey(key) && !keys->contains(key)) {
+            keys->append(key);
+        }
+    }
+}
+
+QString JsonLinesSchema::valueText(const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::String:
+        return value.toString();
+    case QJsonValue::Undefined:
+        return QString();
+    case QJsonValue::Array:
+        return QString::fromUtf8(QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact));
+    case QJsonValue::Object:
+        return QString::fromUtf8(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+    default:
+        // Scalars are written the way QJsonDocument writes them in an array
+        QString text = QString::fromUtf8(QJsonDocument(QJsonArray({value})).toJson(QJsonDocument::Compact));
+        return text.mid(1, text.size() - 2);
+    }
+}
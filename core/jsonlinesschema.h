@@ -0,0 +1,36 @@
+#ifndef JSONLINESSCHEMA_H
+#define JSONLINESSCHEMA_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QStringList>
+
+// Column keys of a file: the five known fields first, then other keys found
+// in the data in order of first appearance. Every key string is kept once
+// and looked up by hash, rows refer to columns by index.
+class JsonLinesSchema
+{
+public:
+    JsonLinesSchema();
+
+    int count() const;
+    const QStringList &keys() const;
+    QString key(int column) const;
+    int indexOf(const QString &key) const;
+    // Appends keys not known yet, returns the number added
+    int addKeys(const QStringList &keys);
+
+    static const QStringList &fieldKeys();
+    static bool isFieldKey(const QString &key);
+    // Adds keys of object beyond the known fields missing from keys
+    static void collectKeys(const QJsonObject &object, QStringList *keys);
+    // Cell text: strings as they are, other values as compact JSON
+    static QString valueText(const QJsonValue &value);
+
+private:
+    QStringList keyList;
+    QHash<QString, int> keyIndex;
+};
+
+#endif // JSONLINESSCHEMA_H
@@ -0,0 +1,196 @@
+#include "jsonlineswriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+static inline char hexDigit(uint value)
+{
+    return char(value < 10 ? '0' + value : 'a' + value - 10);
+}
+
+JsonLinesWriter::JsonLinesWriter(QIODevice *device, const QStringList &keys, qsizetype bufferSize)
+    : device(device)
+    , bufferSize(bufferSize)
+{
+    this->buffer.reserve(bufferSize);
+
+    // Same order as QJsonObject keeps its keys
+    for (int i = 0; i < keys.size(); i++) {
+        this->keyOrder.append(i);
+    }
+    std::sort(this->keyOrder.begin(), this->keyOrder.end(), [&keys](int a, int b) {
+        return keys.at(a) < keys.at(b);
+    });
+
+    for (int i = 0; i < this->keyOrder.size(); i++) {
+        QByteArray prefix(i == 0 ? "{" : ",");
+        appendString(prefix, keys.at(this->keyOrder.at(i)));
+        prefix.append(':');
+        this->keyPrefixes.append(prefix);
+    }
+}
+
+void JsonLinesWriter::appendString(QByteArray &out, const QString &value)
+{
+    qsizetype start = out.size();
+
+    // Worst case: every UTF-16 unit written as \u00XX or \uXXXX
+    out.resize(start + value.size() * 6 + 2);
+
+    char *cursor = out.data() + start;
+    const ushort *src = value.utf16();
+    const ushort *end = src + value.size();
+
+    *cursor++ = '"';
+
+    while (src < end) {
+        uint u = *src++;
+
+        if (u < 0x80) {
+            if (u < 0x20 || u == 0x22 || u == 0x5c) {
+                *cursor++ = '\\';
+                switch (u) {
+                case 0x22:
+                    *cursor++ = '"';
+                    break;
+                case 0x5c:
+                    *cursor++ = '\\';
+                    break;
+                case 0x08:
+                    *cursor++ = 'b';
+                    break;
+                case 0x0c:
+                    *cursor++ = 'f';
+                    break;
+                case 0x0a:
+                    *cursor++ = 'n';
+                    break;
+                case 0x0d:
+                    *cursor++ = 'r';
+                    break;
+                case 0x09:
+                    *cursor++ = 't';
+                    break;
+                default:
+                    *cursor++ = 'u';
+                    *cursor++ = '0';
+                    *cursor++ = '0';
+                    *cursor++ = hexDigit(u >> 4);
+                    *cursor++ = hexDigit(u & 0xf);
+                    break;
+                }
+            } else {
+                *cursor++ = char(u);
+            }
+        } else if (u < 0x800) {
+            *cursor++ = char(0xc0 | (u >> 6));
+            *cursor++ = char(0x80 | (u & 0x3f));
+        } else if (QChar::isSurrogate(u)) {
+            if (QChar::isHighSurrogate(u) && src < end && QChar::isLowSurrogate(*src)) {
+                uint ucs4 = QChar::surrogateToUcs4(ushort(u), *src++);
+                *cursor++ = char(0xf0 | (ucs4 >> 18));
+                *cursor++ = char(0x80 | ((ucs4 >> 12) & 0x3f));
+                *cursor++ = char(0x80 | ((ucs4 >> 6) & 0x3f));
+                *cursor++ = char(0x80 | (ucs4 & 0x3f));
+            } else {
+                // Lone surrogate, QJsonDocument writes it as escape sequence
+                *cursor++ = '\\';
+                *cursor++ = 'u';
+                *cursor++ = hexDigit((u >> 12) & 0xf);
+                *cursor++ = hexDigit((u >> 8) & 0xf);
+                *cursor++ = hexDigit((u >> 4) & 0xf);
+                *cursor++ = hexDigit(u & 0xf);
+            }
+        } else {
+            *cursor++ = char(0xe0 | (u >> 12));
+            *cursor++ = char(0x80 | ((u >> 6) & 0x3f));
+            *cursor++ = char(0x80 | (u & 0x3f));
+        }
+    }
+
+    *cursor++ = '"';
+
+    out.resize(cursor - out.constData());
+}
+
+bool JsonLinesWriter::reserve(qsizetype length)
+{
+    if (!this->buffer.isEmpty() && this->buffer.size() + length > this->bufferSize) {
+        return this->flush();
+    }
+    return true;
+}
+
+qint64 JsonLinesWriter::writeRow(const QStringList &values)
+{
+    qsizetype needed = 2;
+    for (int i = 0; i < this->keyOrder.size(); i++) {
+        needed += this->keyPrefixes.at(i).size() + values.value(this->keyOrder.at(i)).size() * 6 + 2;
+    }
+
+    if (!this->reserve(needed + 1)) {
+        return -1;
+    }
+
+    qsizetype start = this->buffer.size();
+
+    if (this->keyOrder.isEmpty()) {
+        this->buffer.append('{');
+    }
+
+    for (int i = 0; i < this->keyOrder.size(); i++) {
+        this->buffer.append(this->keyPrefixes.at(i));
+        appendString(this->buffer, values.value(this->keyOrder.at(i)));
+    }
+
+    this->buffer.append('}');
+
+    qint64 length = this->buffer.size() - start;
+    this->buffer.append('\n');
+
+    return length;
+}
+
+bool JsonLinesWriter::writeRaw(const char *data, qint64 length)
+{
+    if (length >= this->bufferSize / 2) {
+        if (!this->flush() || this->device->write(data, length) != length) {
+            return false;
+        }
+        this->flushedBytes += length;
+        return true;
+    }
+
+    if (!this->reserve(length)) {
+        return false;
+    }
+    this->buffer.append(data, length);
+
+    return true;
+}
+
+void JsonLinesWriter::markWritten(qint64 length)
+{
+    this->flushedBytes += length;
+}
+
+bool JsonLinesWriter::flush()
+{
+    if (this->buffer.isEmpty()) {
+        return true;
+    }
+
+    if (this->device->write(this->buffer) != this->buffer.size()) {
+        return false;
+    }
+
+    this->flushedBytes += this->buffer.size();
+    this->buffer.truncate(0);
+
+    return true;
+}
+
+qint64 JsonLinesWriter::pos() const
+{
+    return this->flushedBytes + this->buffer.size();
+}
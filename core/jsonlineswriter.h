@@ -0,0 +1,46 @@
+#ifndef JSONLINESWRITER_H
+#define JSONLINESWRITER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QStringList>
+#include <QVector>
+
+// Buffered JSON Lines writer. Strings are escaped and encoded to UTF-8
+// straight into the output buffer. Output is byte for byte the same as
+// QJsonDocument(obj).toJson(QJsonDocument::Compact): keys are written in
+// QJsonObject (sorted) order, escaping follows QJsonDocument.
+class JsonLinesWriter
+{
+public:
+    static const qsizetype defaultBufferSize = 1024 * 1024;
+
+    JsonLinesWriter(QIODevice *device, const QStringList &keys, qsizetype bufferSize = defaultBufferSize);
+
+    // Values are in the keys order given to the constructor. Returns length
+    // of the written line without the newline, -1 on write error.
+    qint64 writeRow(const QStringList &values);
+    bool writeRaw(const char *data, qint64 length);
+    bool flush();
+
+    // Accounts bytes written to the device directly after flush()
+    void markWritten(qint64 length);
+
+    // Bytes written so far, including buffered ones
+    qint64 pos() const;
+
+    static void appendString(QByteArray &out, const QString &value);
+
+private:
+    bool reserve(qsizetype length);
+
+    QIODevice *device;
+    QByteArray buffer;
+    qsizetype bufferSize;
+    qint64 flushedBytes = 0;
+
+    QVector<int> keyOrder;              // column index for every sorted key
+    QVector<QByteArray> keyPrefixes;    // {"key": or ,"key":
+};
+
+#endif // JSONLINESWRITER_H
@@ -0,0 +1,150 @@
+#include "linescanner.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define LINESCANNER_X86_DISPATCH
+#  include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#  define LINESCANNER_X86_SSE2_ONLY
+#  include <emmintrin.h>
+#  include <intrin.h>
+#endif
+
+static inline int firstSetBit(unsigned int mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return int(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+const char *LineScanner::findNewlineScalar(const char *begin, const char *end)
+{
+    if (begin >= end) {
+        return end;
+    }
+
+    const void *found = memchr(begin, '\n', size_t(end - begin));
+    return found ? static_cast<const char *>(found) : end;
+}
+
+#if defined(LINESCANNER_X86_DISPATCH)
+__attribute__((target("sse2")))
+#endif
+const char *LineScanner::findNewlineSse2(const char *begin, const char *end)
+{
+#if defined(LINESCANNER_X86_DISPATCH) || defined(LINESCANNER_X86_SSE2_ONLY)
+    const __m128i newline = _mm_set1_epi8('\n');
+    const char *p = begin;
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned int mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        if (mask) {
+            return p + firstSetBit(mask);
+        }
+        p += 16;
+    }
+
+    while (p < end && *p != '\n') {
+        p++;
+    }
+    return p;
+#else
+    return findNewlineScalar(begin, end);
+#endif
+}
+
+#if defined(LINESCANNER_X86_DISPATCH)
+__attribute__((target("avx2")))
+#endif
+const char *LineScanner::findNewlineAvx2(const char *begin, const char *end)
+{
+#if defined(LINESCANNER_X86_DISPATCH)
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const char *p = begin;
+
+    // Two vectors per iteration, lines are usually longer than 32 bytes
+    while (end - p >= 64) {
+        __m256i chunk0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i chunk1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+        unsigned int mask0 = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk0, newline)));
+        unsigned int mask1 = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk1, newline)));
+        if (mask0) {
+            return p + firstSetBit(mask0);
+        }
+        if (mask1) {
+            return p + 32 + firstSetBit(mask1);
+        }
+        p += 64;
+    }
+
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned int mask = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        if (mask) {
+            return p + firstSetBit(mask);
+        }
+        p += 32;
+    }
+
+    while (p < end && *p != '\n') {
+        p++;
+    }
+    return p;
+#else
+    return findNewlineSse2(begin, end);
+#endif
+}
+
+bool LineScanner::hasSse2()
+{
+#if defined(LINESCANNER_X86_DISPATCH)
+    return __builtin_cpu_supports("sse2");
+#elif defined(LINESCANNER_X86_SSE2_ONLY)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LineScanner::hasAvx2()
+{
+#if defined(LINESCANNER_X86_DISPATCH)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+const char *LineScanner::simdLevel()
+{
+    if (hasAvx2()) {
+        return "AVX2";
+    }
+    if (hasSse2()) {
+        return "SSE2";
+    }
+    return "scalar";
+}
+
+static LineScanner::FindNewlineFunc resolveFindNewline()
+{
+    if (LineScanner::hasAvx2()) {
+        return &LineScanner::findNewlineAvx2;
+    }
+    if (LineScanner::hasSse2()) {
+        return &LineScanner::findNewlineSse2;
+    }
+    return &LineScanner::findNewlineScalar;
+}
+
+const char *LineScanner::findNewline(const char *begin, const char *end)
+{
+    static const FindNewlineFunc findNewlineFunc = resolveFindNewline();
+    return findNewlineFunc(begin, end);
+}
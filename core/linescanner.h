@@ -0,0 +1,70 @@
+#ifndef LINESCANNER_H
+#define LINESCANNER_H
+
+#include <QtGlobal>
+
+// Newline scanning over an in-memory (usually memory-mapped) buffer.
+// findNewline() picks the widest implementation the CPU supports at
+// runtime: AVX2, SSE2 or the scalar fallback.
+class LineScanner
+{
+public:
+    typedef const char *(*FindNewlineFunc)(const char *begin, const char *end);
+
+    // Returns pointer to the first '\n' in [begin, end) or end
+    static const char *findNewline(const char *begin, const char *end);
+
+    static const char *findNewlineScalar(const char *begin, const char *end);
+    static const char *findNewlineSse2(const char *begin, const char *end);
+    static const char *findNewlineAvx2(const char *begin, const char *end);
+
+    static bool hasSse2();
+    static bool hasAvx2();
+    static const char *simdLevel();
+
+    static inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    // Calls callback(lineNumber, begin, end) for every non-blank line with
+    // surrounding whitespace (including '\r') trimmed. Line numbers count
+    // blank lines too, same as the QTextStream::readLine() loop did. A last
+    // line without trailing newline is reported as well. Stops as soon as
+    // callback returns false. Returns the number of lines scanned.
+    template <typename Callback>
+    static int forEachLine(const char *data, qint64 size, Callback callback, int firstLineNumber = 1)
+    {
+        const char *end = data + size;
+        const char *lineStart = data;
+        int lineNumber = firstLineNumber - 1;
+
+        while (lineStart < end) {
+            const char *newline = findNewline(lineStart, end);
+            const char *begin = lineStart;
+            const char *last = newline;
+
+            lineStart = newline + 1;
+            lineNumber++;
+
+            while (begin < last && isSpace(*begin)) {
+                begin++;
+            }
+            while (last > begin && isSpace(*(last - 1))) {
+                last--;
+            }
+
+            if (begin == last) {
+                continue;
+            }
+
+            if (!callback(lineNumber, begin, last)) {
+                break;
+            }
+        }
+
+        return lineNumber - firstLineNumber + 1;
+    }
+};
+
+#endif // LINESCANNER_H
@@ -0,0 +1,586 @@
+#include "rowfilter.h"
+#include "tracer.h"
+
+#include <QtConcurrent>
+
+struct FilterToken {
+    enum Type {
+        End = 0,
+        Word,
+        String,             // "quoted" or /regex/, never a keyword
+        Symbol
+    };
+
+    Type type = End;
+    QString text;
+    int position = 0;
+};
+
+static bool tokenize(const QString &text, QVector<FilterToken> *tokens, QString *error)
+{
+    int pos = 0;
+
+    while (pos < text.size()) {
+        QChar c = text.at(pos);
+
+        if (c.isSpace()) {
+            pos++;
+            continue;
+        }
+
+        FilterToken token;
+        token.position = pos;
+
+        if (c == '"' || c == '/') {
+            // Backslash escapes the delimiter, other escapes are kept for the regex
+            QChar delimiter = c;
+            token.type = FilterToken::String;
+            pos++;
+            while (pos < text.size() && text.at(pos) != delimiter) {
+                QChar next = pos + 1 < text.size() ? text.at(pos + 1) : QChar();
+                if (text.at(pos) == '\\' && (next == delimiter || (delimiter == '"' && next == '\\'))) {
+                    pos++;
+                }
+                token.text.append(text.at(pos++));
+            }
+            if (pos == text.size()) {
+                *error = QString("Unterminated %1 at %2").arg(delimiter == '"' ? "string" : "regular expression").arg(token.position + 1);
+                return false;
+            }
+            pos++;
+        } else if (c.isLetterOrNumber() || c == '_' || c == '.' || c == '-') {
+            token.type = FilterToken::Word;
+            while (pos < text.size() && (text.at(pos).isLetterOrNumber() || text.at(pos) == '_' || text.at(pos) == '.' || text.at(pos) == '-')) {
+                token.text.append(text.at(pos++));
+            }
+        } else if ((c == '<' || c == '>' || c == '!') && pos + 1 < text.size() && text.at(pos + 1) == '=') {
+            token.type = FilterToken::Symbol;
+            token.text = text.mid(pos, 2);
+            pos += 2;
+        } else if (c == '(' || c == ')' || c == '<' || c == '>' || c == '=' || c == '~') {
+            token.type = FilterToken::Symbol;
+            token.text = c;
+            pos++;
+        } else {
+            *error = QString("Unexpected \"%1\" at %2").arg(c).arg(pos + 1);
+            return false;
+        }
+
+        tokens->append(token);
+    }
+
+    FilterToken end;
+    end.position = text.size();
+    tokens->append(end);
+
+    return true;
+}
+
+// Recursive descent over the tokens, or binds weaker than and
+class RowFilterParser
+{
+public:
+    RowFilterParser(RowFilter *filter, const QVector<FilterToken> &tokens, const QStringList &columns)
+        : filter(filter)
+        , tokens(tokens)
+        , columns(columns)
+    {
+
+    }
+
+    bool parse(QString *error)
+    {
+        int node = this->parseOr();
+
+        if (node >= 0 && this->current().type != FilterToken::End) {
+            this->fail("Expected and, or or end");
+        }
+
+        if (!this->errorStr.isEmpty()) {
+            *error = this->errorStr;
+            return false;
+        }
+
+        this->filter->root = node;
+        return true;
+    }
+
+private:
+    typedef RowFilter::Node Node;
+
+    const FilterToken &current() const
+    {
+        return this->tokens.at(this->pos);
+    }
+
+    bool isKeyword(const char *keyword) const
+    {
+        return this->current().type == FilterToken::Word && this->current().text.compare(keyword, Qt::CaseInsensitive) == 0;
+    }
+
+    bool isSymbol(const char *symbol) const
+    {
+        return this->current().type == FilterToken::Symbol && this->current().text == symbol;
+    }
+
+    int fail(const QString &message)
+    {
+        if (this->errorStr.isEmpty()) {
+            this->errorStr = this->current().type == FilterToken::End
+                    ? QString("%1 at end").arg(message)
+                    : QString("%1 at %2").arg(message).arg(this->current().position + 1);
+        }
+        return -1;
+    }
+
+    int addNode(const Node &node)
+    {
+        this->filter->nodes.append(node);
+        return this->filter->nodes.size() - 1;
+    }
+
+    int addBinary(Node::Type type, int left, int right)
+    {
+        Node node;
+        node.type = type;
+        node.left = left;
+        node.right = right;
+        return this->addNode(node);
+    }
+
+    int addNot(int operand)
+    {
+        Node node;
+        node.type = Node::Not;
+        node.left = operand;
+        return this->addNode(node);
+    }
+
+    int parseOr()
+    {
+        int left = this->parseAnd();
+
+        while (left >= 0 && this->isKeyword("or")) {
+            this->pos++;
+            int right = this->parseAnd();
+            if (right < 0) {
+                return -1;
+            }
+            left = this->addBinary(Node::Or, left, right);
+        }
+
+        return left;
+    }
+
+    int parseAnd()
+    {
+        int left = this->parseFactor();
+
+        while (left >= 0 && this->isKeyword("and")) {
+            this->pos++;
+            int right = this->parseFactor();
+            if (right < 0) {
+                return -1;
+            }
+            left = this->addBinary(Node::And, left, right);
+        }
+
+        return left;
+    }
+
+    int parseFactor()
+    {
+        if (this->isKeyword("not")) {
+            this->pos++;
+            int operand = this->parseFactor();
+            return operand < 0 ? -1 : this->addNot(operand);
+        }
+
+        if (this->isSymbol("(")) {
+            this->pos++;
+            int node = this->parseOr();
+            if (node < 0) {
+                return -1;
+            }
+            if (!this->isSymbol(")")) {
+                return this->fail("Expected )");
+            }
+            this->pos++;
+            return node;
+        }
+
+        if (this->isKeyword("len")) {
+            return this->parseLength();
+        }
+
+        return this->parseCondition();
+    }
+
+    int parseColumn()
+    {
+        if (this->current().type != FilterToken::Word && this->current().type != FilterToken::String) {
+            return this->fail("Expected column");
+        }
+
+        int column = this->columns.indexOf(this->current().text);
+        if (column < 0) {
+            return this->fail(QString("Unknown column \"%1\"").arg(this->current().text));
+        }
+
+        this->pos++;
+        return column;
+    }
+
+    bool parseText(QString *text)
+    {
+        if (this->current().type != FilterToken::Word && this->current().type != FilterToken::String) {
+            this->fail("Expected text");
+            return false;
+        }
+
+        *text = this->current().text;
+        this->pos++;
+        return true;
+    }
+
+    int parseLength()
+    {
+        this->pos++;
+
+        if (!this->isSymbol("(")) {
+            return this->fail("Expected (");
+        }
+        this->pos++;
+
+        Node node;
+        node.type = Node::Length;
+        node.column = this->parseColumn();
+        if (node.column < 0) {
+            return -1;
+        }
+
+        if (!this->isSymbol(")")) {
+            return this->fail("Expected )");
+        }
+        this->pos++;
+
+        static const char *symbols[] = {"<", "<=", ">", ">=", "=", "!="};
+        bool isCompare = false;
+        for (int i = 0; i < 6 && !isCompare; i++) {
+            if (this->isSymbol(symbols[i])) {
+                node.compare = Node::Compare(i);
+                isCompare = true;
+            }
+        }
+        if (!isCompare) {
+            return this->fail("Expected comparison");
+        }
+        this->pos++;
+
+        bool isNumber = false;
+        node.number = this->current().type == FilterToken::Word ? this->current().text.toInt(&isNumber) : 0;
+        if (!isNumber || node.number < 0) {
+            return this->fail("Expected length");
+        }
+        this->pos++;
+
+        return this->addNode(node);
+    }
+
+    int parseCondition()
+    {
+        Node node;
+        node.column = this->parseColumn();
+        if (node.column < 0) {
+            return -1;
+        }
+
+        if (this->isKeyword("is")) {
+            this->pos++;
+            bool isNegated = false;
+            if (this->isKeyword("not")) {
+                isNegated = true;
+                this->pos++;
+            }
+            if (!this->isKeyword("empty")) {
+                return this->fail("Expected empty");
+            }
+            this->pos++;
+
+            node.type = Node::Empty;
+            int empty = this->addNode(node);
+            return isNegated ? this->addNot(empty) : empty;
+        }
+
+        if (this->isKeyword("contains")) {
+            this->pos++;
+            node.type = Node::Contains;
+            return this->parseText(&node.text) ? this->addNode(node) : -1;
+        }
+
+        if (this->isKeyword("matches") || this->isSymbol("~")) {
+            int position = this->current().position;
+            this->pos++;
+            node.type = Node::Matches;
+            if (!this->parseText(&node.text)) {
+                return -1;
+            }
+
+            node.regex.setPattern(node.text);
+            if (!node.regex.isValid()) {
+                this->errorStr = QString("Invalid regular expression at %1: %2").arg(position + 1).arg(node.regex.errorString());
+                return -1;
+            }
+            node.regex.optimize();
+            return this->addNode(node);
+        }
+
+        if (this->isSymbol("=") || this->isSymbol("!=")) {
+            bool isNegated = this->isSymbol("!=");
+            this->pos++;
+            node.type = Node::Equals;
+            if (!this->parseText(&node.text)) {
+                return -1;
+            }
+            int equals = this->addNode(node);
+            return isNegated ? this->addNot(equals) : equals;
+        }
+
+        return this->fail("Expected contains, matches, ~, =, != or is");
+    }
+
+    RowFilter *filter;
+    const QVector<FilterToken> &tokens;
+    const QStringList &columns;
+    int pos = 0;
+    QString errorStr;
+};
+
+RowFilter::RowFilter()
+{
+
+}
+
+bool RowFilter::parse(const QString &text, const QStringList &columns, QString *error)
+{
+    *this = RowFilter();
+
+    QVector<FilterToken> tokens;
+    if (!tokenize(text, &tokens, error)) {
+        return false;
+    }
+
+    // Blank text is the empty filter, every row matches
+    if (tokens.size() == 1) {
+        return true;
+    }
+
+    RowFilterParser parser(this, tokens, columns);
+    if (!parser.parse(error)) {
+        *this = RowFilter();
+        return false;
+    }
+
+    this->queryText = text.trimmed();
+
+    return true;
+}
+
+bool RowFilter::isEmpty() const
+{
+    return this->root < 0;
+}
+
+QString RowFilter::text() const
+{
+    return this->queryText;
+}
+
+bool RowFilter::matches(const QStringList &values) const
+{
+    return this->root < 0 || this->matchNode(this->root, values);
+}
+
+bool RowFilter::matchNode(int index, const QStringList &values) const
+{
+    const Node &node = this->nodes.at(index);
+
+    switch (node.type) {
+    case Node::And:
+        return this->matchNode(node.left, values) && this->matchNode(node.right, values);
+    case Node::Or:
+        return this->matchNode(node.left, values) || this->matchNode(node.right, values);
+    case Node::Not:
+        return !this->matchNode(node.left, values);
+    default:
+        break;
+    }
+
+    // Rows without the key have an empty value
+    QString value = values.value(node.column);
+
+    switch (node.type) {
+    case Node::Contains:
+        return value.contains(node.text, Qt::CaseInsensitive);
+    case Node::Matches:
+        return node.regex.match(value).hasMatch();
+    case Node::Equals:
+        return value == node.text;
+    case Node::Empty:
+        return value.trimmed().isEmpty();
+    case Node::Length:
+        switch (node.compare) {
+        case Node::Less:
+            return value.size() < node.number;
+        case Node::LessEqual:
+            return value.size() <= node.number;
+        case Node::Greater:
+            return value.size() > node.number;
+        case Node::GreaterEqual:
+            return value.size() >= node.number;
+        case Node::Equal:
+            return value.size() == node.number;
+        case Node::NotEqual:
+            return value.size() != node.number;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+RowFilter::Bits RowFilter::evaluate(const JsonLinesModel::Snapshot &snapshot, int first, int count) const
+{
+    TraceSpan span("filter rows");
+
+    Bits bits((count + 63) / 64, 0);
+    QVector<int> chunks;
+
+    for (int offset = 0; offset < count; offset += chunkRows) {
+        chunks.append(offset);
+    }
+
+    quint64 *words = bits.data();
+
+    QtConcurrent::blockingMap(chunks, [this, &snapshot, words, first, count](int offset) {
+        int last = qMin(offset + chunkRows, count);
+        for (int i = offset; i < last; i++) {
+            if (this->matches(snapshot.rowValues(first + i))) {
+                words[i / 64] |= quint64(1) << (i % 64);
+            }
+        }
+    });
+
+    return bits;
+}
+
+bool RowFilter::testBit(const Bits &bits, int row)
+{
+    return row >= 0 && row / 64 < bits.size() && (bits.at(row / 64) >> (row % 64)) & 1;
+}
+
+void RowFilter::setBit(Bits &bits, int row, bool isSet)
+{
+    if (row / 64 >= bits.size()) {
+        bits.resize(row / 64 + 1);
+    }
+
+    if (isSet) {
+        bits[row / 64] |= quint64(1) << (row % 64);
+    } else {
+        bits[row / 64] &= ~(quint64(1) << (row % 64));
+    }
+}
+
+int RowFilter::countBits(const Bits &bits)
+{
+    int count = 0;
+    for (quint64 word : bits) {
+        count += qPopulationCount(word);
+    }
+    return count;
+}
+
+// 64 bits of bits from bit pos on, zero past the end
+static quint64 readWord(const RowFilter::Bits &bits, qint64 pos)
+{
+    int word = int(pos / 64);
+    int shift = int(pos % 64);
+
+    quint64 value = word < bits.size() ? bits.at(word) >> shift : 0;
+    if (shift > 0 && word + 1 < bits.size()) {
+        value |= bits.at(word + 1) << (64 - shift);
+    }
+
+    return value;
+}
+
+// Appends the low count bits of value, count at most 64
+static void appendBits(RowFilter::Bits &bits, qint64 &bitCount, quint64 value, int count)
+{
+    if (count < 64) {
+        value &= (quint64(1) << count) - 1;
+    }
+
+    int shift = int(bitCount % 64);
+    if (shift == 0) {
+        bits.append(value);
+    } else {
+        bits.last() |= value << shift;
+        if (shift + count > 64) {
+            bits.append(value >> (64 - shift));
+        }
+    }
+
+    bitCount += count;
+}
+
+// Appends count bits of source from bit pos on, a word at a time
+static void appendRange(RowFilter::Bits &bits, qint64 &bitCount, const RowFilter::Bits &source, qint64 pos, qint64 count)
+{
+    while (count > 0) {
+        int part = int(qMin<qint64>(count, 64));
+        appendBits(bits, bitCount, readWord(source, pos), part);
+        pos += part;
+        count -= part;
+    }
+}
+
+RowFilter::Bits RowFilter::removeBits(const Bits &bits, int bitCount, const QVector<int> &rows)
+{
+    Bits result;
+    result.reserve((bitCount + 63) / 64);
+    qint64 resultCount = 0;
+    int next = 0;
+
+    for (int row : rows) {
+        if (row < next || row >= bitCount) {
+            continue;
+        }
+        appendRange(result, resultCount, bits, next, row - next);
+        next = row + 1;
+    }
+    appendRange(result, resultCount, bits, next, bitCount - next);
+
+    return result;
+}
+
+RowFilter::Bits RowFilter::insertBits(const Bits &bits, int bitCount, const QVector<int> &rows, const Bits &inserted)
+{
+    Bits result;
+    result.reserve((bitCount + rows.size() + 63) / 64);
+    qint64 resultCount = 0;
+    int next = 0;
+
+    for (int i = 0; i < rows.size(); i++) {
+        int count = qBound(0, int(rows.at(i) - resultCount), bitCount - next);
+        appendRange(result, resultCount, bits, next, count);
+        next += count;
+        appendBits(result, resultCount, testBit(inserted, i) ? 1 : 0, 1);
+    }
+    appendRange(result, resultCount, bits, next, bitCount - next);
+
+    return result;
+}
@@ -0,0 +1,93 @@
+#ifndef ROWFILTER_H
+#define ROWFILTER_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "jsonlinesmodel.h"
+
+// Row condition over the columns, parsed from a small query language:
+//
+//   definition is empty or len(definition) < 40
+//   source ~ /wiki/ and not (term contains "draft")
+//
+// Conditions are "column contains text" (case insensitive), "column ~ text"
+// or "column matches text" (regular expression), "column = text",
+// "column != text", "column is [not] empty" and "len(column) op number"
+// with op one of < <= > >= = !=. They combine with and, or, not and
+// parentheses. Columns are the keys of the file, text is a word, a "quoted
+// string" or a /regular expression/. evaluate() checks rows on the global
+// thread pool into a bitset, one bit per row.
+class RowFilter
+{
+public:
+    // Bit per row, row i is bit i % 64 of word i / 64
+    typedef QVector<quint64> Bits;
+
+    static const int chunkRows = 16384;     // multiple of 64, chunks own their words
+
+    RowFilter();
+
+    // columns are the keys of the model, in column order
+    bool parse(const QString &text, const QStringList &columns, QString *error);
+    bool isEmpty() const;
+    QString text() const;
+
+    bool matches(const QStringList &values) const;
+
+    // Bits of rows [first, first + count) of the snapshot, bit 0 for first
+    Bits evaluate(const JsonLinesModel::Snapshot &snapshot, int first, int count) const;
+
+    static bool testBit(const Bits &bits, int row);
+    static void setBit(Bits &bits, int row, bool isSet);
+    static int countBits(const Bits &bits);
+    // Bits of bitCount rows without the given rows, rows ascending
+    static Bits removeBits(const Bits &bits, int bitCount, const QVector<int> &rows);
+    // Bits of bitCount rows with inserted rows at the given row numbers,
+    // ascending as after the insertion, bit i of inserted for rows[i]
+    static Bits insertBits(const Bits &bits, int bitCount, const QVector<int> &rows, const Bits &inserted);
+
+private:
+    struct Node {
+        enum Type {
+            And = 0,
+            Or,
+            Not,
+            Contains,
+            Matches,
+            Equals,
+            Empty,
+            Length
+        };
+
+        enum Compare {
+            Less = 0,
+            LessEqual,
+            Greater,
+            GreaterEqual,
+            Equal,
+            NotEqual
+        };
+
+        Type type = And;
+        int left = -1;                  // And, Or, Not
+        int right = -1;                 // And, Or
+        int column = -1;
+        QString text;
+        QRegularExpression regex;
+        Compare compare = Equal;
+        int number = 0;
+    };
+
+    friend class RowFilterParser;
+
+    bool matchNode(int node, const QStringList &values) const;
+
+    QString queryText;
+    QVector<Node> nodes;
+    int root = -1;
+};
+
+#endif // ROWFILTER_H
@@ -0,0 +1,118 @@
+#include "rowsorter.h"
+#include "tracer.h"
+
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <QPair>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+typedef QPair<int, int> RowRange;       // [first, second)
+
+QVector<int> RowSorter::sortRows(const JsonLinesModel::Snapshot &snapshot, const QVector<SortColumn> &columns,
+                                 const QLocale &locale)
+{
+    TraceSpan span("sort rows");
+
+    int rowCount = snapshot.rowCount();
+    int columnCount = columns.size();
+
+    QVector<int> rows(rowCount);
+    std::iota(rows.begin(), rows.end(), 0);
+
+    if (rowCount < 2 || columnCount == 0) {
+        return rows;
+    }
+
+    // Keys of every chunk, row by row, QCollatorSortKey cannot be default
+    // constructed to fill a preallocated vector
+    QVector<int> chunks;
+    for (int first = 0; first < rowCount; first += chunkRows) {
+        chunks.append(first);
+    }
+    std::vector<std::vector<QCollatorSortKey>> keys(size_t(chunks.size()));
+
+    {
+        TraceSpan keySpan("sort keys");
+
+        QtConcurrent::blockingMap(chunks, [&snapshot, &columns, &keys, &locale, rowCount, columnCount](int first) {
+            // QCollator is not shared between threads
+            QCollator collator(locale);
+            collator.setNumericMode(true);
+
+            int last = qMin(first + chunkRows, rowCount);
+            std::vector<QCollatorSortKey> &chunkKeys = keys[size_t(first / chunkRows)];
+            chunkKeys.reserve(size_t(last - first) * size_t(columnCount));
+
+            for (int row = first; row < last; row++) {
+                QStringList values = snapshot.rowValues(row);
+                for (const SortColumn &column : columns) {
+                    chunkKeys.push_back(collator.sortKey(values.value(column.column)));
+                }
+            }
+        });
+    }
+
+    auto isLess = [&keys, &columns, columnCount](int left, int right) {
+        const QCollatorSortKey *leftKeys = &keys[size_t(left / chunkRows)][size_t(left % chunkRows) * size_t(columnCount)];
+        const QCollatorSortKey *rightKeys = &keys[size_t(right / chunkRows)][size_t(right % chunkRows) * size_t(columnCount)];
+
+        for (int i = 0; i < columnCount; i++) {
+            int result = leftKeys[i].compare(rightKeys[i]);
+            if (result != 0) {
+                return columns.at(i).order == Qt::AscendingOrder ? result < 0 : result > 0;
+            }
+        }
+        return false;
+    };
+
+    // Ranges sorted in parallel, then merged in pairs until one is left.
+    // std::merge takes equal rows from the first range first, the sort
+    // stays stable.
+    int rangeCount = qMax(1, qMin(QThread::idealThreadCount() * 2, rowCount / chunkRows));
+    QVector<RowRange> ranges;
+    for (int i = 0; i < rangeCount; i++) {
+        ranges.append(RowRange(int(qint64(rowCount) * i / rangeCount), int(qint64(rowCount) * (i + 1) / rangeCount)));
+    }
+
+    int *source = rows.data();
+
+    QtConcurrent::blockingMap(ranges, [source, &isLess](const RowRange &range) {
+        std::stable_sort(source + range.first, source + range.second, isLess);
+    });
+
+    QVector<int> buffer(rowCount);
+    int *target = buffer.data();
+
+    while (ranges.size() > 1) {
+        TraceSpan mergeSpan("sort merge");
+
+        QVector<int> pairs;
+        QVector<RowRange> merged;
+        for (int i = 0; i < ranges.size(); i += 2) {
+            pairs.append(i);
+            merged.append(RowRange(ranges.at(i).first, i + 1 < ranges.size() ? ranges.at(i + 1).second : ranges.at(i).second));
+        }
+
+        QtConcurrent::blockingMap(pairs, [source, target, &ranges, &isLess](int i) {
+            const RowRange &left = ranges.at(i);
+            if (i + 1 < ranges.size()) {
+                const RowRange &right = ranges.at(i + 1);
+                std::merge(source + left.first, source + left.second, source + right.first, source + right.second,
+                           target + left.first, isLess);
+            } else {
+                std::copy(source + left.first, source + left.second, target + left.first);
+            }
+        });
+
+        std::swap(source, target);
+        ranges = merged;
+    }
+
+    // Odd number of merge rounds leaves the result in the buffer
+    return source == rows.data() ? rows : buffer;
+}
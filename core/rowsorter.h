@@ -0,0 +1,29 @@
+#ifndef ROWSORTER_H
+#define ROWSORTER_H
+
+#include <QLocale>
+#include <QVector>
+
+#include "jsonlinesmodel.h"
+
+// Row order by one or more columns. Collation keys (QCollator::sortKey())
+// of the sorted columns are computed once per row on the global thread
+// pool, comparisons then compare the keys only. Row numbers are sorted by
+// a parallel stable sort: chunks are sorted in parallel, then merged in
+// pairs, in parallel too, so rows with equal keys keep the model order.
+class RowSorter
+{
+public:
+    struct SortColumn {
+        int column = 0;
+        Qt::SortOrder order = Qt::AscendingOrder;
+    };
+
+    static const int chunkRows = 16384;
+
+    // Model rows in sorted order
+    static QVector<int> sortRows(const JsonLinesModel::Snapshot &snapshot, const QVector<SortColumn> &columns,
+                                 const QLocale &locale = QLocale());
+};
+
+#endif // ROWSORTER_H
@@ -0,0 +1,415 @@
+#include "rowvalidator.h"
+#include "tracer.h"
+
+#include <QDateTime>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <climits>
+
+static const int maxStoredLength = 65535;
+
+// Bits of Check for one field, the column decides whether line breaks are allowed
+static quint32 fieldChecks(const QString &value, int column)
+{
+    const QChar *chars = value.constData();
+    int size = value.size();
+
+    int first = 0;
+    while (first < size && chars[first].isSpace()) {
+        first++;
+    }
+    if (first == size) {
+        return 1u << RowValidator::EmptyField;
+    }
+
+    bool isMultiLine = column == JsonLinesModel::ColumnDefinition || column == JsonLinesModel::ColumnDefinitionOrig;
+    quint32 checks = 0;
+
+    if (first > 0 || chars[size - 1].isSpace()) {
+        checks |= 1u << RowValidator::Whitespace;
+    }
+
+    for (int i = 0; i < size; i++) {
+        ushort c = chars[i].unicode();
+
+        if (c == '\n') {
+            if (!isMultiLine) {
+                checks |= 1u << RowValidator::Whitespace;
+            }
+        } else if (c == '\t') {
+            checks |= 1u << RowValidator::Whitespace;
+        } else if (c < 0x20 || (c >= 0x7f && c < 0xa0)) {
+            checks |= 1u << RowValidator::ControlCharacter;
+        } else if (c == ' ') {
+            if (i > 0 && chars[i - 1] == ' ') {
+                checks |= 1u << RowValidator::Whitespace;
+            }
+        } else if (c == 0xfffd) {
+            checks |= 1u << RowValidator::InvalidText;
+        } else if (QChar::isHighSurrogate(c)) {
+            if (i + 1 < size && chars[i + 1].isLowSurrogate()) {
+                i++;
+            } else {
+                checks |= 1u << RowValidator::InvalidText;
+            }
+        } else if (QChar::isLowSurrogate(c)) {
+            checks |= 1u << RowValidator::InvalidText;
+        }
+    }
+
+    return checks;
+}
+
+// Smallest length with at least fraction of the counted values at or below it
+static int quantile(const int *histogram, qint64 total, double fraction)
+{
+    qint64 target = qMax(qint64(1), qint64(total * fraction + 0.5));
+    qint64 count = 0;
+
+    for (int length = 0; length < RowValidator::histogramSize; length++) {
+        count += histogram[length];
+        if (count >= target) {
+            return length;
+        }
+    }
+
+    return RowValidator::histogramSize - 1;
+}
+
+RowValidator::RowValidator(QObject *parent)
+    : QObject(parent)
+{
+    connect(&this->watcher, &QFutureWatcher<Result>::finished, this, &RowValidator::validationFinished);
+}
+
+quint32 RowValidator::issueBit(Check check, int column)
+{
+    // Field checks have a bit per column, row checks one after them
+    int index = check < EmptyRow ? check * JsonLinesModel::ColumnCount + column
+                                 : EmptyRow * JsonLinesModel::ColumnCount + check - EmptyRow;
+    return quint32(1) << index;
+}
+
+QVector<RowValidator::Issue> RowValidator::issues(quint32 bits)
+{
+    QVector<Issue> issues;
+
+    for (int check = 0; check < CheckCount; check++) {
+        if (check < EmptyRow) {
+            for (int column = 0; column < JsonLinesModel::ColumnCount; column++) {
+                if (bits & issueBit(Check(check), column)) {
+                    issues.append({Check(check), column});
+                }
+            }
+        } else if (bits & issueBit(Check(check), -1)) {
+            issues.append({Check(check), -1});
+        }
+    }
+
+    return issues;
+}
+
+QString RowValidator::checkName(Check check)
+{
+    switch (check) {
+    case EmptyField:
+        return "Empty field";
+    case Whitespace:
+        return "Whitespace";
+    case ControlCharacter:
+        return "Control character";
+    case InvalidText:
+        return "Broken text";
+    case LengthOutlier:
+        return "Unusual length";
+    case EmptyRow:
+        return "Empty row";
+    case SameTerms:
+        return "Term equals original";
+    case ParseError:
+        return "Cannot parse";
+    case CheckCount:
+        break;
+    }
+    return "";
+}
+
+quint32 RowValidator::checkValues(const QStringList &values, const Limits &limits)
+{
+    quint32 bits = 0;
+    bool isEmpty = true;
+
+    for (int column = 0; column < JsonLinesModel::ColumnCount; column++) {
+        QString value = values.value(column);
+        quint32 checks = fieldChecks(value, column);
+
+        if (checks == (1u << EmptyField)) {
+            bits |= issueBit(EmptyField, column);
+            continue;
+        }
+        isEmpty = false;
+
+        for (int check = Whitespace; check < LengthOutlier; check++) {
+            if (checks & (1u << check)) {
+                bits |= issueBit(Check(check), column);
+            }
+        }
+
+        if (column < limits.minLength.size() &&
+                (value.size() < limits.minLength.at(column) || value.size() > limits.maxLength.at(column))) {
+            bits |= issueBit(LengthOutlier, column);
+        }
+    }
+
+    // A blank row is one issue, not one per field
+    if (isEmpty) {
+        return issueBit(EmptyRow, -1);
+    }
+
+    QString term = values.value(JsonLinesModel::ColumnTerm);
+    if (!term.trimmed().isEmpty() && term == values.value(JsonLinesModel::ColumnTermOrig)) {
+        bits |= issueBit(SameTerms, -1);
+    }
+
+    return bits;
+}
+
+RowValidator::Result RowValidator::validateRows(const JsonLinesModel::Snapshot &snapshot)
+{
+    TraceSpan span("validate rows");
+
+    const int columnCount = JsonLinesModel::ColumnCount;
+    int rowCount = snapshot.rowCount();
+
+    QVector<int> chunks;
+    for (int first = 0; first < rowCount; first += chunkRows) {
+        chunks.append(first);
+    }
+
+    // Issues and field lengths of every row, length counts of every chunk
+    QVector<quint32> bits(rowCount);
+    QVector<quint16> lengths(qsizetype(rowCount) * columnCount);
+    QVector<QVector<int>> histograms(chunks.size());
+    quint32 *rowBits = bits.data();
+    quint16 *rowLengths = lengths.data();
+
+    QtConcurrent::blockingMap(chunks, [&snapshot, &histograms, rowBits, rowLengths, rowCount](int first) {
+        int last = qMin(first + chunkRows, rowCount);
+        QVector<int> histogram(columnCount * histogramSize, 0);
+        Limits noLimits;
+
+        for (int row = first; row < last; row++) {
+            // Raw text is not checked as fields, its lengths stay zero
+            if (snapshot.isRawRow(row)) {
+                rowBits[row] = issueBit(ParseError, -1);
+                continue;
+            }
+
+            QStringList values = snapshot.rowValues(row);
+            rowBits[row] = checkValues(values, noLimits);
+
+            for (int column = 0; column < columnCount; column++) {
+                // Blank fields are not counted and never outliers
+                int length = (rowBits[row] & (issueBit(EmptyField, column) | issueBit(EmptyRow, -1))) ? 0 : values.value(column).size();
+                rowLengths[qsizetype(row) * columnCount + column] = quint16(qMin(length, maxStoredLength));
+                if (length > 0) {
+                    histogram[column * histogramSize + qMin(length, histogramSize - 1)]++;
+                }
+            }
+        }
+
+        histograms[first / chunkRows] = histogram;
+    });
+
+    Result result;
+
+    for (int column = 0; column < columnCount; column++) {
+        QVector<int> histogram(histogramSize, 0);
+        qint64 total = 0;
+
+        for (const QVector<int> &chunkHistogram : histograms) {
+            for (int length = 0; length < histogramSize; length++) {
+                histogram[length] += chunkHistogram.at(column * histogramSize + length);
+                total += chunkHistogram.at(column * histogramSize + length);
+            }
+        }
+
+        int minLength = 0;
+        int maxLength = INT_MAX;
+
+        if (total >= minOutlierRows) {
+            int lower = quantile(histogram.constData(), total, 0.25);
+            int upper = quantile(histogram.constData(), total, 0.75);
+            // Columns of nearly equal lengths still get room
+            int range = qMax(upper - lower, upper / 2 + 1);
+
+            minLength = lower - 3 * range;
+            // Quartile in the last bucket, longer lengths are not known
+            maxLength = upper < histogramSize - 1 ? upper + 3 * range : INT_MAX;
+        }
+
+        result.limits.minLength.append(minLength);
+        result.limits.maxLength.append(maxLength);
+    }
+
+    const Limits &limits = result.limits;
+
+    QtConcurrent::blockingMap(chunks, [&limits, rowBits, rowLengths, rowCount](int first) {
+        int last = qMin(first + chunkRows, rowCount);
+
+        for (int row = first; row < last; row++) {
+            for (int column = 0; column < columnCount; column++) {
+                int length = rowLengths[qsizetype(row) * columnCount + column];
+                if (length > 0 && (length < limits.minLength.at(column) || length > limits.maxLength.at(column))) {
+                    rowBits[row] |= issueBit(LengthOutlier, column);
+                }
+            }
+        }
+    });
+
+    for (int row = 0; row < rowCount; row++) {
+        if (bits.at(row) != 0) {
+            result.entries.append({snapshot.rowKey(row), bits.at(row)});
+        }
+    }
+
+    std::sort(result.entries.begin(), result.entries.end());
+
+    return result;
+}
+
+void RowValidator::start(const JsonLinesModel::Snapshot &snapshot)
+{
+    this->clear();
+
+    this->startedMs = QDateTime::currentMSecsSinceEpoch();
+
+    this->watcher.setFuture(QtConcurrent::run([snapshot]() {
+        return validateRows(snapshot);
+    }));
+}
+
+void RowValidator::clear()
+{
+    // Result of a running pass is dropped: empty future is canceled
+    this->watcher.setFuture(QFuture<Result>());
+
+    this->currentEntries.clear();
+    this->limits = Limits();
+    this->pendingUpdates.clear();
+    this->isComputed = false;
+}
+
+bool RowValidator::isRunning() const
+{
+    return this->watcher.isRunning();
+}
+
+bool RowValidator::hasResult() const
+{
+    return this->isComputed;
+}
+
+void RowValidator::validationFinished()
+{
+    if (this->watcher.future().isCanceled() || this->watcher.future().resultCount() == 0) {
+        return;
+    }
+
+    Result result = this->watcher.result();
+    this->currentEntries = result.entries;
+    this->limits = result.limits;
+    this->isComputed = true;
+
+    // Edits made while validating, in order: undo can restore a removed
+    // row under its old key
+    QVector<PendingUpdate> updates = this->pendingUpdates;
+    this->pendingUpdates.clear();
+
+    for (const PendingUpdate &update : updates) {
+        if (!update.removedKeys.isEmpty()) {
+            this->removeKeys(update.removedKeys);
+        } else {
+            this->updateRow(update.oldKey, update.newKey, update.values, update.isRaw);
+        }
+    }
+
+    emit finished(QDateTime::currentMSecsSinceEpoch() - this->startedMs);
+}
+
+void RowValidator::removeEntry(qint64 key)
+{
+    Entry entry = {key, 0};
+    QVector<Entry>::iterator it = std::lower_bound(this->currentEntries.begin(), this->currentEntries.end(), entry);
+
+    if (it != this->currentEntries.end() && it->key == key) {
+        this->currentEntries.erase(it);
+    }
+}
+
+void RowValidator::updateRow(qint64 oldKey, qint64 newKey, const QStringList &values, bool isRaw)
+{
+    if (this->isRunning()) {
+        this->pendingUpdates.append({oldKey, newKey, values, isRaw, QVector<qint64>()});
+        return;
+    }
+
+    if (!this->isComputed) {
+        return;
+    }
+
+    this->removeEntry(oldKey);
+
+    Entry entry = {newKey, isRaw ? issueBit(ParseError, -1) : checkValues(values, this->limits)};
+    if (entry.issues != 0) {
+        this->removeEntry(newKey);
+        this->currentEntries.insert(std::lower_bound(this->currentEntries.begin(), this->currentEntries.end(), entry), entry);
+    }
+}
+
+void RowValidator::removeKeys(const QVector<qint64> &keys)
+{
+    if (this->isRunning()) {
+        if (!keys.isEmpty()) {
+            this->pendingUpdates.append({0, 0, QStringList(), false, keys});
+        }
+        return;
+    }
+
+    QSet<qint64> removed(keys.constBegin(), keys.constEnd());
+
+    this->currentEntries.erase(std::remove_if(this->currentEntries.begin(), this->currentEntries.end(), [&removed](const Entry &entry) {
+        return removed.contains(entry.key);
+    }), this->currentEntries.end());
+}
+
+QVector<RowValidator::Entry> RowValidator::entries() const
+{
+    return this->currentEntries;
+}
+
+int RowValidator::issueCount() const
+{
+    int count = 0;
+
+    for (const Entry &entry : this->currentEntries) {
+        count += qPopulationCount(entry.issues);
+    }
+
+    return count;
+}
+
+QVector<int> RowValidator::checkCounts() const
+{
+    QVector<int> counts(CheckCount, 0);
+
+    for (const Entry &entry : this->currentEntries) {
+        for (const Issue &issue : issues(entry.issues)) {
+            counts[issue.check]++;
+        }
+    }
+
+    return counts;
+}
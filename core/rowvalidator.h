@@ -0,0 +1,118 @@
+#ifndef ROWVALIDATOR_H
+#define ROWVALIDATOR_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include "jsonlinesmodel.h"
+
+// Checks every row for what makes a bad training example: blank fields,
+// stray whitespace, control characters, replacement characters and
+// unpaired surrogates left by a broken conversion, lengths far from the
+// usual ones of the column and a term identical to its original. Bytes
+// that are not UTF-8 fail to parse, those lines are raw rows. Rows are
+// checked on the thread pool in one pass that also counts the field
+// lengths, the length limits of every column (three interquartile ranges
+// off the quartiles) are applied to the counted lengths after. The issues
+// of a row are bits of one entry, entries are kept sorted by row key
+// (JsonLinesModel::rowKey()). Edits check the edited row only, against
+// the limits of the last pass. Raw rows of a tolerant load have the parse
+// error as their only issue.
+class RowValidator : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Check {
+        EmptyField = 0,
+        Whitespace,             // leading, trailing, repeated or a line break in a single line field
+        ControlCharacter,
+        InvalidText,            // replacement character, unpaired surrogate
+        LengthOutlier,
+        EmptyRow,               // every field blank, such a row is not saved
+        SameTerms,              // term identical to the original term
+        ParseError,             // raw row, the line is not a JSON object
+        CheckCount
+    };
+
+    struct Entry {
+        qint64 key;
+        quint32 issues;         // issueBit() of every issue
+
+        bool operator<(const Entry &other) const
+        {
+            return this->key < other.key;
+        }
+    };
+
+    struct Issue {
+        Check check = EmptyField;
+        int column = -1;        // -1 for the row checks
+    };
+
+    // Empty: no length checks
+    struct Limits {
+        QVector<int> minLength;
+        QVector<int> maxLength;
+    };
+
+    struct Result {
+        QVector<Entry> entries;
+        Limits limits;
+    };
+
+    static const int chunkRows = 16384;
+    static const int histogramSize = 4096;      // longer values share the last bucket
+    static const int minOutlierRows = 100;      // fewer values of a column give no limits
+
+    explicit RowValidator(QObject *parent = nullptr);
+
+    void start(const JsonLinesModel::Snapshot &snapshot);
+    void clear();
+    bool isRunning() const;
+    bool hasResult() const;
+
+    void updateRow(qint64 oldKey, qint64 newKey, const QStringList &values, bool isRaw = false);
+    void removeKeys(const QVector<qint64> &keys);
+
+    QVector<Entry> entries() const;
+    int issueCount() const;
+    // Issues of every check, indexed by Check
+    QVector<int> checkCounts() const;
+
+    static quint32 issueBit(Check check, int column);
+    static QVector<Issue> issues(quint32 bits);
+    static QString checkName(Check check);
+    static quint32 checkValues(const QStringList &values, const Limits &limits);
+    static Result validateRows(const JsonLinesModel::Snapshot &snapshot);
+
+signals:
+    void finished(qint64 elapsedMs);
+
+private slots:
+    void validationFinished();
+
+private:
+    // Row update, or removal of removedKeys when not empty
+    struct PendingUpdate {
+        qint64 oldKey;
+        qint64 newKey;
+        QStringList values;
+        bool isRaw;
+        QVector<qint64> removedKeys;
+    };
+
+    void removeEntry(qint64 key);
+
+    QVector<Entry> currentEntries;
+    Limits limits;
+    bool isComputed = false;
+
+    QFutureWatcher<Result> watcher;
+    qint64 startedMs = 0;
+    QVector<PendingUpdate> pendingUpdates;     // in the order made
+};
+
+#endif // ROWVALIDATOR_H
@@ -0,0 +1,434 @@
+#include "searchindex.h"
+#include "tracer.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QtConcurrent>
+
+static const char *builderConnection = "search_index_builder";
+
+// Below every row key, see JsonLinesModel::rowKey()
+static const qint64 remapKeyBase = -(qint64(1) << 62);
+
+SearchIndex::SearchIndex(const QString &databasePath, QObject *parent)
+    : QObject(parent)
+    , databasePath(databasePath)
+    , isCanceled(0)
+{
+
+}
+
+SearchIndex::~SearchIndex()
+{
+    this->stopBuilder();
+}
+
+QString SearchIndex::stamp(const QString &filePath)
+{
+    QFileInfo fileInfo(filePath);
+
+    if (!fileInfo.exists()) {
+        return "";
+    }
+
+    return QString("%1|%2|%3").arg(fileInfo.absoluteFilePath()).
+            arg(fileInfo.size()).
+            arg(fileInfo.lastModified().toMSecsSinceEpoch());
+}
+
+QString SearchIndex::matchQuery(const QString &text)
+{
+    QStringList terms;
+
+    for (QString word : text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts)) {
+        word.replace("\"", "\"\"");
+        terms.append(QString("\"%1\"*").arg(word));
+    }
+
+    return terms.join(" ");
+}
+
+bool SearchIndex::isBuilding() const
+{
+    return this->builderThread != nullptr;
+}
+
+bool SearchIndex::isReady() const
+{
+    return this->isIndexReady;
+}
+
+void SearchIndex::rebuild(const QString &stamp, const JsonLinesModel::Snapshot &snapshot)
+{
+    this->stopBuilder();
+    this->pendingUpdates.clear();
+    this->currentStamp = stamp;
+    this->isIndexReady = false;
+
+    if (!stamp.isEmpty()) {
+        QSqlQuery query(QSqlDatabase::database());
+        if (query.exec("SELECT value FROM _config WHERE _key = 'search_stamp' LIMIT 1") && query.first()
+                && query.value(0).toString() == stamp) {
+            this->builtStamp = stamp;
+            this->isIndexReady = true;
+            emit buildFinished(true, snapshot.rowCount(), 0);
+            return;
+        }
+    }
+
+    this->builtStamp = "";
+    this->isCanceled.storeRelaxed(0);
+    this->isBuilt = false;
+    this->buildError = "";
+
+    QString databasePath = this->databasePath;
+    QAtomicInt *isCanceled = &this->isCanceled;
+
+    this->builderThread = QThread::create([this, databasePath, stamp, snapshot, isCanceled]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        QString error;
+        bool isBuilt = build(databasePath, stamp, snapshot, isCanceled, &error);
+        QSqlDatabase::removeDatabase(builderConnection);
+
+        // Read on the owner thread after QThread::finished
+        this->isBuilt = isBuilt;
+        this->builtRows = snapshot.rowCount();
+        this->buildMs = timer.elapsed();
+        this->buildError = error;
+    });
+
+    int buildId = this->buildId;
+    connect(this->builderThread, &QThread::finished, this, [this, buildId]() {
+        // Finished signal of a stopped builder may arrive after a new start
+        if (buildId == this->buildId) {
+            this->builderFinished();
+        }
+    });
+    this->builderThread->start();
+}
+
+// Runs on the builder thread with a connection of its own
+bool SearchIndex::build(const QString &databasePath, const QString &stamp, const JsonLinesModel::Snapshot &snapshot,
+                        QAtomicInt *isCanceled, QString *error)
+{
+    TraceSpan span("search build");
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", builderConnection);
+    db.setDatabaseName(databasePath);
+
+    if (!db.open()) {
+        *error = db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery query(db);
+
+    // Readers on the main connection are not blocked by the build
+    query.exec("PRAGMA journal_mode=WAL");
+
+    if (!query.exec("DELETE FROM _config WHERE _key = 'search_stamp'")
+            || !query.exec("DROP TABLE IF EXISTS _search")
+            || !query.exec("CREATE VIRTUAL TABLE _search USING fts5(term, original_term, definition, original_definition, source, tokenize = 'unicode61 remove_diacritics 2')")) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    db.transaction();
+    query.prepare("INSERT INTO _search(rowid, term, original_term, definition, original_definition, source) VALUES (?, ?, ?, ?, ?, ?)");
+
+    QVector<int> batch;
+    batch.reserve(batchSize);
+
+    for (int first = 0; first < snapshot.rowCount(); first += batchSize) {
+        if (isCanceled->loadRelaxed()) {
+            db.rollback();
+            return false;
+        }
+
+        batch.resize(0);
+        for (int row = first; row < qMin(first + batchSize, snapshot.rowCount()); row++) {
+            batch.append(row);
+        }
+
+        // Decoding is the slow part and runs on the thread pool, inserts
+        // stay on this connection
+        QList<QStringList> values = QtConcurrent::blockingMapped(batch, [&snapshot](int row) {
+            return snapshot.rowValues(row);
+        });
+
+        for (int i = 0; i < batch.size(); i++) {
+            query.bindValue(0, snapshot.rowKey(batch.at(i)));
+            for (int column = 0; column < JsonLinesModel::ColumnCount; column++) {
+                query.bindValue(column + 1, values.at(i).value(column));
+            }
+
+            if (!query.exec()) {
+                *error = query.lastError().text();
+                db.rollback();
+                return false;
+            }
+        }
+    }
+
+    if (!db.commit()) {
+        *error = db.lastError().text();
+        return false;
+    }
+
+    if (!stamp.isEmpty()) {
+        query.prepare("INSERT INTO _config(_key, value) VALUES('search_stamp', :stamp) ON CONFLICT(_key) DO UPDATE SET value = :stamp WHERE _key = 'search_stamp'");
+        query.bindValue(":stamp", stamp);
+        query.exec();
+    }
+
+    return true;
+}
+
+void SearchIndex::builderFinished()
+{
+    if (!this->builderThread) {
+        return;
+    }
+
+    delete this->builderThread;
+    this->builderThread = nullptr;
+
+    QVector<PendingUpdate> updates = this->pendingUpdates;
+    this->pendingUpdates.clear();
+
+    // The table may be partly built, the next build reads the rows as
+    // they are then
+    if (this->isBuilt) {
+        this->builtStamp = this->currentStamp;
+        this->isIndexReady = true;
+
+        for (const PendingUpdate &update : updates) {
+            this->applyUpdate(update);
+        }
+    }
+
+    emit buildFinished(this->isBuilt, this->builtRows, this->buildMs);
+}
+
+QString SearchIndex::errorString() const
+{
+    return this->buildError;
+}
+
+void SearchIndex::cancel()
+{
+    this->stopBuilder();
+    this->pendingUpdates.clear();
+    this->isIndexReady = false;
+}
+
+void SearchIndex::stopBuilder()
+{
+    if (!this->builderThread) {
+        return;
+    }
+
+    this->isCanceled.storeRelaxed(1);
+    this->builderThread->wait();
+
+    delete this->builderThread;
+    this->builderThread = nullptr;
+    this->buildId++;
+}
+
+void SearchIndex::updateRow(qint64 oldKey, qint64 newKey, const QStringList &values)
+{
+    PendingUpdate update = {oldKey, newKey, values};
+
+    if (this->isBuilding()) {
+        this->pendingUpdates.append(update);
+        return;
+    }
+
+    if (this->isIndexReady) {
+        this->applyUpdate(update);
+    }
+}
+
+void SearchIndex::removeRow(qint64 key)
+{
+    this->updateRow(key, key, QStringList());
+}
+
+void SearchIndex::removeRows(const QVector<qint64> &keys)
+{
+    if (this->isBuilding()) {
+        for (qint64 key : keys) {
+            this->pendingUpdates.append({key, key, QStringList()});
+        }
+        return;
+    }
+
+    if (!this->isIndexReady) {
+        return;
+    }
+
+    // One transaction instead of a commit per row
+    QSqlDatabase db = QSqlDatabase::database();
+    db.transaction();
+    for (qint64 key : keys) {
+        this->applyUpdate({key, key, QStringList()});
+    }
+    db.commit();
+}
+
+void SearchIndex::addRows(const QVector<qint64> &keys, const QVector<QStringList> &values)
+{
+    if (this->isBuilding()) {
+        for (int i = 0; i < keys.size(); i++) {
+            this->pendingUpdates.append({keys.at(i), keys.at(i), values.at(i)});
+        }
+        return;
+    }
+
+    if (!this->isIndexReady) {
+        return;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database();
+    db.transaction();
+    for (int i = 0; i < keys.size(); i++) {
+        this->applyUpdate({keys.at(i), keys.at(i), values.at(i)});
+    }
+    db.commit();
+}
+
+bool SearchIndex::remapKeys(const QString &stamp, const QVector<QPair<qint64, qint64>> &keyChanges)
+{
+    if (this->isBuilding() || !this->isIndexReady || keyChanges.size() > maxRemapKeys) {
+        return false;
+    }
+
+    TraceSpan span("search remap");
+
+    QSqlDatabase db = QSqlDatabase::database();
+    QSqlQuery query(db);
+
+    // A new key can be the old key of another row: those rows are moved
+    // out of the way first, the others go to their new key at once
+    QSet<qint64> oldKeys;
+    for (const QPair<qint64, qint64> &change : keyChanges) {
+        oldKeys.insert(change.first);
+    }
+
+    auto move = [&query](qint64 from, qint64 to) {
+        query.bindValue(0, to);
+        query.bindValue(1, from);
+        return query.exec();
+    };
+
+    db.transaction();
+    query.prepare("UPDATE _search SET rowid = ? WHERE rowid = ?");
+
+    bool isMoved = true;
+    for (int i = 0; i < keyChanges.size() && isMoved; i++) {
+        const QPair<qint64, qint64> &change = keyChanges.at(i);
+        isMoved = oldKeys.contains(change.second) ? move(change.first, remapKeyBase + i) : move(change.first, change.second);
+    }
+    for (int i = 0; i < keyChanges.size() && isMoved; i++) {
+        const QPair<qint64, qint64> &change = keyChanges.at(i);
+        if (oldKeys.contains(change.second)) {
+            isMoved = move(remapKeyBase + i, change.second);
+        }
+    }
+
+    if (!isMoved) {
+        this->buildError = query.lastError().text();
+        db.rollback();
+        this->isIndexReady = false;
+        return false;
+    }
+
+    if (!stamp.isEmpty()) {
+        query.prepare("INSERT INTO _config(_key, value) VALUES('search_stamp', :stamp) ON CONFLICT(_key) DO UPDATE SET value = :stamp WHERE _key = 'search_stamp'");
+        query.bindValue(":stamp", stamp);
+        query.exec();
+    }
+
+    if (!db.commit()) {
+        this->buildError = db.lastError().text();
+        this->isIndexReady = false;
+        return false;
+    }
+
+    this->currentStamp = stamp;
+    this->builtStamp = stamp;
+
+    return true;
+}
+
+void SearchIndex::applyUpdate(const PendingUpdate &update)
+{
+    TraceSpan span("search update");
+
+    QSqlDatabase db = QSqlDatabase::database();
+    QSqlQuery query(db);
+
+    // Index no longer matches the file as saved on disk
+    if (!this->builtStamp.isEmpty()) {
+        query.exec("DELETE FROM _config WHERE _key = 'search_stamp'");
+        this->builtStamp = "";
+    }
+
+    query.prepare("DELETE FROM _search WHERE rowid = ?");
+    query.bindValue(0, update.oldKey);
+    query.exec();
+
+    if (update.values.isEmpty()) {
+        return;
+    }
+
+    query.prepare("INSERT INTO _search(rowid, term, original_term, definition, original_definition, source) VALUES (?, ?, ?, ?, ?, ?)");
+    query.bindValue(0, update.newKey);
+    for (int column = 0; column < JsonLinesModel::ColumnCount; column++) {
+        query.bindValue(column + 1, update.values.value(column));
+    }
+    query.exec();
+}
+
+QVector<qint64> SearchIndex::search(const QString &text, QString *error)
+{
+    TraceSpan span("search query");
+
+    QVector<qint64> keys;
+    QString match = matchQuery(text);
+
+    if (match.isEmpty()) {
+        return keys;
+    }
+
+    // Stale or partly built table
+    if (!this->isIndexReady) {
+        *error = this->buildError.isEmpty() ? "Search index is not built" : this->buildError;
+        return keys;
+    }
+
+    QSqlQuery query(QSqlDatabase::database());
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT rowid FROM _search WHERE _search MATCH ? ORDER BY rowid LIMIT %1").arg(maxResults));
+    query.bindValue(0, match);
+
+    if (!query.exec()) {
+        *error = query.lastError().databaseText();
+        return keys;
+    }
+
+    while (query.next()) {
+        keys.append(query.value(0).toLongLong());
+    }
+
+    return keys;
+}
@@ -0,0 +1,88 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+#include "jsonlinesmodel.h"
+
+// Full-text index of the opened file in the cache database (SQLite FTS5
+// table _search, rowid is JsonLinesModel::rowKey()). The index is built on
+// a worker thread with its own connection. Row updates made while it is
+// being built are queued and applied after. An index built for the same
+// unchanged file is reused, see stamp(). After a save the rows keep their
+// entries under the new keys, see remapKeys(). A failed or canceled build
+// leaves nothing to search until the next build succeeds.
+class SearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int batchSize = 10000;
+    static const int maxResults = 100000;
+    // Each remapped key is a delete and insert of the FTS5 row, more key
+    // changes than this are faster rebuilt in background
+    static const int maxRemapKeys = 20000;
+
+    SearchIndex(const QString &databasePath, QObject *parent = nullptr);
+    ~SearchIndex();
+
+    // Builds the index unless it was built for this stamp already
+    void rebuild(const QString &stamp, const JsonLinesModel::Snapshot &snapshot);
+    void cancel();
+    bool isBuilding() const;
+    // Built and up to date with the row updates
+    bool isReady() const;
+    QString errorString() const;
+
+    void updateRow(qint64 oldKey, qint64 newKey, const QStringList &values);
+    void removeRow(qint64 key);
+    void removeRows(const QVector<qint64> &keys);
+    // New rows, values[i] for keys[i]
+    void addRows(const QVector<qint64> &keys, const QVector<QStringList> &values);
+    // Moves entries from the first key of each pair to the second one and
+    // marks the index as built for stamp. False when there is no index to
+    // remap or more than maxRemapKeys changes, rebuild() it then.
+    bool remapKeys(const QString &stamp, const QVector<QPair<qint64, qint64>> &keyChanges);
+
+    // Row keys matching every word of text as a prefix, in rowid order
+    QVector<qint64> search(const QString &text, QString *error);
+
+    static QString stamp(const QString &filePath);
+    static QString matchQuery(const QString &text);
+
+signals:
+    void buildFinished(bool isBuilt, int rowCount, qint64 elapsedMs);
+
+private:
+    struct PendingUpdate {
+        qint64 oldKey;
+        qint64 newKey;
+        QStringList values;     // empty for removed rows
+    };
+
+    static bool build(const QString &databasePath, const QString &stamp, const JsonLinesModel::Snapshot &snapshot,
+                      QAtomicInt *isCanceled, QString *error);
+    void builderFinished();
+    void applyUpdate(const PendingUpdate &update);
+    void stopBuilder();
+
+    QString databasePath;
+    QString currentStamp;
+    QString builtStamp;
+
+    QThread *builderThread = nullptr;
+    int buildId = 0;
+    QAtomicInt isCanceled;
+    bool isBuilt = false;
+    bool isIndexReady = false;
+    int builtRows = 0;
+    qint64 buildMs = 0;
+    QString buildError;
+    QVector<PendingUpdate> pendingUpdates;
+};
+
+#endif // SEARCHINDEX_H
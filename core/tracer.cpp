@@ -0,0 +1,190 @@
+#include "tracer.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+
+#include <algorithm>
+
+struct TraceRing {
+    QMutex mutex;
+    QVector<Tracer::Event> events;
+    int next = 0;               // slot of the next event once full
+};
+
+static TraceRing &traceRing()
+{
+    static TraceRing ring;
+    return ring;
+}
+
+static QAtomicInt traceEnabled(1);
+
+qint64 Tracer::now()
+{
+    static const QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+
+    return clock.nsecsElapsed();
+}
+
+void Tracer::record(const char *name, qint64 start, qint64 duration)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    Event event = {name, start, duration, quintptr(QThread::currentThreadId())};
+    TraceRing &ring = traceRing();
+    QMutexLocker locker(&ring.mutex);
+
+    if (ring.events.size() < capacity) {
+        ring.events.append(event);
+    } else {
+        ring.events[ring.next] = event;
+        ring.next = (ring.next + 1) % capacity;
+    }
+}
+
+void Tracer::setEnabled(bool isEnabled)
+{
+    traceEnabled.storeRelaxed(isEnabled ? 1 : 0);
+}
+
+bool Tracer::isEnabled()
+{
+    return traceEnabled.loadRelaxed() != 0;
+}
+
+void Tracer::clear()
+{
+    TraceRing &ring = traceRing();
+    QMutexLocker locker(&ring.mutex);
+
+    ring.events.clear();
+    ring.next = 0;
+}
+
+QVector<Tracer::Event> Tracer::events(qint64 since)
+{
+    TraceRing &ring = traceRing();
+    QVector<Event> events;
+
+    {
+        QMutexLocker locker(&ring.mutex);
+        events.reserve(ring.events.size());
+        // Oldest first
+        for (int i = 0; i < ring.events.size(); i++) {
+            const Event &event = ring.events.at((ring.next + i) % ring.events.size());
+            if (event.start >= since) {
+                events.append(event);
+            }
+        }
+    }
+
+    return events;
+}
+
+QVector<Tracer::Summary> Tracer::summarize(qint64 since)
+{
+    QVector<Summary> summaries;
+    QHash<const char *, int> index;
+
+    for (const Event &event : events(since)) {
+        int i = index.value(event.name, -1);
+        if (i < 0) {
+            i = summaries.size();
+            index.insert(event.name, i);
+            summaries.append(Summary());
+            summaries[i].name = event.name;
+        }
+
+        Summary &summary = summaries[i];
+        summary.count++;
+        summary.total += event.duration;
+        summary.max = qMax(summary.max, event.duration);
+    }
+
+    std::sort(summaries.begin(), summaries.end(), [](const Summary &a, const Summary &b) {
+        return a.total > b.total;
+    });
+
+    return summaries;
+}
+
+QString Tracer::summaryText(qint64 since)
+{
+    QStringList parts;
+
+    for (const Summary &summary : summarize(since)) {
+        QString part = QString("%1 %2 ms").arg(QString::fromLatin1(summary.name)).arg(summary.total / 1e6, 0, 'f', 1);
+        if (summary.count > 1) {
+            part += QString(" (%1x, max %2 ms)").arg(summary.count).arg(summary.max / 1e6, 0, 'f', 1);
+        }
+        parts.append(part);
+    }
+
+    return parts.join(", ");
+}
+
+bool Tracer::writeChromeTrace(const QString &filePath, QString *error)
+{
+    QVector<Event> events = Tracer::events();
+    QJsonArray traceEvents;
+
+    // Small thread ids in order of appearance, the caller's thread is main
+    QHash<quintptr, int> threadIds;
+    threadIds.insert(quintptr(QThread::currentThreadId()), 1);
+
+    for (const Event &event : events) {
+        if (!threadIds.contains(event.thread)) {
+            threadIds.insert(event.thread, threadIds.size() + 1);
+        }
+
+        QJsonObject object;
+        object.insert("name", QString::fromLatin1(event.name));
+        object.insert("cat", "jsonlines");
+        object.insert("ph", "X");
+        object.insert("ts", event.start / 1000.0);
+        object.insert("dur", event.duration / 1000.0);
+        object.insert("pid", 1);
+        object.insert("tid", threadIds.value(event.thread));
+        traceEvents.append(object);
+    }
+
+    for (auto it = threadIds.constBegin(); it != threadIds.constEnd(); ++it) {
+        QJsonObject args;
+        args.insert("name", it.value() == 1 ? QString("main") : QString("worker %1").arg(it.value() - 1));
+
+        QJsonObject object;
+        object.insert("name", "thread_name");
+        object.insert("ph", "M");
+        object.insert("pid", 1);
+        object.insert("tid", it.value());
+        object.insert("args", args);
+        traceEvents.append(object);
+    }
+
+    QJsonObject trace;
+    trace.insert("traceEvents", traceEvents);
+    trace.insert("displayTimeUnit", "ms");
+
+    QSaveFile file(filePath);
+    QByteArray json = QJsonDocument(trace).toJson(QJsonDocument::Compact);
+
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        *error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QVector>
+
+// Lightweight timing spans for the hot paths. A TraceSpan reads a
+// monotonic clock when created and appends one event to a bounded ring
+// when destroyed, cheap enough to stay on in release builds. Events can be
+// summarized per name or written as Chrome trace-event JSON (load it in
+// chrome://tracing or Perfetto). Span names must be string literals.
+class Tracer
+{
+public:
+    struct Event {
+        const char *name;
+        qint64 start;           // ns since the first trace clock read
+        qint64 duration;        // ns
+        quintptr thread;
+    };
+
+    struct Summary {
+        const char *name;
+        int count = 0;
+        qint64 total = 0;       // ns, spans on several threads add up
+        qint64 max = 0;
+    };
+
+    static const int capacity = 65536;  // newest events are kept
+
+    static qint64 now();
+    static void record(const char *name, qint64 start, qint64 duration);
+    static void setEnabled(bool isEnabled);
+    static bool isEnabled();
+    static void clear();
+
+    static QVector<Event> events(qint64 since = 0);
+    // Sorted by total time, longest first
+    static QVector<Summary> summarize(qint64 since = 0);
+    static QString summaryText(qint64 since = 0);
+    static bool writeChromeTrace(const QString &filePath, QString *error);
+};
+
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+        : name(name)
+        , start(Tracer::isEnabled() ? Tracer::now() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (this->start >= 0) {
+            Tracer::record(this->name, this->start, Tracer::now() - this->start);
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    const char *name;
+    qint64 start;
+};
+
+#endif // TRACER_H
@@ -0,0 +1,6 @@
+TARGET = tst_compressed
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_compressed.cpp
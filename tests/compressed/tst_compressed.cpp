@@ -0,0 +1,256 @@
+// Reads of compressed data across checkpoints: the blocks CompressedWriter
+// writes, windows inside one gzip member and a single zstd frame, and rows
+// of a compressed file whose lines straddle the written blocks.
+
+#include "core/compressedsource.h"
+#include "core/compressedwriter.h"
+#include "core/jsonlinesmodel.h"
+#include "core/jsonlineswriter.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <algorithm>
+
+#include <zlib.h>
+#include <zstd.h>
+
+// Three and a half written blocks
+static const int rowCount = 56000;
+
+static QStringList rowValues(int row)
+{
+    QString definition = QString("definition of %1 ").arg(row).repeated(1 + row % 13).trimmed();
+    return {QString("term %1").arg(row), QString("Begriff %1").arg(row), definition, QString::fromUtf8("Erklärung %1").arg(row), "test"};
+}
+
+static QByteArray compress(CompressedSource::Format format, const QByteArray &data, QVector<CompressedSource::Checkpoint> *checkpoints)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    CompressedWriter writer(&buffer, format);
+    writer.open(QIODevice::WriteOnly);
+    if (writer.write(data) != data.size() || !writer.finish()) {
+        return QByteArray();
+    }
+
+    *checkpoints = writer.checkpoints();
+    return buffer.data();
+}
+
+// One gzip member, as gzip itself writes
+static QByteArray gzipMember(const QByteArray &data)
+{
+    z_stream stream = {};
+    if (deflateInit2(&stream, 6, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return QByteArray();
+    }
+
+    QByteArray out(int(deflateBound(&stream, uLong(data.size()))), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    stream.avail_in = uInt(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = uInt(out.size());
+
+    int status = deflate(&stream, Z_FINISH);
+    out.resize(int(stream.total_out));
+    deflateEnd(&stream);
+
+    return status == Z_STREAM_END ? out : QByteArray();
+}
+
+static QByteArray zstdFrame(const QByteArray &data)
+{
+    QByteArray out(int(ZSTD_compressBound(size_t(data.size()))), '\0');
+    size_t length = ZSTD_compress(out.data(), size_t(out.size()), data.constData(), size_t(data.size()), 3);
+    if (ZSTD_isError(length)) {
+        return QByteArray();
+    }
+
+    out.resize(int(length));
+    return out;
+}
+
+class TestCompressed : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void readWrittenBlocks_data();
+    void readWrittenBlocks();
+    void readInsideGzipMember();
+    void readSingleZstdFrame();
+    void loadRowsAcrossBlocks_data();
+    void loadRowsAcrossBlocks();
+
+private:
+    // Reads around every offset, compared with the plain data
+    void compareAround(const CompressedSource &source, const QVector<qint64> &offsets);
+
+    QTemporaryDir dir;
+    QString plainPath;
+    QByteArray plain;
+    QVector<qint64> lineStarts;
+};
+
+void TestCompressed::initTestCase()
+{
+    QVERIFY(this->dir.isValid());
+    this->plainPath = this->dir.filePath("rows.jsonl");
+
+    QFile file(this->plainPath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+
+    JsonLinesWriter writer(&file, JsonLinesModel::fieldKeys());
+    for (int row = 0; row < rowCount; row++) {
+        this->lineStarts.append(writer.pos());
+        QVERIFY(writer.writeRow(rowValues(row)) >= 0);
+    }
+    QVERIFY(writer.flush());
+    file.close();
+
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    this->plain = file.readAll();
+    QVERIFY(this->plain.size() > 3 * CompressedWriter::blockSize);
+}
+
+void TestCompressed::compareAround(const CompressedSource &source, const QVector<qint64> &offsets)
+{
+    for (qint64 offset : offsets) {
+        for (qint64 begin : {offset - 1000, offset - 1, offset}) {
+            if (begin < 0 || begin >= this->plain.size()) {
+                continue;
+            }
+            qint64 length = qMin<qint64>(2000, this->plain.size() - begin);
+            QCOMPARE(source.read(begin, length), this->plain.mid(int(begin), int(length)));
+        }
+    }
+
+    // The whole data at once, across all checkpoints
+    QCOMPARE(source.read(0, this->plain.size()), this->plain);
+}
+
+void TestCompressed::readWrittenBlocks_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QString>("open");
+
+    QTest::newRow("gzip build") << int(CompressedSource::Gzip) << "build";
+    QTest::newRow("gzip index") << int(CompressedSource::Gzip) << "index";
+    QTest::newRow("zstd build") << int(CompressedSource::Zstd) << "build";
+    QTest::newRow("zstd index") << int(CompressedSource::Zstd) << "index";
+    QTest::newRow("zstd seekable") << int(CompressedSource::Zstd) << "seekable";
+}
+
+void TestCompressed::readWrittenBlocks()
+{
+    QFETCH(int, format);
+    QFETCH(QString, open);
+
+    QVector<CompressedSource::Checkpoint> checkpoints;
+    QByteArray data = compress(CompressedSource::Format(format), this->plain, &checkpoints);
+    QVERIFY(!data.isEmpty());
+    QCOMPARE(checkpoints.size(), int((this->plain.size() + CompressedWriter::blockSize - 1) / CompressedWriter::blockSize));
+
+    CompressedSource source(CompressedSource::Format(format), data.constData(), data.size());
+    QString error;
+
+    if (open == "build") {
+        qint64 built = 0;
+        QVERIFY2(source.build([&built](const char *, qint64 length, qint64) {
+            built += length;
+            return true;
+        }, &error), qPrintable(error));
+        QCOMPARE(built, qint64(this->plain.size()));
+    } else if (open == "index") {
+        source.setIndex(checkpoints, this->plain.size());
+    } else {
+        QVERIFY(source.openSeekable());
+    }
+
+    QCOMPARE(source.size(), qint64(this->plain.size()));
+
+    QVector<qint64> offsets;
+    for (const CompressedSource::Checkpoint &checkpoint : checkpoints) {
+        offsets.append(checkpoint.out);
+    }
+    this->compareAround(source, offsets);
+}
+
+void TestCompressed::readInsideGzipMember()
+{
+    QByteArray data = gzipMember(this->plain);
+    QVERIFY(!data.isEmpty());
+
+    CompressedSource source(CompressedSource::Gzip, data.constData(), data.size());
+    QString error;
+    QVERIFY2(source.build([](const char *, qint64, qint64) { return true; }, &error), qPrintable(error));
+
+    // Windowed checkpoints are near every spanSize, read around those and
+    // at odd offsets between them
+    QVector<qint64> offsets;
+    for (qint64 offset = CompressedSource::spanSize; offset < this->plain.size(); offset += CompressedSource::spanSize) {
+        offsets.append(offset);
+        offsets.append(offset + 65537);
+    }
+    offsets.append(this->plain.size() - 1);
+    this->compareAround(source, offsets);
+}
+
+void TestCompressed::readSingleZstdFrame()
+{
+    QByteArray data = zstdFrame(this->plain);
+    QVERIFY(!data.isEmpty());
+
+    CompressedSource source(CompressedSource::Zstd, data.constData(), data.size());
+    QVERIFY(!source.openSeekable());
+
+    QString error;
+    QVERIFY2(source.build([](const char *, qint64, qint64) { return true; }, &error), qPrintable(error));
+
+    QVector<qint64> offsets;
+    for (qint64 offset = CompressedSource::blockSize; offset < this->plain.size(); offset += CompressedSource::blockSize) {
+        offsets.append(offset);
+    }
+    this->compareAround(source, offsets);
+}
+
+void TestCompressed::loadRowsAcrossBlocks_data()
+{
+    QTest::addColumn<QString>("fileName");
+
+    QTest::newRow("gzip") << "rows.jsonl.gz";
+    QTest::newRow("zstd") << "rows.jsonl.zst";
+}
+
+void TestCompressed::loadRowsAcrossBlocks()
+{
+    QFETCH(QString, fileName);
+
+    QString filePath = this->dir.filePath(fileName);
+
+    JsonLinesModel model;
+    QVERIFY2(model.load(this->plainPath), qPrintable(model.errorString()));
+    QVERIFY2(model.save(filePath), qPrintable(model.errorString()));
+    QVERIFY2(model.load(filePath), qPrintable(model.errorString()));
+    QCOMPARE(model.rowCount(), rowCount);
+
+    // Rows around the lines that cross a block end, and the first and last
+    QVector<int> rows = {0, rowCount - 1};
+    for (qint64 end = CompressedWriter::blockSize; end < this->plain.size(); end += CompressedWriter::blockSize) {
+        int row = int(std::upper_bound(this->lineStarts.begin(), this->lineStarts.end(), end) - this->lineStarts.begin()) - 1;
+        rows.append({row - 1, row, row + 1});
+    }
+
+    for (int row : rows) {
+        QCOMPARE(model.rowValues(row).mid(0, JsonLinesModel::ColumnCount), rowValues(row));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestCompressed)
+
+#include "tst_compressed.moc"
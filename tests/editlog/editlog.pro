@@ -0,0 +1,6 @@
+TARGET = tst_editlog
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_editlog.cpp
@@ -0,0 +1,268 @@
+// EditLog entries as written and read back, undone steps as their inverse,
+// replayed on the file they were logged against, and refused once the file
+// is changed.
+
+#include "core/editlog.h"
+#include "core/jsonlinesmodel.h"
+
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QTemporaryDir>
+#include <QtTest>
+
+static const QByteArray appleLine = R"({"definition":"a fruit","original_definition":"eine Frucht","original_term":"Apfel","source":"wiki","term":"apple"})";
+static const QByteArray bankLine = R"({"definition":"river side","original_definition":"Ufer","original_term":"Bank","source":"dict","term":"bank"})";
+static const QByteArray catLine = R"({"definition":"animal","original_definition":"Tier","original_term":"Katze","source":"wiki","term":"cat"})";
+
+static bool writeFile(const QString &filePath, const QByteArray &data, QIODevice::OpenMode mode = QIODevice::WriteOnly)
+{
+    QFile file(filePath);
+    return file.open(mode) && file.write(data) == data.size();
+}
+
+static QByteArray readFile(const QString &filePath)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+static EditHistory::Edit setField(int row, int column, const QString &oldText, const QString &newText)
+{
+    EditHistory::Edit edit;
+    edit.type = EditHistory::Edit::SetField;
+    edit.row = row;
+    edit.column = column;
+    edit.oldText = oldText;
+    edit.newText = newText;
+    return edit;
+}
+
+static EditHistory::Edit rowEdit(EditHistory::Edit::Type type, int row, const QStringList &values)
+{
+    EditHistory::Edit edit;
+    edit.type = type;
+    edit.row = row;
+    edit.content.values = values;
+    return edit;
+}
+
+// Entries applied as the editor does on recovery
+static void replay(JsonLinesModel *model, const QVector<EditHistory::Edit> &edits)
+{
+    for (const EditHistory::Edit &edit : edits) {
+        switch (edit.type) {
+        case EditHistory::Edit::SetField: {
+            QStringList values = model->rowValues(edit.row).mid(0, JsonLinesModel::ColumnCount);
+            values[edit.column] = edit.newText;
+            model->setRowValues(edit.row, values);
+            break;
+        }
+        case EditHistory::Edit::InsertRow:
+            model->insertRowContents({edit.row}, {edit.content});
+            break;
+        case EditHistory::Edit::RemoveRow:
+            model->removeRows(edit.row, 1);
+            break;
+        }
+    }
+}
+
+class TestEditLog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void appendReadReplay();
+    void changedFile();
+    void startAndStop();
+
+private:
+    // Logs the edits of appendReadReplay() for filePath
+    void logEdits(EditLog *log, const QString &filePath);
+
+    QTemporaryDir dir;
+    QString filePath;
+    QByteArray data;
+};
+
+void TestEditLog::initTestCase()
+{
+    QVERIFY(this->dir.isValid());
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+    db.setDatabaseName(this->dir.filePath("cache.db"));
+    QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+
+    EditLog log;
+    QString error;
+    QVERIFY2(log.open(&error), qPrintable(error));
+
+    this->filePath = this->dir.filePath("rows.jsonl");
+    this->data = appleLine + "\n" + bankLine + "\n" + catLine + "\n";
+}
+
+void TestEditLog::cleanupTestCase()
+{
+    QSqlDatabase::database().close();
+}
+
+void TestEditLog::logEdits(EditLog *log, const QString &filePath)
+{
+    using Edit = EditHistory::Edit;
+
+    QString error;
+    QVERIFY2(log->start(filePath, &error), qPrintable(error));
+
+    QStringList eel = {"eel", "Aal", "a fish", "ein Fisch", "user"};
+    QStringList cat = {"cat", "Katze", "animal", "Tier", "wiki"};
+    QVector<Edit> fields = {
+        setField(2, JsonLinesModel::ColumnTerm, "bank", "shore"),
+        setField(2, JsonLinesModel::ColumnDefinition, "river side", "edge")
+    };
+
+    // Steps, and undo in reverse step order
+    log->append({setField(0, JsonLinesModel::ColumnTerm, "apple", "apricot")});
+    log->append({rowEdit(Edit::InsertRow, 1, eel)});
+    log->append({rowEdit(Edit::RemoveRow, 3, cat)});
+    log->append({rowEdit(Edit::RemoveRow, 3, cat)}, true);
+    log->append(fields);
+    log->append(fields, true);
+    log->append({rowEdit(Edit::InsertRow, 1, eel)}, true);
+
+    QCOMPARE(log->pendingCount(), 9);
+    QVERIFY2(log->flush(&error), qPrintable(error));
+    QCOMPARE(log->pendingCount(), 0);
+}
+
+void TestEditLog::appendReadReplay()
+{
+    using Edit = EditHistory::Edit;
+
+    QVERIFY(writeFile(this->filePath, this->data));
+
+    EditLog log;
+    this->logEdits(&log, this->filePath);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+    QCOMPARE(log.loggedFiles(), QStringList(this->filePath));
+
+    QVector<Edit> edits;
+    QString error;
+    QVERIFY2(log.read(this->filePath, &edits, &error), qPrintable(error));
+    QCOMPARE(edits.size(), 9);
+
+    // Undone steps are logged as what they do, edits of a step backwards
+    struct Expected {
+        Edit::Type type;
+        int row;
+        int column;
+        QString text;           // new text, or term of the inserted row
+    };
+    QVector<Expected> expected = {
+        {Edit::SetField, 0, JsonLinesModel::ColumnTerm, "apricot"},
+        {Edit::InsertRow, 1, 0, "eel"},
+        {Edit::RemoveRow, 3, 0, QString()},
+        {Edit::InsertRow, 3, 0, "cat"},
+        {Edit::SetField, 2, JsonLinesModel::ColumnTerm, "shore"},
+        {Edit::SetField, 2, JsonLinesModel::ColumnDefinition, "edge"},
+        {Edit::SetField, 2, JsonLinesModel::ColumnDefinition, "river side"},
+        {Edit::SetField, 2, JsonLinesModel::ColumnTerm, "bank"},
+        {Edit::RemoveRow, 1, 0, QString()}
+    };
+
+    for (int i = 0; i < edits.size(); i++) {
+        const Edit &edit = edits.at(i);
+        QCOMPARE(int(edit.type), int(expected.at(i).type));
+        QCOMPARE(edit.row, expected.at(i).row);
+        if (edit.type == Edit::SetField) {
+            QCOMPARE(edit.column, expected.at(i).column);
+            QCOMPARE(edit.newText, expected.at(i).text);
+        } else if (edit.type == Edit::InsertRow) {
+            QCOMPARE(edit.content.values.size(), int(JsonLinesModel::ColumnCount));
+            QCOMPARE(edit.content.values.first(), expected.at(i).text);
+        }
+    }
+
+    // Replayed on the file, only the first term is left changed
+    JsonLinesModel model;
+    QVERIFY2(model.load(this->filePath), qPrintable(model.errorString()));
+    replay(&model, edits);
+    QCOMPARE(model.rowCount(), 3);
+
+    QString savedPath = this->dir.filePath("replayed.jsonl");
+    QVERIFY2(model.save(savedPath), qPrintable(model.errorString()));
+
+    QByteArray replayed = this->data;
+    replayed.replace(R"("term":"apple")", R"("term":"apricot")");
+    QCOMPARE(readFile(savedPath), replayed);
+}
+
+void TestEditLog::changedFile()
+{
+    QVERIFY(writeFile(this->filePath, this->data));
+
+    EditLog log;
+    this->logEdits(&log, this->filePath);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    QVector<EditHistory::Edit> edits;
+    QString error;
+
+    // Lines appended after the base move no row
+    QVERIFY(writeFile(this->filePath, catLine + "\n", QIODevice::Append));
+    QVERIFY2(log.read(this->filePath, &edits, &error), qPrintable(error));
+    QCOMPARE(edits.size(), 9);
+
+    // A changed base cannot be replayed
+    QByteArray changed = this->data;
+    changed.replace("apple", "apfle");
+    QVERIFY(writeFile(this->filePath, changed));
+    edits.clear();
+    QVERIFY(!log.read(this->filePath, &edits, &error));
+    QCOMPARE(error, QString("File was changed since it was edited"));
+
+    // So cannot a shorter file
+    QVERIFY(writeFile(this->filePath, appleLine + "\n"));
+    QVERIFY(!log.read(this->filePath, &edits, &error));
+}
+
+void TestEditLog::startAndStop()
+{
+    QVERIFY(writeFile(this->filePath, this->data));
+
+    EditLog log;
+    this->logEdits(&log, this->filePath);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    // Starting again drops the entries
+    QVector<EditHistory::Edit> edits;
+    QString error;
+    QVERIFY2(log.start(this->filePath, &error), qPrintable(error));
+    QVERIFY2(log.read(this->filePath, &edits, &error), qPrintable(error));
+    QVERIFY(edits.isEmpty());
+
+    // Resumed entries add to the logged ones
+    EditLog resumed;
+    resumed.resume(this->filePath);
+    resumed.append({setField(1, JsonLinesModel::ColumnSource, "dict", "book")});
+    QVERIFY2(resumed.flush(&error), qPrintable(error));
+    edits.clear();
+    QVERIFY2(log.read(this->filePath, &edits, &error), qPrintable(error));
+    QCOMPARE(edits.size(), 1);
+
+    resumed.stop();
+    QVERIFY(resumed.loggedFiles().isEmpty());
+    QVERIFY(!log.read(this->filePath, &edits, &error));
+}
+
+QTEST_GUILESS_MAIN(TestEditLog)
+
+#include "tst_editlog.moc"
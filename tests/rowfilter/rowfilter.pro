@@ -0,0 +1,6 @@
+TARGET = tst_rowfilter
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_rowfilter.cpp
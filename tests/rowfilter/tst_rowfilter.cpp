@@ -0,0 +1,189 @@
+// RowFilter queries: what they match, the errors of bad ones, and the bit
+// shifting used when rows are removed or inserted under a filter.
+
+#include "core/jsonlinesmodel.h"
+#include "core/rowfilter.h"
+
+#include <QRandomGenerator>
+#include <QtTest>
+
+#include <algorithm>
+
+class TestRowFilter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matches_data();
+    void matches();
+    void errors_data();
+    void errors();
+    void blankIsEmpty();
+    void removeAndInsertBits_data();
+    void removeAndInsertBits();
+};
+
+static const QStringList appleRow = {"apple", "Apfel", "a fruit", "", "wiki"};
+
+void TestRowFilter::matches_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<bool>("isMatch");
+
+    QTest::newRow("contains") << "term contains app" << true;
+    QTest::newRow("contains ignores case") << "term contains APP" << true;
+    QTest::newRow("contains quoted") << "definition contains \"a fr\"" << true;
+    QTest::newRow("equals") << "term = apple" << true;
+    QTest::newRow("equals is exact") << "term = Apple" << false;
+    QTest::newRow("not equals") << "term != apple" << false;
+    QTest::newRow("regex") << "source ~ /w.k/" << true;
+    QTest::newRow("matches") << "original_term matches \"^Ap\"" << true;
+    QTest::newRow("regex escaped slash") << "definition ~ /a\\/b/" << false;
+    QTest::newRow("is empty") << "original_definition is empty" << true;
+    QTest::newRow("is not empty") << "term is not empty" << true;
+    QTest::newRow("length less") << "len(definition) < 8" << true;
+    QTest::newRow("length greater equal") << "len(term) >= 5" << true;
+    QTest::newRow("length not equal") << "len(term) != 5" << false;
+    QTest::newRow("and") << "term = apple and source = wiki" << true;
+    QTest::newRow("or") << "term = pear or term = apple" << true;
+    QTest::newRow("and binds stronger") << "term = pear or term = apple and source = dict" << false;
+    QTest::newRow("parentheses") << "(term = pear or term = apple) and source = wiki" << true;
+    QTest::newRow("not") << "not (term contains x) and not source = dict" << true;
+    QTest::newRow("keywords ignore case") << "term CONTAINS app AND source IS NOT EMPTY" << true;
+    QTest::newRow("quoted column") << "\"term\" = apple" << true;
+}
+
+void TestRowFilter::matches()
+{
+    QFETCH(QString, query);
+    QFETCH(bool, isMatch);
+
+    RowFilter filter;
+    QString error;
+    QVERIFY2(filter.parse(query, JsonLinesModel::fieldKeys(), &error), qPrintable(error));
+    QVERIFY(!filter.isEmpty());
+    QCOMPARE(filter.text(), query);
+    QCOMPARE(filter.matches(appleRow), isMatch);
+}
+
+void TestRowFilter::errors_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QString>("message");
+
+    QTest::newRow("unterminated string") << "term = \"abc" << "Unterminated string at 8";
+    QTest::newRow("unterminated regex") << "term ~ /abc" << "Unterminated regular expression at 8";
+    QTest::newRow("unexpected character") << "term # a" << "Unexpected \"#\" at 6";
+    QTest::newRow("trailing word") << "term = a b" << "Expected and, or or end at 10";
+    QTest::newRow("unclosed parenthesis") << "(term = a" << "Expected ) at end";
+    QTest::newRow("missing column") << "= a" << "Expected column at 1";
+    QTest::newRow("unknown column") << "note contains a" << "Unknown column \"note\" at 1";
+    QTest::newRow("missing text") << "term contains" << "Expected text at end";
+    QTest::newRow("missing operator") << "term" << "Expected contains, matches, ~, =, != or is at end";
+    QTest::newRow("bad operator") << "term < a" << "Expected contains, matches, ~, =, != or is at 6";
+    QTest::newRow("missing empty") << "term is full" << "Expected empty at 9";
+    QTest::newRow("length without parenthesis") << "len term" << "Expected ( at 5";
+    QTest::newRow("length without comparison") << "len(term) contains 3" << "Expected comparison at 11";
+    QTest::newRow("length not a number") << "len(term) < x" << "Expected length at 13";
+    QTest::newRow("negative length") << "len(term) < -1" << "Expected length at 13";
+    QTest::newRow("missing operand") << "term = a and" << "Expected column at end";
+    QTest::newRow("invalid regex") << "term ~ /(/" << "Invalid regular expression at 6";
+}
+
+void TestRowFilter::errors()
+{
+    QFETCH(QString, query);
+    QFETCH(QString, message);
+
+    RowFilter filter;
+    QString error;
+    QVERIFY(!filter.parse(query, JsonLinesModel::fieldKeys(), &error));
+    QVERIFY2(error.startsWith(message), qPrintable(error));
+
+    // A failed parse leaves the empty filter
+    QVERIFY(filter.isEmpty());
+    QVERIFY(filter.matches(appleRow));
+}
+
+void TestRowFilter::blankIsEmpty()
+{
+    RowFilter filter;
+    QString error;
+
+    QVERIFY(filter.parse("term = pear", JsonLinesModel::fieldKeys(), &error));
+    QVERIFY(filter.parse("   ", JsonLinesModel::fieldKeys(), &error));
+    QVERIFY(filter.isEmpty());
+    QVERIFY(filter.matches(appleRow));
+}
+
+void TestRowFilter::removeAndInsertBits_data()
+{
+    QTest::addColumn<int>("bitCount");
+    QTest::addColumn<int>("changeCount");
+
+    QTest::newRow("none") << 100 << 0;
+    QTest::newRow("inside a word") << 50 << 7;
+    QTest::newRow("across words") << 1000 << 90;
+    QTest::newRow("most rows") << 300 << 280;
+}
+
+void TestRowFilter::removeAndInsertBits()
+{
+    QFETCH(int, bitCount);
+    QFETCH(int, changeCount);
+
+    QRandomGenerator random(uint(bitCount * 31 + changeCount));
+
+    QVector<bool> reference;
+    RowFilter::Bits bits((bitCount + 63) / 64, 0);
+    for (int row = 0; row < bitCount; row++) {
+        reference.append(random.bounded(2) == 1);
+        RowFilter::setBit(bits, row, reference.last());
+    }
+
+    // Remove random rows, ascending
+    QVector<int> removed;
+    for (int row = 0; row < bitCount; row++) {
+        if (int(random.bounded(bitCount)) < changeCount) {
+            removed.append(row);
+        }
+    }
+
+    RowFilter::Bits afterRemove = RowFilter::removeBits(bits, bitCount, removed);
+    for (int i = removed.size() - 1; i >= 0; i--) {
+        reference.remove(removed.at(i));
+    }
+
+    QCOMPARE(afterRemove.size(), (reference.size() + 63) / 64);
+    for (int row = 0; row < reference.size(); row++) {
+        QCOMPARE(RowFilter::testBit(afterRemove, row), reference.at(row));
+    }
+
+    // Insert the same number of rows back at random places, numbered as
+    // after the insertion
+    int count = reference.size();
+    QVector<int> inserted;
+    for (int row = 0; row < count + removed.size(); row++) {
+        if (inserted.size() < removed.size() && int(random.bounded(count + removed.size())) < removed.size() * 2) {
+            inserted.append(row);
+        }
+    }
+
+    RowFilter::Bits insertedBits((inserted.size() + 63) / 64, 0);
+    for (int i = 0; i < inserted.size(); i++) {
+        RowFilter::setBit(insertedBits, i, i % 3 == 0);
+        reference.insert(inserted.at(i), i % 3 == 0);
+    }
+
+    RowFilter::Bits afterInsert = RowFilter::insertBits(afterRemove, count, inserted, insertedBits);
+
+    QCOMPARE(afterInsert.size(), (reference.size() + 63) / 64);
+    for (int row = 0; row < reference.size(); row++) {
+        QCOMPARE(RowFilter::testBit(afterInsert, row), reference.at(row));
+    }
+    QCOMPARE(RowFilter::countBits(afterInsert), int(std::count(reference.begin(), reference.end(), true)));
+}
+
+QTEST_GUILESS_MAIN(TestRowFilter)
+
+#include "tst_rowfilter.moc"
@@ -0,0 +1,6 @@
+TARGET = tst_save
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_save.cpp
@@ -0,0 +1,171 @@
+// Saving keeps unchanged and raw rows byte for byte, writes edited and
+// inserted rows as QJsonDocument would, and saving the saved file again
+// gives the same bytes.
+
+#include "core/jsonlinesloader.h"
+#include "core/jsonlinesmodel.h"
+#include "core/jsonlineswriter.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+static const QByteArray appleLine = R"({"term": "apple", "original_term": "Apfel", "definition": "a fruit", "original_definition": "eine Frucht", "source": "wiki"})";
+static const QByteArray bankLine = R"({"term":"bank","original_term":"Bank","definition":"river side","original_definition":"Ufer","source":"dict","note":"keep"})";
+static const QByteArray badLine = "this is not json";
+static const QByteArray catLine = R"({"term":"cat","original_term":"Katze","definition":"animal","original_definition":"Tier","source":"wiki"})";
+static const QByteArray dogLine = R"({"source":"wiki","term":"dog","original_term":"Hund","definition":"animal é","original_definition":"Tier"})";
+
+static bool writeFile(const QString &filePath, const QByteArray &data)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+static QByteArray readFile(const QString &filePath)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+// Background load keeping bad lines as raw rows
+static bool loadTolerant(JsonLinesModel *model, const QString &filePath)
+{
+    QSignalSpy finished(model, &JsonLinesModel::loadingFinished);
+
+    model->setTolerantLoading(true);
+    if (!model->startLoading(filePath) || !finished.wait(10000)) {
+        return false;
+    }
+
+    return finished.first().first().toInt() == JsonLinesLoader::Loaded;
+}
+
+class TestSave : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void unchangedRowsAreCopied();
+    void editedInsertedRemovedAndRawRows();
+    void writerMatchesJsonDocument_data();
+    void writerMatchesJsonDocument();
+
+private:
+    QTemporaryDir dir;
+};
+
+void TestSave::initTestCase()
+{
+    QVERIFY(this->dir.isValid());
+}
+
+void TestSave::unchangedRowsAreCopied()
+{
+    QString filePath = this->dir.filePath("unchanged.jsonl");
+    QString savedPath = this->dir.filePath("unchanged-saved.jsonl");
+    QByteArray data = appleLine + "\n" + catLine + "\n" + dogLine + "\n";
+
+    QVERIFY(writeFile(filePath, data));
+
+    JsonLinesModel model;
+    QVERIFY2(model.load(filePath), qPrintable(model.errorString()));
+    QCOMPARE(model.rowCount(), 3);
+    QVERIFY2(model.save(savedPath), qPrintable(model.errorString()));
+
+    QCOMPARE(readFile(savedPath), data);
+    QCOMPARE(model.saveStats().copiedRows, 3);
+    QCOMPARE(model.saveStats().copiedBytes, qint64(data.size()));
+    QCOMPARE(model.saveStats().encodedRows, 0);
+}
+
+void TestSave::editedInsertedRemovedAndRawRows()
+{
+    QString filePath = this->dir.filePath("edited.jsonl");
+    QString savedPath = this->dir.filePath("edited-saved.jsonl");
+    QString resavedPath = this->dir.filePath("edited-resaved.jsonl");
+
+    QVERIFY(writeFile(filePath, appleLine + "\n" + bankLine + "\n" + badLine + "\n" + catLine + "\n" + dogLine + "\n"));
+
+    JsonLinesModel model;
+    QVERIFY(loadTolerant(&model, filePath));
+    QCOMPARE(model.rowCount(), 5);
+    QVERIFY(model.isRawRow(2));
+
+    // Edit the row with another key, remove cat, insert a row before the raw one
+    QStringList values = model.rowValues(1).mid(0, JsonLinesModel::ColumnCount);
+    values[JsonLinesModel::ColumnDefinition] = "money place";
+    model.setRowValues(1, values);
+
+    QVERIFY(model.removeRows(3, 1));
+
+    QVERIFY(model.insertRows(2, 1));
+    model.setRowValues(2, {"eel", "Aal", " a fish ", "ein Fisch", "user"});
+
+    QVERIFY2(model.save(savedPath), qPrintable(model.errorString()));
+
+    QByteArray expected = appleLine + "\n"
+            + R"({"definition":"money place","note":"keep","original_definition":"Ufer","original_term":"Bank","source":"dict","term":"bank"})" + "\n"
+            + R"({"definition":"a fish","original_definition":"ein Fisch","original_term":"Aal","source":"user","term":"eel"})" + "\n"
+            + badLine + "\n"
+            + dogLine + "\n";
+
+    QCOMPARE(readFile(savedPath), expected);
+    QCOMPARE(model.saveStats().copiedRows, 3);
+    QCOMPARE(model.saveStats().encodedRows, 2);
+    QCOMPARE(model.saveStats().rawRows, 1);
+
+    // The model now reads the saved file, saving it again changes nothing
+    QCOMPARE(model.rowCount(), 5);
+    QVERIFY(model.isRawRow(3));
+    QCOMPARE(model.rowValues(1).at(JsonLinesModel::ColumnDefinition), QString("money place"));
+
+    QVERIFY2(model.save(resavedPath), qPrintable(model.errorString()));
+    QCOMPARE(readFile(resavedPath), expected);
+    QCOMPARE(model.saveStats().copiedRows, 5);
+    QCOMPARE(model.saveStats().encodedRows, 0);
+}
+
+void TestSave::writerMatchesJsonDocument_data()
+{
+    QTest::addColumn<QString>("value");
+
+    QTest::newRow("plain") << "plain text";
+    QTest::newRow("empty") << "";
+    QTest::newRow("quotes") << "say \"hi\" \\ back/slash";
+    QTest::newRow("control") << QString("tab\tnew\nline\r\b\f") + QChar(0x01) + QChar(0x1f) + QChar(0x7f);
+    QTest::newRow("unicode") << QString::fromUtf8("Größe, 東京, ") + QChar(0x2028) + QChar(0x2029);
+    QTest::newRow("surrogates") << QString::fromUtf8("emoji \xF0\x9F\x98\x80");
+}
+
+void TestSave::writerMatchesJsonDocument()
+{
+    QFETCH(QString, value);
+
+    const QStringList &keys = JsonLinesModel::fieldKeys();
+    QStringList values;
+    QJsonObject object;
+
+    for (int i = 0; i < keys.size(); i++) {
+        values.append(QString("%1 %2").arg(value).arg(i));
+        object.insert(keys.at(i), values.last());
+    }
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+
+    JsonLinesWriter writer(&buffer, keys);
+    QVERIFY(writer.writeRow(values) >= 0);
+    QVERIFY(writer.flush());
+
+    QCOMPARE(buffer.data(), QJsonDocument(object).toJson(QJsonDocument::Compact) + "\n");
+}
+
+QTEST_GUILESS_MAIN(TestSave)
+
+#include "tst_save.moc"
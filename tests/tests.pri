@@ -0,0 +1,12 @@
+# Common settings of the core tests, included by every test target
+
+QT = core testlib sql concurrent
+
+CONFIG += testcase console c++11
+CONFIG -= app_bundle
+
+include($$PWD/../version.pri)
+
+# core is built by jsonlines-editor.pro next to the tests build directory
+CORE_BUILD_DIR = $$OUT_PWD/../../core
+include($$PWD/../core/core.pri)
@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    save \
+    compressed \
+    rowfilter \
+    editlog
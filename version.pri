@@ -0,0 +1,2 @@
+VERSION = 0.1.2
+DEFINES += APP_VERSION=\\\"$$VERSION\\\"